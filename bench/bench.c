@@ -0,0 +1,38 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench.c
+/// \brief helpers shared by the benchmark runners, results are written to stdout as CSV
+// --------------------------------------------------------------------------------------------------------------------
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+
+
+// Statics
+static volatile int64_t bench_sink;
+
+
+// Functions
+uint64_t bench_now_ns(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+void bench_header(int argc, char** argv){
+    // Runners after the first one are started with --no-header, so make bench prints one CSV table
+    if (argc > 1 && strcmp(argv[1], "--no-header") == 0){return;}
+    printf("suite,case,metric,value,unit\n");
+}
+
+void bench_report(const char* suite, const char* name, const char* metric, double value, const char* unit){
+    printf("%s,%s,%s,%.3f,%s\n", suite, name, metric, value, unit);
+}
+
+void bench_consume(int64_t value){
+    bench_sink += value;
+}
@@ -0,0 +1,29 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench.h
+/// \brief host benchmarks for the adxl343 driver
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <stdint.h>
+
+// Helpers
+// - Monotonic host time in nanoseconds
+uint64_t bench_now_ns();
+// - Prints the CSV header, unless the runner was started with --no-header
+void bench_header(int argc, char** argv);
+// - Prints one result line (CSV: suite,case,metric,value,unit)
+void bench_report(const char* suite, const char* name, const char* metric, double value, const char* unit);
+// - Keeps results alive so the compiler can not drop the benchmarked work
+void bench_consume(int64_t value);
+
+// Benchmarks
+void bench_decode();
+void bench_convert();
+void bench_i2c_queue();
+void bench_filter();
+void bench_features();
+void bench_reduce();
+
+#endif /* BENCH_BENCH_H_ */
@@ -0,0 +1,58 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench_convert.c
+/// \brief block conversion cost to milli-g and m/s^2 for FIFO sized and large blocks
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "adxl343_convert.h"
+
+#define BENCH_CONVERT_MAX_SAMPLES 4096
+#define BENCH_CONVERT_TOTAL_SAMPLES (1 << 22)   // Samples converted per measurement, whatever the block size
+
+
+// Statics
+static ADXL343Sample bench_samples [BENCH_CONVERT_MAX_SAMPLES];
+static int32_t bench_mg [3 * BENCH_CONVERT_MAX_SAMPLES];
+static float bench_ms2 [3 * BENCH_CONVERT_MAX_SAMPLES];
+
+static void _bench_convert_block(size_t block){
+    ADXL343Settings settings = {0};
+    settings.range = 0x02;
+    size_t rounds = BENCH_CONVERT_TOTAL_SAMPLES / block;
+    int64_t checksum = 0;
+    char name [32];
+    snprintf(name, sizeof(name), "%s_%zu", ADXL343_CONVERT_SIMD ? "simd" : "auto", block);
+
+    uint64_t start = bench_now_ns();
+    for (size_t round = 0; round < rounds; round++){
+        adxl343_convert_mg(&settings, bench_samples, bench_mg, block);
+        checksum += bench_mg[round % (3 * block)];
+    }
+    double mg_ns = (double) (bench_now_ns() - start) / (rounds * block);
+
+    start = bench_now_ns();
+    for (size_t round = 0; round < rounds; round++){
+        adxl343_convert_ms2(&settings, bench_samples, bench_ms2, block);
+        checksum += (int64_t) bench_ms2[round % (3 * block)];
+    }
+    double ms2_ns = (double) (bench_now_ns() - start) / (rounds * block);
+
+    bench_consume(checksum);
+    bench_report("convert", name, "mg_ns_per_sample", mg_ns, "ns");
+    bench_report("convert", name, "ms2_ns_per_sample", ms2_ns, "ns");
+}
+
+
+// Functions
+void bench_convert(){
+    for (size_t i = 0; i < BENCH_CONVERT_MAX_SAMPLES; i++){
+        bench_samples[i].x = (int16_t) (i % 1024) - 512;
+        bench_samples[i].y = (int16_t) (i * 7 % 1024) - 512;
+        bench_samples[i].z = 256;
+    }
+
+    _bench_convert_block(32);
+    _bench_convert_block(BENCH_CONVERT_MAX_SAMPLES);
+}
@@ -0,0 +1,117 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench_decode.c
+/// \brief per sample decode cost, the original per-call cleaning against the precomputed decode descriptor
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stddef.h>
+
+#include "bench.h"
+#include "adxl343_driver.h"
+
+#define BENCH_DECODE_SAMPLES 4096
+#define BENCH_DECODE_ROUNDS 200
+
+
+// Statics
+static uint8_t bench_raw [BENCH_DECODE_SAMPLES * 6];
+static ADXL343Sample bench_samples [BENCH_DECODE_SAMPLES];
+static int16_t bench_x [BENCH_DECODE_SAMPLES];
+static int16_t bench_y [BENCH_DECODE_SAMPLES];
+static int16_t bench_z [BENCH_DECODE_SAMPLES];
+
+// Original _clean_accelerometer_data, mask rebuilt and bit order branched on every call
+static void _legacy_clean_accelerometer_data(char* data, const ADXL343Settings* settings){
+    uint16_t cleaned_data;
+    uint8_t resolution = 10;
+    uint16_t resolution_mask = 1;
+    if (settings->resolution == 0x01){
+        resolution += settings->range;
+    }
+    for (int i = 0; i < resolution; i++){
+        resolution_mask *= 2;
+    }
+    resolution_mask -= 1;
+    if (settings->bit_order == 0x00){
+        cleaned_data = ((((resolution_mask >> 8) & data[1]) << 8) | (0xFF & data[0]));
+    } else {
+        cleaned_data = (((data[1] << 8) | (0xFF & data[0])) >> (16 - resolution));
+    }
+    data[0] = (char) (cleaned_data & 0xFF);
+    data[1] = (char) (cleaned_data >> 8);
+}
+
+// Original adxl343_get_all_axes post-processing, copying through temporaries
+static void _legacy_clean_all_axes(char* data, const ADXL343Settings* settings){
+    char x_data [2] = {data[0], data[1]};
+    _legacy_clean_accelerometer_data(x_data, settings);
+    char y_data [2] = {data[2], data[3]};
+    _legacy_clean_accelerometer_data(y_data, settings);
+    char z_data [2] = {data[4], data[5]};
+    _legacy_clean_accelerometer_data(z_data, settings);
+    data[0] = x_data[0];
+    data[1] = x_data[1];
+    data[2] = y_data[0];
+    data[3] = y_data[1];
+    data[4] = z_data[0];
+    data[5] = z_data[1];
+}
+
+static void _bench_decode_config(const char* name, uint8_t range, uint8_t resolution, uint8_t bit_order){
+    ADXL343Settings settings = {0};
+    settings.range = range;
+    settings.resolution = resolution;
+    settings.bit_order = bit_order;
+    int64_t checksum = 0;
+
+    // Original path, on a copy as it cleans in place
+    uint64_t start = bench_now_ns();
+    for (int round = 0; round < BENCH_DECODE_ROUNDS; round++){
+        for (size_t i = 0; i < BENCH_DECODE_SAMPLES; i++){
+            char data [6];
+            for (int b = 0; b < 6; b++){
+                data[b] = (char) bench_raw[6 * i + b];
+            }
+            _legacy_clean_all_axes(data, &settings);
+            checksum += data[0] + data[2] + data[4];
+        }
+    }
+    double legacy_ns = (double) (bench_now_ns() - start) / (BENCH_DECODE_ROUNDS * BENCH_DECODE_SAMPLES);
+
+    // Descriptor built once per configuration
+    start = bench_now_ns();
+    ADXL343Decoder decoder = adxl343_make_decoder(range, resolution, bit_order);
+    for (int round = 0; round < BENCH_DECODE_ROUNDS; round++){
+        adxl343_decode(&decoder, bench_raw, bench_samples, BENCH_DECODE_SAMPLES);
+        checksum += bench_samples[round % BENCH_DECODE_SAMPLES].x;
+    }
+    double decoder_ns = (double) (bench_now_ns() - start) / (BENCH_DECODE_ROUNDS * BENCH_DECODE_SAMPLES);
+
+    // Same descriptor into per-axis arrays
+    start = bench_now_ns();
+    for (int round = 0; round < BENCH_DECODE_ROUNDS; round++){
+        adxl343_decode_strided(&decoder, bench_raw, BENCH_DECODE_SAMPLES, bench_x, bench_y, bench_z, 1);
+        checksum += bench_z[round % BENCH_DECODE_SAMPLES];
+    }
+    double strided_ns = (double) (bench_now_ns() - start) / (BENCH_DECODE_ROUNDS * BENCH_DECODE_SAMPLES);
+
+    bench_consume(checksum);
+    bench_report("decode", name, "legacy_ns_per_sample", legacy_ns, "ns");
+    bench_report("decode", name, "decoder_ns_per_sample", decoder_ns, "ns");
+    bench_report("decode", name, "strided_ns_per_sample", strided_ns, "ns");
+    bench_report("decode", name, "speedup", legacy_ns / decoder_ns, "x");
+}
+
+
+// Functions
+void bench_decode(){
+    // Pseudo random raw data
+    uint32_t state = 0x1234567;
+    for (size_t i = 0; i < sizeof(bench_raw); i++){
+        state = state * 1103515245u + 12345u;
+        bench_raw[i] = (uint8_t) (state >> 16);
+    }
+
+    _bench_decode_config("fixed_2g_right", 0x00, 0x00, 0x00);
+    _bench_decode_config("full_16g_right", 0x03, 0x01, 0x00);
+    _bench_decode_config("full_16g_left", 0x03, 0x01, 0x01);
+}
@@ -0,0 +1,69 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench_features.c
+/// \brief feature extraction cost per sample and per record, and how much smaller the records are than the samples
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "adxl343_features.h"
+
+#define BENCH_FEATURES_BLOCK 32                 // A FIFO drain
+#define BENCH_FEATURES_TOTAL_SAMPLES (1 << 20)
+
+
+// Statics
+static ADXL343Sample bench_input [BENCH_FEATURES_BLOCK * 64];
+static ADXL343FeatureRecord bench_records [BENCH_FEATURES_BLOCK];
+static ADXL343FeatureEngine bench_engine;
+
+static void _bench_features_case(size_t window, size_t hop, int64_t* checksum){
+    char name [32];
+    snprintf(name, sizeof(name), "window%zu_hop%zu", window, hop);
+    ADXL343FeatureConfig config;
+    adxl343_features_default_config(&config, window, hop, ADXL343_FEATURES_MAX_BANDS);
+    adxl343_features_init(&bench_engine, &config);
+
+    const size_t stride = sizeof(bench_input) / sizeof(bench_input[0]);
+    size_t records = 0;
+    uint64_t elapsed = 0;
+    for (size_t fed = 0; fed < BENCH_FEATURES_TOTAL_SAMPLES; fed += BENCH_FEATURES_BLOCK){
+        size_t consumed;
+        size_t emitted;
+        uint64_t start = bench_now_ns();
+        adxl343_features_push(&bench_engine, &bench_input[fed % stride], BENCH_FEATURES_BLOCK, bench_records,
+                              BENCH_FEATURES_BLOCK, &consumed, &emitted);
+        elapsed += bench_now_ns() - start;
+        records += emitted;
+        if (emitted != 0){
+            *checksum += bench_records[0].axes[0].rms_q4 + bench_records[0].axes[2].bands_q8[1];
+        }
+    }
+    double samples_bytes = (double) BENCH_FEATURES_TOTAL_SAMPLES * sizeof(ADXL343Sample);
+    double ns = (double) elapsed / BENCH_FEATURES_TOTAL_SAMPLES;
+    bench_report("features", name, "ns_per_sample", ns, "ns");
+    bench_report("features", name, "ns_per_record", (double) elapsed / (records ? records : 1), "ns");
+    bench_report("features", name, "samples_per_s", 1000.0 / ns, "Msamples/s");
+    bench_report("features", name, "reduction", samples_bytes / ((double) records * sizeof(ADXL343FeatureRecord)), "x");
+}
+
+
+// Functions
+void bench_features(){
+    int64_t checksum = 0;
+    uint32_t state = 0x1234567;
+    const size_t count = sizeof(bench_input) / sizeof(bench_input[0]);
+    for (size_t i = 0; i < count; i++){
+        state = state * 1103515245u + 12345u;
+        // A 1/16 rate tone on X over noise, gravity on Z
+        bench_input[i].x = (int16_t) ((((i >> 3) & 1) ? 300 : -300) + (int16_t) ((state >> 16) % 64) - 32);
+        bench_input[i].y = (int16_t) ((state >> 8) % 512) - 256;
+        bench_input[i].z = (int16_t) ((state >> 4) % 32) + 240;
+    }
+
+    _bench_features_case(256, 256, &checksum);
+    _bench_features_case(256, 64, &checksum);
+    _bench_features_case(64, 64, &checksum);
+    _bench_features_case(64, 16, &checksum);
+    bench_consume(checksum);
+}
@@ -0,0 +1,166 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench_filter.c
+/// \brief filter pipeline throughput, per stage and for a 3200 Hz low-pass/decimate chain against per-sample float
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "adxl343_filter.h"
+
+#define BENCH_FILTER_MAX_SAMPLES 4096
+#define BENCH_FILTER_TOTAL_SAMPLES (1 << 21)    // Samples filtered per measurement, whatever the block size
+#define BENCH_FILTER_TAPS 32
+#define BENCH_FILTER_DECIMATION 4
+
+
+// Statics
+// - Butterworth low-pass 100 Hz at 3200 Hz (Q28) and a 32 tap low-pass in front of a decimation by 4 (Q15)
+static const ADXL343BiquadCoeffs bench_lowpass = {2266318, 4532636, 2266318, -462722643, 203352459};
+static const int16_t bench_taps [BENCH_FILTER_TAPS] = {
+    -17, 20, 73, 135, 164, 91, -129, -466, -783, -850, -435, 588, 2141, 3927, 5501, 6424,
+    6424, 5501, 3927, 2141, 588, -435, -850, -783, -466, -129, 91, 164, 135, 73, 20, -17
+};
+static ADXL343Sample bench_input [BENCH_FILTER_MAX_SAMPLES];
+static ADXL343Sample bench_samples [BENCH_FILTER_MAX_SAMPLES];
+static ADXL343FilterStage bench_stages [3];
+static ADXL343FilterPipeline bench_pipeline;
+
+// Per-sample float chain the pipeline replaces: DC removal, biquad and FIR decimation, axis by axis
+typedef struct {
+    float dc_x1 [3];
+    float dc_y1 [3];
+    float bq_x [3][2];
+    float bq_y [3][2];
+    float fir_line [3][BENCH_FILTER_TAPS];
+    size_t fir_index;
+    size_t fir_phase;
+} BenchFloatChain;
+
+static BenchFloatChain bench_float;
+
+static size_t _bench_filter_float(ADXL343Sample* samples, size_t count){
+    const float b0 = bench_lowpass.b0 / 268435456.0f;
+    const float b1 = bench_lowpass.b1 / 268435456.0f;
+    const float b2 = bench_lowpass.b2 / 268435456.0f;
+    const float a1 = bench_lowpass.a1 / 268435456.0f;
+    const float a2 = bench_lowpass.a2 / 268435456.0f;
+    const float pole = 1.0f - 1.0f / 128.0f;
+    size_t output = 0;
+    for (size_t i = 0; i < count; i++){
+        int16_t* values = &samples[i].x;
+        float out [3];
+        for (int axis = 0; axis < 3; axis++){
+            float x = (float) values[axis];
+            float dc = x - bench_float.dc_x1[axis] + pole * bench_float.dc_y1[axis];
+            bench_float.dc_x1[axis] = x;
+            bench_float.dc_y1[axis] = dc;
+            float y = b0 * dc + b1 * bench_float.bq_x[axis][0] + b2 * bench_float.bq_x[axis][1]
+                      - a1 * bench_float.bq_y[axis][0] - a2 * bench_float.bq_y[axis][1];
+            bench_float.bq_x[axis][1] = bench_float.bq_x[axis][0];
+            bench_float.bq_x[axis][0] = dc;
+            bench_float.bq_y[axis][1] = bench_float.bq_y[axis][0];
+            bench_float.bq_y[axis][0] = y;
+            bench_float.fir_line[axis][bench_float.fir_index] = y;
+        }
+        bench_float.fir_index = (bench_float.fir_index + 1) % BENCH_FILTER_TAPS;
+        if (++bench_float.fir_phase < BENCH_FILTER_DECIMATION){continue;}
+        bench_float.fir_phase = 0;
+        for (int axis = 0; axis < 3; axis++){
+            float sum = 0.0f;
+            for (size_t k = 0; k < BENCH_FILTER_TAPS; k++){
+                size_t at = (bench_float.fir_index + BENCH_FILTER_TAPS - 1 - k) % BENCH_FILTER_TAPS;
+                sum += bench_taps[k] / 32768.0f * bench_float.fir_line[axis][at];
+            }
+            out[axis] = sum;
+        }
+        samples[output].x = (int16_t) out[0];
+        samples[output].y = (int16_t) out[1];
+        samples[output].z = (int16_t) out[2];
+        output++;
+    }
+    return output;
+}
+
+// Nanoseconds per input sample of a pipeline over the given stages, fed in blocks
+static double _bench_filter_pipeline(size_t stages, size_t block, int64_t* checksum){
+    adxl343_filter_init(&bench_pipeline, bench_stages, stages);
+    size_t rounds = BENCH_FILTER_TOTAL_SAMPLES / block;
+    uint64_t elapsed = 0;
+    for (size_t round = 0; round < rounds; round++){
+        size_t output;
+        for (size_t i = 0; i < block; i++){
+            bench_samples[i] = bench_input[i];
+        }
+        uint64_t start = bench_now_ns();
+        adxl343_filter_process(&bench_pipeline, bench_samples, block, &output);
+        elapsed += bench_now_ns() - start;
+        *checksum += bench_samples[round % (output + 1)].x;
+    }
+    return (double) elapsed / (rounds * block);
+}
+
+static void _bench_filter_report(const char* name, double ns){
+    bench_report("filter", name, "ns_per_sample", ns, "ns");
+    bench_report("filter", name, "samples_per_s", 1000.0 / ns, "Msamples/s");
+}
+
+static void _bench_filter_stages(int64_t* checksum){
+    adxl343_filter_biquad(&bench_stages[0], &bench_lowpass);
+    _bench_filter_report("biquad", _bench_filter_pipeline(1, BENCH_FILTER_MAX_SAMPLES, checksum));
+    adxl343_filter_fir_decimator(&bench_stages[0], bench_taps, BENCH_FILTER_TAPS, BENCH_FILTER_DECIMATION);
+    _bench_filter_report("fir32_decimate4", _bench_filter_pipeline(1, BENCH_FILTER_MAX_SAMPLES, checksum));
+    adxl343_filter_fir_decimator(&bench_stages[0], bench_taps, BENCH_FILTER_TAPS, 1);
+    _bench_filter_report("fir32", _bench_filter_pipeline(1, BENCH_FILTER_MAX_SAMPLES, checksum));
+    adxl343_filter_dc_block(&bench_stages[0], 7);
+    _bench_filter_report("dc_block", _bench_filter_pipeline(1, BENCH_FILTER_MAX_SAMPLES, checksum));
+    adxl343_filter_moving_rms(&bench_stages[0], 64);
+    _bench_filter_report("moving_rms64", _bench_filter_pipeline(1, BENCH_FILTER_MAX_SAMPLES, checksum));
+}
+
+static void _bench_filter_chain(size_t block, int64_t* checksum){
+    char name [32];
+    snprintf(name, sizeof(name), "%s_chain_%zu", ADXL343_FILTER_SIMD ? "simd" : "auto", block);
+
+    // Float reference, one sample at a time
+    size_t rounds = BENCH_FILTER_TOTAL_SAMPLES / block;
+    uint64_t elapsed = 0;
+    for (size_t round = 0; round < rounds; round++){
+        for (size_t i = 0; i < block; i++){
+            bench_samples[i] = bench_input[i];
+        }
+        uint64_t start = bench_now_ns();
+        size_t output = _bench_filter_float(bench_samples, block);
+        elapsed += bench_now_ns() - start;
+        *checksum += bench_samples[round % (output + 1)].x;
+    }
+    double float_ns = (double) elapsed / (rounds * block);
+
+    adxl343_filter_dc_block(&bench_stages[0], 7);
+    adxl343_filter_biquad(&bench_stages[1], &bench_lowpass);
+    adxl343_filter_fir_decimator(&bench_stages[2], bench_taps, BENCH_FILTER_TAPS, BENCH_FILTER_DECIMATION);
+    double fixed_ns = _bench_filter_pipeline(3, block, checksum);
+
+    bench_report("filter", name, "float_ns_per_sample", float_ns, "ns");
+    bench_report("filter", name, "fixed_ns_per_sample", fixed_ns, "ns");
+    bench_report("filter", name, "fixed_samples_per_s", 1000.0 / fixed_ns, "Msamples/s");
+    bench_report("filter", name, "speedup", float_ns / fixed_ns, "x");
+}
+
+
+// Functions
+void bench_filter(){
+    int64_t checksum = 0;
+    uint32_t state = 0x1234567;
+    for (size_t i = 0; i < BENCH_FILTER_MAX_SAMPLES; i++){
+        state = state * 1103515245u + 12345u;
+        bench_input[i].x = (int16_t) ((state >> 16) % 1024) - 512;
+        bench_input[i].y = (int16_t) ((state >> 8) % 1024) - 512;
+        bench_input[i].z = (int16_t) ((state >> 4) % 256) + 128;
+    }
+
+    _bench_filter_stages(&checksum);
+    _bench_filter_chain(32, &checksum);
+    _bench_filter_chain(BENCH_FILTER_MAX_SAMPLES, &checksum);
+    bench_consume(checksum);
+}
@@ -0,0 +1,104 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench_i2c_queue.c
+/// \brief overhead, latency and throughput of the i2c transaction queue (against the stub bus primitives)
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "bench.h"
+#include "i2c_driver.h"
+
+#define BENCH_QUEUE_TRANSACTIONS 200000         // Transactions per measurement
+
+
+// Statics
+static I2CTransaction bench_transactions [I2C_QUEUE_DEPTH];
+static const char bench_frame [2] = {(char) (0x53 << 1), 0x39};
+static char bench_read [I2C_QUEUE_DEPTH];
+static atomic_bool bench_worker_running;
+static uint32_t bench_completed;
+static uint64_t bench_latency_ns;
+
+static void _bench_completed(I2CTransaction* transaction, void* context){
+    bench_latency_ns += bench_now_ns() - *(uint64_t*) context;
+    bench_completed++;
+    (void) transaction;
+}
+
+static void* _bench_worker(void* argument){
+    (void) argument;
+    while (atomic_load_explicit(&bench_worker_running, memory_order_relaxed)){
+        if (i2c_process() == 0){
+            sched_yield();
+        }
+    }
+    i2c_process();
+    return NULL;
+}
+
+static void _bench_prepare(I2CTransaction* transaction, uint64_t* submitted_at, size_t slot){
+    transaction->type = I2C_TRANSACTION_WRITE_READ;
+    transaction->dataToWrite = bench_frame;
+    transaction->writeLength = sizeof(bench_frame);
+    transaction->dataToRead = &bench_read[slot];
+    transaction->readLength = 1;
+    transaction->timeout = 1;
+    transaction->callback = _bench_completed;
+    transaction->context = submitted_at;
+    *submitted_at = bench_now_ns();
+}
+
+// Submit, process and poll on one thread, the bookkeeping cost on top of a blocking call
+static void _bench_queue_inline(){
+    static uint64_t submitted_at [I2C_QUEUE_DEPTH];
+    bench_completed = 0;
+    bench_latency_ns = 0;
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_QUEUE_TRANSACTIONS; i++){
+        size_t slot = i % I2C_QUEUE_DEPTH;
+        _bench_prepare(&bench_transactions[slot], &submitted_at[slot], slot);
+        i2c_submit(&bench_transactions[slot]);
+        i2c_process();
+        i2c_poll();
+    }
+    double ns = (double) (bench_now_ns() - start) / BENCH_QUEUE_TRANSACTIONS;
+    bench_consume(bench_completed);
+    bench_report("i2c_queue", "inline", "ns_per_transaction", ns, "ns");
+}
+
+// Application thread keeps the queue full, a worker thread executes it
+static void _bench_queue_worker(){
+    static uint64_t submitted_at [I2C_QUEUE_DEPTH];
+    pthread_t worker;
+    uint32_t submitted = 0;
+    bench_completed = 0;
+    bench_latency_ns = 0;
+    atomic_store(&bench_worker_running, 1);
+    if (pthread_create(&worker, NULL, _bench_worker, NULL) != 0){return;}
+    uint64_t start = bench_now_ns();
+    while (bench_completed < BENCH_QUEUE_TRANSACTIONS){
+        while (submitted < BENCH_QUEUE_TRANSACTIONS && submitted - bench_completed < I2C_QUEUE_DEPTH){
+            size_t slot = submitted % I2C_QUEUE_DEPTH;
+            _bench_prepare(&bench_transactions[slot], &submitted_at[slot], slot);
+            if (i2c_submit(&bench_transactions[slot]) != FUNCTION_STATUS_OK){break;}
+            submitted++;
+        }
+        if (i2c_poll() == 0){
+            sched_yield();
+        }
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    atomic_store(&bench_worker_running, 0);
+    pthread_join(worker, NULL);
+    bench_report("i2c_queue", "worker", "transactions_per_s", BENCH_QUEUE_TRANSACTIONS * 1e9 / elapsed, "1/s");
+    bench_report("i2c_queue", "worker", "submit_to_callback_ns", (double) bench_latency_ns / bench_completed, "ns");
+}
+
+
+// Functions
+void bench_i2c_queue(){
+    _bench_queue_inline();
+    _bench_queue_worker();
+}
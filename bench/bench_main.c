@@ -0,0 +1,22 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench_main.c
+/// \brief host benchmark runner, results are written to stdout as CSV
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "bench.h"
+
+
+int main(int argc, char** argv){
+    bench_header(argc, argv);
+
+    bench_decode();
+    bench_convert();
+    bench_i2c_queue();
+    bench_filter();
+    bench_features();
+    bench_reduce();
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench_reduce.c
+/// \brief deadband and swinging door reduction, cost per sample and compression on still and vibrating signals
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "adxl343_reduce.h"
+
+#define BENCH_REDUCE_SAMPLES 4096
+#define BENCH_REDUCE_BLOCK 32                   // A FIFO drain
+#define BENCH_REDUCE_ROUNDS 64
+#define BENCH_REDUCE_PERIOD_NS 1250000ull       // 800 Hz
+#define BENCH_REDUCE_HEARTBEAT_NS 1000000000ull
+
+
+// Statics
+static ADXL343Sample bench_input [BENCH_REDUCE_SAMPLES];
+static uint64_t bench_timestamps [BENCH_REDUCE_SAMPLES];
+static ADXL343ReducedPoint bench_points [2 * BENCH_REDUCE_BLOCK];
+static ADXL343Reducer bench_reducer;
+
+// Still: +-2 LSB noise around gravity. Moving: a slow swing on X and Y with the noise on top.
+static void _bench_reduce_fill(int moving){
+    uint32_t state = 0x1234567;
+    for (size_t i = 0; i < BENCH_REDUCE_SAMPLES; i++){
+        state = state * 1103515245u + 12345u;
+        int16_t noise = (int16_t) ((state >> 16) % 5) - 2;
+        int16_t swing = 0;
+        if (moving){
+            // Triangle of +-128 LSB over 512 samples
+            size_t phase = i % 512;
+            swing = (int16_t) ((phase < 256) ? (int16_t) phase - 128 : 384 - (int16_t) phase);
+        }
+        bench_input[i].x = (int16_t) (noise + swing);
+        bench_input[i].y = (int16_t) (noise - swing / 2);
+        bench_input[i].z = (int16_t) (256 + noise);
+    }
+}
+
+static void _bench_reduce_case(const char* signal, uint8_t mode, uint16_t threshold, int64_t* checksum){
+    char name [40];
+    snprintf(name, sizeof(name), "%s_%s_%u", (mode == ADXL343_REDUCE_DEADBAND) ? "deadband" : "swinging_door", signal,
+             threshold);
+    ADXL343ReduceConfig config = {mode, {threshold, threshold, threshold}, BENCH_REDUCE_HEARTBEAT_NS};
+    adxl343_reduce_init(&bench_reducer, &config);
+    uint64_t elapsed = 0;
+    for (size_t round = 0; round < BENCH_REDUCE_ROUNDS; round++){
+        // Keep the timestamps running on from round to round
+        for (size_t i = 0; i < BENCH_REDUCE_SAMPLES; i++){
+            bench_timestamps[i] = (round * BENCH_REDUCE_SAMPLES + i) * BENCH_REDUCE_PERIOD_NS;
+        }
+        for (size_t start = 0; start < BENCH_REDUCE_SAMPLES; start += BENCH_REDUCE_BLOCK){
+            size_t consumed;
+            size_t emitted;
+            uint64_t begin = bench_now_ns();
+            adxl343_reduce_push(&bench_reducer, &bench_input[start], &bench_timestamps[start], BENCH_REDUCE_BLOCK,
+                                bench_points, 2 * BENCH_REDUCE_BLOCK, &consumed, &emitted);
+            elapsed += bench_now_ns() - begin;
+            if (emitted != 0){
+                *checksum += bench_points[emitted - 1].sample.x;
+            }
+        }
+    }
+    double inputs = (double) bench_reducer.inputs;
+    double outputs = (double) (bench_reducer.outputs ? bench_reducer.outputs : 1);
+    bench_report("reduce", name, "ns_per_sample", (double) elapsed / inputs, "ns");
+    bench_report("reduce", name, "compression_ratio", inputs / outputs, "x");
+}
+
+
+// Functions
+void bench_reduce(){
+    int64_t checksum = 0;
+    _bench_reduce_fill(0);
+    _bench_reduce_case("still", ADXL343_REDUCE_DEADBAND, 4, &checksum);
+    _bench_reduce_case("still", ADXL343_REDUCE_SWINGING_DOOR, 4, &checksum);
+    _bench_reduce_fill(1);
+    _bench_reduce_case("moving", ADXL343_REDUCE_DEADBAND, 4, &checksum);
+    _bench_reduce_case("moving", ADXL343_REDUCE_SWINGING_DOOR, 4, &checksum);
+    _bench_reduce_case("moving", ADXL343_REDUCE_DEADBAND, 16, &checksum);
+    _bench_reduce_case("moving", ADXL343_REDUCE_SWINGING_DOOR, 16, &checksum);
+    bench_consume(checksum);
+}
@@ -0,0 +1,372 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  bench_bus.c
+/// \brief bus cost of every adxl343 driver call, run against the simulated bus and ADXL343 model
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stddef.h>
+
+#include "bench.h"
+#include "sim_i2c_bus.h"
+#include "sim_adxl343.h"
+#include "adxl343_driver.h"
+#include "adxl343_ring.h"
+#include "adxl343_timeline.h"
+
+#define BENCH_BUS_ITERATIONS 2000               // Calls per case for the host time, each on a fresh setup
+#define BENCH_BUS_FAST_CLOCK 400000             // Bus clocks the modelled bus time is reported for, in Hz
+#define BENCH_BUS_STANDARD_CLOCK 100000
+
+// Benchmarked call, prepare runs before the measurement and run returns the number of samples decoded
+typedef struct {
+    const char* name;
+    uint8_t fifo_full;                          // Stream mode with a full FIFO before the call
+    void (*prepare)();
+    size_t (*run)();
+} BenchBusCase;
+
+// Bus traffic of one call
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint64_t bus_ns;
+    size_t samples;
+} BenchBusCost;
+
+
+// Statics
+static SimADXL343 bench_sims [2];
+static ADXL343Device bench_devices [2];
+static ADXL343Sample bench_samples [ADXL343_FIFO_SIZE + 1];
+static ADXL343Sample bench_ring_storage [64];
+static ADXL343Ring bench_ring;
+static ADXL343Timeline bench_timeline;
+static uint64_t bench_timestamps [ADXL343_FIFO_SIZE + 1];
+static ADXL343AsyncOp bench_op;
+static ADXL343Config bench_config;
+static uint8_t bench_async_done;
+static size_t bench_async_count;
+
+static void _bench_bus_setup(uint8_t fifo_full, uint32_t clock_hz){
+    sim_i2c_bus_reset();
+    sim_i2c_bus_set_clock(clock_hz);
+    sim_adxl343_attach(&bench_sims[0], ADXL343_ADDRESS_I2C);
+    sim_adxl343_attach(&bench_sims[1], ADXL343_ADDRESS_I2C_ALT);
+    sim_adxl343_set_acceleration(&bench_sims[0], 0, -500, 1000);
+    sim_adxl343_set_acceleration(&bench_sims[1], 250, 0, -1000);
+    adxl343_init(&bench_devices[0], NULL, ADXL343_ADDRESS_I2C);
+    adxl343_init(&bench_devices[1], NULL, ADXL343_ADDRESS_I2C_ALT);
+    if (fifo_full){
+        adxl343_set_fifo_mode(&bench_devices[0], ADXL343_FIFO_MODE_STREAM, 16, ADXL343_FIFO_TRIGGER_INT1);
+        adxl343_start(&bench_devices[0]);
+        sim_i2c_bus_advance_ns((SIM_ADXL343_FIFO_ENTRIES + 1) * sim_adxl343_period_ns(&bench_sims[0]));
+        sim_adxl343_advance_to(&bench_sims[0], sim_i2c_bus_now_ns());
+    }
+}
+
+static void _bench_bus_async_done(ADXL343Device* device, FunctionStatus status, size_t count, void* context){
+    (void) device;
+    (void) status;
+    (void) context;
+    bench_async_done = 1;
+    bench_async_count = count;
+}
+
+static void _bench_bus_async_wait(){
+    // The queue is executed inline, the bus model is single threaded
+    while (!bench_async_done){
+        i2c_process();
+        i2c_poll();
+    }
+}
+
+static void _bench_bus_on_interrupt(ADXL343Device* device, uint8_t source, void* context){
+    (void) device;
+    (void) context;
+    bench_consume(source);
+}
+
+// Cases
+static size_t _bench_bus_init(){
+    adxl343_init(&bench_devices[0], NULL, ADXL343_ADDRESS_I2C);
+    return 0;
+}
+
+static size_t _bench_bus_start(){
+    adxl343_start(&bench_devices[0]);
+    return 0;
+}
+
+static void _bench_bus_prepare_stop(){
+    adxl343_start(&bench_devices[0]);
+}
+
+static size_t _bench_bus_stop(){
+    adxl343_stop(&bench_devices[0]);
+    return 0;
+}
+
+static size_t _bench_bus_set_rate(){
+    adxl343_set_rate(&bench_devices[0], 0x0D);
+    return 0;
+}
+
+static size_t _bench_bus_set_range(){
+    adxl343_set_range(&bench_devices[0], 0x03);
+    return 0;
+}
+
+static size_t _bench_bus_set_resolution_full(){
+    adxl343_set_resolution_full(&bench_devices[0]);
+    return 0;
+}
+
+static void _bench_bus_prepare_resolution_fixed(){
+    adxl343_set_resolution_full(&bench_devices[0]);
+}
+
+static size_t _bench_bus_set_resolution_fixed(){
+    adxl343_set_resolution_fixed(&bench_devices[0]);
+    return 0;
+}
+
+static size_t _bench_bus_set_bit_order(){
+    adxl343_set_bit_order(&bench_devices[0], 0x01);
+    return 0;
+}
+
+static size_t _bench_bus_get_X_axis(){
+    char data [2];
+    adxl343_get_X_axis(&bench_devices[0], data);
+    return 0;
+}
+
+static size_t _bench_bus_get_Y_axis(){
+    char data [2];
+    adxl343_get_Y_axis(&bench_devices[0], data);
+    return 0;
+}
+
+static size_t _bench_bus_get_Z_axis(){
+    char data [2];
+    adxl343_get_Z_axis(&bench_devices[0], data);
+    return 0;
+}
+
+static size_t _bench_bus_get_all_axes(){
+    char data [6];
+    adxl343_get_all_axes(&bench_devices[0], data);
+    return 0;
+}
+
+static size_t _bench_bus_read_sample(){
+    adxl343_read_sample(&bench_devices[0], &bench_samples[0]);
+    return 1;
+}
+
+static size_t _bench_bus_read_multi(){
+    ADXL343Device* const devices [2] = {&bench_devices[0], &bench_devices[1]};
+    if (adxl343_read_multi(devices, 2, bench_samples) != FUNCTION_STATUS_OK){return 0;}
+    return 2;
+}
+
+static size_t _bench_bus_set_fifo_mode(){
+    adxl343_set_fifo_mode(&bench_devices[0], ADXL343_FIFO_MODE_STREAM, 16, ADXL343_FIFO_TRIGGER_INT1);
+    return 0;
+}
+
+static size_t _bench_bus_get_fifo_entries(){
+    uint8_t entries = 0;
+    adxl343_get_fifo_entries(&bench_devices[0], &entries);
+    return 0;
+}
+
+static size_t _bench_bus_read_fifo(){
+    size_t count = 0;
+    adxl343_read_fifo(&bench_devices[0], bench_samples, ADXL343_FIFO_SIZE + 1, &count);
+    return count;
+}
+
+static uint64_t _bench_bus_timestamp(){
+    return sim_i2c_bus_now_ns();
+}
+
+static void _bench_bus_prepare_timeline(){
+    adxl343_set_timestamp_source(_bench_bus_timestamp);
+    adxl343_timeline_init(&bench_timeline, bench_devices[0].settings.rate);
+}
+
+static size_t _bench_bus_read_fifo_timestamped(){
+    size_t count = 0;
+    adxl343_read_fifo_timestamped(&bench_devices[0], &bench_timeline, bench_samples, bench_timestamps,
+                                  ADXL343_FIFO_SIZE + 1, &count);
+    return count;
+}
+
+static void _bench_bus_prepare_ring(){
+    adxl343_ring_init(&bench_ring, bench_ring_storage, 64);
+}
+
+static size_t _bench_bus_drain_fifo_to_ring(){
+    size_t count = 0;
+    adxl343_drain_fifo_to_ring(&bench_devices[0], &bench_ring, &count);
+    return count;
+}
+
+static size_t _bench_bus_drain_fifo_async(){
+    bench_async_done = 0;
+    bench_async_count = 0;
+    if (adxl343_drain_fifo_async(&bench_devices[0], &bench_op, bench_samples, ADXL343_FIFO_SIZE + 1,
+                                 _bench_bus_async_done, NULL) != FUNCTION_STATUS_OK){return 0;}
+    _bench_bus_async_wait();
+    return bench_async_count;
+}
+
+static size_t _bench_bus_set_interrupts(){
+    adxl343_set_interrupts(&bench_devices[0], ADXL343_INT_WATERMARK | ADXL343_INT_OVERRUN, ADXL343_INT_MAP_INT1);
+    return 0;
+}
+
+static void _bench_bus_prepare_on_interrupt(){
+    adxl343_set_interrupts(&bench_devices[0], ADXL343_INT_WATERMARK | ADXL343_INT_OVERRUN, ADXL343_INT_MAP_INT1);
+    adxl343_set_interrupt_callback(&bench_devices[0], ADXL343_INT_WATERMARK | ADXL343_INT_OVERRUN,
+                                   _bench_bus_on_interrupt, NULL);
+}
+
+static size_t _bench_bus_on_interrupt_call(){
+    adxl343_on_interrupt(&bench_devices[0]);
+    return 0;
+}
+
+static size_t _bench_bus_set_tap_config(){
+    const ADXL343TapConfig tap = {3000, 10000, 20000, 250000, ADXL343_AXIS_ALL, 0};
+    adxl343_set_tap_config(&bench_devices[0], &tap);
+    return 0;
+}
+
+static size_t _bench_bus_get_event_status(){
+    ADXL343EventStatus status;
+    adxl343_get_event_status(&bench_devices[0], &status);
+    return 0;
+}
+
+static void _bench_bus_prepare_config(){
+    adxl343_get_default_config(&bench_config);
+    bench_config.thresh_tap = 0x30;
+    bench_config.bw_rate = 0x0D;
+    bench_config.int_enable = ADXL343_INT_WATERMARK;
+    bench_config.fifo_ctl = (uint8_t) ((ADXL343_FIFO_MODE_STREAM << 6) | 16);
+}
+
+static size_t _bench_bus_apply_config(){
+    adxl343_apply_config(&bench_devices[0], &bench_config);
+    return 0;
+}
+
+static size_t _bench_bus_apply_config_async(){
+    bench_async_done = 0;
+    if (adxl343_apply_config_async(&bench_devices[0], &bench_op, &bench_config, _bench_bus_async_done,
+                                   NULL) != FUNCTION_STATUS_OK){return 0;}
+    _bench_bus_async_wait();
+    return 0;
+}
+
+static size_t _bench_bus_snapshot_config(){
+    adxl343_snapshot_config(&bench_devices[0], &bench_config);
+    return 0;
+}
+
+static size_t _bench_bus_resync_shadow(){
+    adxl343_resync_shadow(&bench_devices[0]);
+    return 0;
+}
+
+static const BenchBusCase bench_bus_cases [] = {
+    {"init", 0, NULL, _bench_bus_init},
+    {"start", 0, NULL, _bench_bus_start},
+    {"stop", 0, _bench_bus_prepare_stop, _bench_bus_stop},
+    {"set_rate", 0, NULL, _bench_bus_set_rate},
+    {"set_range", 0, NULL, _bench_bus_set_range},
+    {"set_resolution_full", 0, NULL, _bench_bus_set_resolution_full},
+    {"set_resolution_fixed", 0, _bench_bus_prepare_resolution_fixed, _bench_bus_set_resolution_fixed},
+    {"set_bit_order", 0, NULL, _bench_bus_set_bit_order},
+    {"get_X_axis", 0, NULL, _bench_bus_get_X_axis},
+    {"get_Y_axis", 0, NULL, _bench_bus_get_Y_axis},
+    {"get_Z_axis", 0, NULL, _bench_bus_get_Z_axis},
+    {"get_all_axes", 0, NULL, _bench_bus_get_all_axes},
+    {"read_sample", 0, NULL, _bench_bus_read_sample},
+    {"read_multi", 0, NULL, _bench_bus_read_multi},
+    {"set_fifo_mode", 0, NULL, _bench_bus_set_fifo_mode},
+    {"get_fifo_entries", 1, NULL, _bench_bus_get_fifo_entries},
+    {"read_fifo", 1, NULL, _bench_bus_read_fifo},
+    {"read_fifo_timestamped", 1, _bench_bus_prepare_timeline, _bench_bus_read_fifo_timestamped},
+    {"drain_fifo_to_ring", 1, _bench_bus_prepare_ring, _bench_bus_drain_fifo_to_ring},
+    {"drain_fifo_async", 1, NULL, _bench_bus_drain_fifo_async},
+    {"set_interrupts", 0, NULL, _bench_bus_set_interrupts},
+    {"on_interrupt", 1, _bench_bus_prepare_on_interrupt, _bench_bus_on_interrupt_call},
+    {"set_tap_config", 0, NULL, _bench_bus_set_tap_config},
+    {"get_event_status", 0, NULL, _bench_bus_get_event_status},
+    {"apply_config", 0, _bench_bus_prepare_config, _bench_bus_apply_config},
+    {"apply_config_async", 0, _bench_bus_prepare_config, _bench_bus_apply_config_async},
+    {"snapshot_config", 0, NULL, _bench_bus_snapshot_config},
+    {"resync_shadow", 0, NULL, _bench_bus_resync_shadow},
+};
+
+// Bus traffic of a single call on a fresh setup, deterministic so it is measured once per clock
+static BenchBusCost _bench_bus_cost(const BenchBusCase* bench_case, uint32_t clock_hz){
+    BenchBusCost cost;
+    _bench_bus_setup(bench_case->fifo_full, clock_hz);
+    if (bench_case->prepare != NULL){
+        bench_case->prepare();
+    }
+    uint32_t transactions = sim_i2c_bus_transactions();
+    uint32_t bytes = sim_i2c_bus_bytes();
+    uint64_t bus_ns = sim_i2c_bus_time_ns();
+    cost.samples = bench_case->run();
+    cost.transactions = sim_i2c_bus_transactions() - transactions;
+    cost.bytes = sim_i2c_bus_bytes() - bytes;
+    cost.bus_ns = sim_i2c_bus_time_ns() - bus_ns;
+    return cost;
+}
+
+// Host time of the call, including the bus and device model answering it
+static uint64_t _bench_bus_host_ns(const BenchBusCase* bench_case){
+    uint64_t elapsed = 0;
+    for (uint32_t i = 0; i < BENCH_BUS_ITERATIONS; i++){
+        _bench_bus_setup(bench_case->fifo_full, BENCH_BUS_FAST_CLOCK);
+        if (bench_case->prepare != NULL){
+            bench_case->prepare();
+        }
+        uint64_t start = bench_now_ns();
+        bench_consume((int64_t) bench_case->run());
+        elapsed += bench_now_ns() - start;
+    }
+    return elapsed;
+}
+
+static void _bench_bus_case(const BenchBusCase* bench_case){
+    BenchBusCost fast = _bench_bus_cost(bench_case, BENCH_BUS_FAST_CLOCK);
+    BenchBusCost standard = _bench_bus_cost(bench_case, BENCH_BUS_STANDARD_CLOCK);
+    double host_ns = (double) _bench_bus_host_ns(bench_case) / BENCH_BUS_ITERATIONS;
+    bench_report("bus", bench_case->name, "transactions", fast.transactions, "count");
+    bench_report("bus", bench_case->name, "bytes", fast.bytes, "B");
+    bench_report("bus", bench_case->name, "bus_time_400khz", fast.bus_ns / 1000.0, "us");
+    bench_report("bus", bench_case->name, "bus_time_100khz", standard.bus_ns / 1000.0, "us");
+    bench_report("bus", bench_case->name, "host_ns_per_call", host_ns, "ns");
+    if (fast.samples > 0){
+        bench_report("bus", bench_case->name, "samples", fast.samples, "count");
+        bench_report("bus", bench_case->name, "bytes_per_sample", (double) fast.bytes / fast.samples, "B");
+        bench_report("bus", bench_case->name, "bus_time_400khz_per_sample", fast.bus_ns / 1000.0 / fast.samples,
+                     "us");
+        bench_report("bus", bench_case->name, "host_ns_per_sample", host_ns / fast.samples, "ns");
+    }
+}
+
+
+// Functions
+int main(int argc, char** argv){
+    bench_header(argc, argv);
+    for (size_t i = 0; i < sizeof(bench_bus_cases) / sizeof(bench_bus_cases[0]); i++){
+        _bench_bus_case(&bench_bus_cases[i]);
+    }
+    return 0;
+}
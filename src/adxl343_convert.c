@@ -0,0 +1,116 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  adxl343_convert.c
+/// \brief block conversion of adxl343 samples to physical units
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_convert.h"
+
+#if ADXL343_CONVERT_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#elif ADXL343_CONVERT_SIMD
+#include <arm_neon.h>
+#endif
+
+// The kernels walk the samples as one flat array of interleaved X/Y/Z values
+_Static_assert(sizeof(ADXL343Sample) == 3 * sizeof(int16_t), "ADXL343Sample must be tightly packed");
+
+
+// Statics
+// Q8 product to mg rounded to nearest, halves away from zero: the bias is one less for negative products
+static inline int32_t _convert_mg_round(int32_t product){
+    return (product + 128 - (product < 0)) >> 8;
+}
+
+static size_t _convert_mg_simd(const int16_t* values, int32_t* mg, size_t length, int16_t scale){
+    size_t i = 0;
+#if ADXL343_CONVERT_SIMD && defined(__SSE2__)
+    // 16x16 bit products are rebuilt to 32 bit from their low and high halves, the sign (0 or -1) lowers the bias
+    const __m128i scale_vector = _mm_set1_epi16(scale);
+    const __m128i bias = _mm_set1_epi32(128);
+    for (; i + 8 <= length; i += 8){
+        __m128i v = _mm_loadu_si128((const __m128i*) &values[i]);
+        __m128i lo = _mm_mullo_epi16(v, scale_vector);
+        __m128i hi = _mm_mulhi_epi16(v, scale_vector);
+        __m128i first = _mm_unpacklo_epi16(lo, hi);
+        __m128i second = _mm_unpackhi_epi16(lo, hi);
+        first = _mm_add_epi32(first, _mm_add_epi32(bias, _mm_srai_epi32(first, 31)));
+        second = _mm_add_epi32(second, _mm_add_epi32(bias, _mm_srai_epi32(second, 31)));
+        _mm_storeu_si128((__m128i*) &mg[i], _mm_srai_epi32(first, 8));
+        _mm_storeu_si128((__m128i*) &mg[i + 4], _mm_srai_epi32(second, 8));
+    }
+#elif ADXL343_CONVERT_SIMD
+    // vrshrq rounds halves up, not away from zero, so the bias is added like in the scalar loop
+    const int16x4_t scale_vector = vdup_n_s16(scale);
+    const int32x4_t bias = vdupq_n_s32(128);
+    for (; i + 8 <= length; i += 8){
+        int16x8_t v = vld1q_s16(&values[i]);
+        int32x4_t first = vmull_s16(vget_low_s16(v), scale_vector);
+        int32x4_t second = vmull_s16(vget_high_s16(v), scale_vector);
+        first = vaddq_s32(first, vaddq_s32(bias, vshrq_n_s32(first, 31)));
+        second = vaddq_s32(second, vaddq_s32(bias, vshrq_n_s32(second, 31)));
+        vst1q_s32(&mg[i], vshrq_n_s32(first, 8));
+        vst1q_s32(&mg[i + 4], vshrq_n_s32(second, 8));
+    }
+#else
+    (void) values;
+    (void) mg;
+    (void) length;
+    (void) scale;
+#endif
+    return i;
+}
+
+static size_t _convert_ms2_simd(const int16_t* values, float* ms2, size_t length, float factor){
+    size_t i = 0;
+#if ADXL343_CONVERT_SIMD && defined(__SSE2__)
+    const __m128 factor_vector = _mm_set1_ps(factor);
+    for (; i + 8 <= length; i += 8){
+        __m128i v = _mm_loadu_si128((const __m128i*) &values[i]);
+        // Sign extend to 32 bit by shifting the duplicated halves back down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(&ms2[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), factor_vector));
+        _mm_storeu_ps(&ms2[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), factor_vector));
+    }
+#elif ADXL343_CONVERT_SIMD
+    for (; i + 8 <= length; i += 8){
+        int16x8_t v = vld1q_s16(&values[i]);
+        vst1q_f32(&ms2[i], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), factor));
+        vst1q_f32(&ms2[i + 4], vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), factor));
+    }
+#else
+    (void) values;
+    (void) ms2;
+    (void) length;
+    (void) factor;
+#endif
+    return i;
+}
+
+
+// Functions
+void adxl343_convert_mg(const ADXL343Settings* settings, const ADXL343Sample* samples, int32_t* mg, size_t count){
+    if (settings == NULL || samples == NULL || mg == NULL){return;}
+    const int16_t* values = (const int16_t*) samples;
+    const size_t length = 3 * count;
+    const int32_t scale = adxl343_make_decoder(settings->range, settings->resolution, 0x00).scale_mg_q8;
+
+    // Explicit SIMD head (if compiled in), the remainder is a loop the compiler can vectorize itself
+    size_t i = _convert_mg_simd(values, mg, length, (int16_t) scale);
+    for (; i < length; i++){
+        mg[i] = _convert_mg_round(values[i] * scale);
+    }
+}
+
+void adxl343_convert_ms2(const ADXL343Settings* settings, const ADXL343Sample* samples, float* ms2, size_t count){
+    if (settings == NULL || samples == NULL || ms2 == NULL){return;}
+    const int16_t* values = (const int16_t*) samples;
+    const size_t length = 3 * count;
+    const uint16_t scale = adxl343_make_decoder(settings->range, settings->resolution, 0x00).scale_mg_q8;
+    const float factor = (float) scale / 256.0f * ADXL343_STANDARD_GRAVITY / 1000.0f;
+
+    size_t i = _convert_ms2_simd(values, ms2, length, factor);
+    for (; i < length; i++){
+        ms2[i] = (float) values[i] * factor;
+    }
+}
@@ -3,299 +3,1570 @@
 /// \brief driver for adxl343 accelerometer
 // --------------------------------------------------------------------------------------------------------------------
 
-#include "adxl343_driver.h"
-#include <stdio.h>
-
 #ifdef UNITTEST
 #define i2c_write mock_i2c_write
 #define i2c_read mock_i2c_read
+#define i2c_write_read mock_i2c_write_read
+#define spi_transfer mock_spi_transfer
 #endif
 
+#include "adxl343_driver.h"
+#include "adxl343_ring.h"
+#include "adxl343_timeline.h"
+#include <stdio.h>
+#include <string.h>
+
 
 // Statics
-static ADXL343Settings adxl343_settings;
+const ADXL343Bus adxl343_i2c_bus = {i2c_write, i2c_read, i2c_write_read, i2c_submit};
+const ADXL343SpiBus adxl343_spi_bus = {spi_transfer};
 
-static FunctionStatus _adxl343_read(uint8_t register_address, size_t num_bytes,
-                                    char* return_data){
-    FunctionStatus result;
+// Register address of each ADXL343Config field, in address order
+static const struct {
+    uint8_t register_address;
+    size_t offset;
+} adxl343_config_map [] = {
+    {ADXL343_REG_THRESH_TAP, offsetof(ADXL343Config, thresh_tap)},
+    {ADXL343_REG_OFSX, offsetof(ADXL343Config, ofsx)},
+    {ADXL343_REG_OFSY, offsetof(ADXL343Config, ofsy)},
+    {ADXL343_REG_OFSZ, offsetof(ADXL343Config, ofsz)},
+    {ADXL343_REG_DUR, offsetof(ADXL343Config, dur)},
+    {ADXL343_REG_LATENT, offsetof(ADXL343Config, latent)},
+    {ADXL343_REG_WINDOW, offsetof(ADXL343Config, window)},
+    {ADXL343_REG_THRESH_ACT, offsetof(ADXL343Config, thresh_act)},
+    {ADXL343_REG_THRESH_INACT, offsetof(ADXL343Config, thresh_inact)},
+    {ADXL343_REG_TIME_INACT, offsetof(ADXL343Config, time_inact)},
+    {ADXL343_REG_ACT_INACT_CTL, offsetof(ADXL343Config, act_inact_ctl)},
+    {ADXL343_REG_THRESH_FF, offsetof(ADXL343Config, thresh_ff)},
+    {ADXL343_REG_TIME_FF, offsetof(ADXL343Config, time_ff)},
+    {ADXL343_REG_TAP_AXES, offsetof(ADXL343Config, tap_axes)},
+    {ADXL343_REG_BW_RATE, offsetof(ADXL343Config, bw_rate)},
+    {ADXL343_REG_POWER_CTL, offsetof(ADXL343Config, power_ctl)},
+    {ADXL343_REG_INT_ENABLE, offsetof(ADXL343Config, int_enable)},
+    {ADXL343_REG_INT_MAP, offsetof(ADXL343Config, int_map)},
+    {ADXL343_REG_DATA_FORMAT, offsetof(ADXL343Config, data_format)},
+    {ADXL343_REG_FIFO_CTL, offsetof(ADXL343Config, fifo_ctl)},
+};
+#define ADXL343_CONFIG_REGISTERS (sizeof(adxl343_config_map) / sizeof(adxl343_config_map[0]))
+_Static_assert(sizeof(ADXL343Sample) == 3 * sizeof(int16_t), "samples are decoded as strided axis arrays");
+_Static_assert(ADXL343_CONFIG_REGISTERS <= ADXL343_STEP_MAX_BURSTS, "step machine can not hold every burst");
+
+static ADXL343TimestampSource adxl343_timestamp_source = NULL;
+
+static inline uint64_t _adxl343_now(){
+    return (adxl343_timestamp_source != NULL) ? adxl343_timestamp_source() : 0;
+}
+
+// Bus statistics, empty (and removed by the compiler) without ADXL343_ENABLE_STATS
+static inline uint64_t _adxl343_stats_now(){
+#ifdef ADXL343_ENABLE_STATS
+    return _adxl343_now();
+#else
+    return 0;
+#endif
+}
 
-    // Initialise read process
+static inline void _adxl343_stats_record(ADXL343Device* device, uint8_t is_read, size_t num_bytes,
+                                         FunctionStatus status, uint64_t start){
+#ifdef ADXL343_ENABLE_STATS
+    ADXL343OpStats* stats = is_read ? &device->stats.read : &device->stats.write;
+    uint64_t latency = _adxl343_stats_now() - start;
+    uint8_t bucket = 0;
+    // Bucket is the bit length of the latency
+    while (bucket < ADXL343_STATS_BUCKETS - 1 && (latency >> bucket) != 0){
+        bucket++;
+    }
+    stats->transactions++;
+    stats->bytes += (uint32_t) num_bytes;
+    stats->status[((unsigned) status < ADXL343_STATS_STATUSES) ? status : FUNCTION_STATUS_ERROR]++;
+    stats->latency[bucket]++;
+    if (latency > stats->latency_max){
+        stats->latency_max = latency;
+    }
+#else
+    (void) device;
+    (void) is_read;
+    (void) num_bytes;
+    (void) status;
+    (void) start;
+#endif
+}
+
+// I2C transport, [device address, register address] then the data
+static FunctionStatus _adxl343_i2c_read(const ADXL343Device* device, uint8_t register_address, size_t num_bytes,
+                                        char* return_data){
+    // Set the register pointer and read the data back in one repeated-start transaction
     char dataToWrite [2];
-    dataToWrite[0] = ADXL343_ADDRESS_I2CWRITE;
+    dataToWrite[0] = (char) (device->address << 1);
     dataToWrite[1] = register_address;
-    result = i2c_write(dataToWrite, sizeof(dataToWrite), ADXL343_DEFAULT_TIMEOUT); 
-    if (result != FUNCTION_STATUS_OK){return result;}
 
-    // Start read of data
-    char dataToRead [1];
-    dataToRead [0] = ADXL343_ADDRESS_I2CREAD;
-    result = i2c_write(dataToWrite, sizeof(dataToRead), ADXL343_DEFAULT_TIMEOUT);
+    return device->bus->write_read(dataToWrite, sizeof(dataToWrite), return_data, num_bytes,
+                                   ADXL343_DEFAULT_TIMEOUT * (num_bytes + 1));
+}
+
+static FunctionStatus _adxl343_i2c_write(const ADXL343Device* device, uint8_t register_address, const uint8_t* data,
+                                         size_t num_bytes){
+    // Register pointer auto increments, so consecutive registers go out in one transaction
+    char dataToWrite [2 + ADXL343_MAX_BURST];
+    dataToWrite[0] = (char) (device->address << 1);
+    dataToWrite[1] = register_address;
+    memcpy(&dataToWrite[2], data, num_bytes);
+
+    return device->bus->write(dataToWrite, 2 + num_bytes, ADXL343_DEFAULT_TIMEOUT);
+}
+
+// SPI transport, [R/W | MB | register address] then the data, in one chip select cycle
+static FunctionStatus _adxl343_spi_read(const ADXL343Device* device, uint8_t register_address, size_t num_bytes,
+                                        char* return_data){
+    FunctionStatus result;
+    if (num_bytes > ADXL343_REG_MAP_SIZE){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    // Dummy bytes clock the data out, MB keeps the address incrementing past the first byte
+    char dataToWrite [1 + ADXL343_REG_MAP_SIZE] = {0};
+    char dataToRead [1 + ADXL343_REG_MAP_SIZE];
+    dataToWrite[0] = (char) (ADXL343_SPI_READ | ((num_bytes > 1) ? ADXL343_SPI_MULTI_BYTE : 0) |
+                             (register_address & 0x3F));
+
+    result = device->spi->transfer(dataToWrite, dataToRead, 1 + num_bytes, ADXL343_DEFAULT_TIMEOUT);
     if (result != FUNCTION_STATUS_OK){return result;}
+    memcpy(return_data, &dataToRead[1], num_bytes);
 
-    // Receive data into the return_data buffer
-    result = i2c_read(return_data, num_bytes, ADXL343_DEFAULT_TIMEOUT * num_bytes);
-    
     return FUNCTION_STATUS_OK;
 }
 
-static FunctionStatus _adxl343_write(uint8_t register_address, uint8_t data){
-    char dataToWrite [3];
-    dataToWrite[0] = ADXL343_ADDRESS_I2CWRITE;
-    dataToWrite[1] = register_address;
-    dataToWrite[2] = data;
+static FunctionStatus _adxl343_spi_write(const ADXL343Device* device, uint8_t register_address, const uint8_t* data,
+                                         size_t num_bytes){
+    char dataToWrite [1 + ADXL343_MAX_BURST];
+    dataToWrite[0] = (char) (((num_bytes > 1) ? ADXL343_SPI_MULTI_BYTE : 0) | (register_address & 0x3F));
+    memcpy(&dataToWrite[1], data, num_bytes);
+
+    return device->spi->transfer(dataToWrite, NULL, 1 + num_bytes, ADXL343_DEFAULT_TIMEOUT);
+}
+
+const ADXL343Transport adxl343_i2c_transport = {_adxl343_i2c_read, _adxl343_i2c_write};
+const ADXL343Transport adxl343_spi_transport = {_adxl343_spi_read, _adxl343_spi_write};
+
+static FunctionStatus _adxl343_read(ADXL343Device* device, uint8_t register_address, size_t num_bytes,
+                                    char* return_data){
+    FunctionStatus result;
+    uint64_t start = _adxl343_stats_now();
+    result = device->transport->read(device, register_address, num_bytes, return_data);
+    _adxl343_stats_record(device, 1, num_bytes, result, start);
+
+    return result;
+}
+
+static FunctionStatus _adxl343_write_burst(ADXL343Device* device, uint8_t register_address, const uint8_t* data,
+                                          size_t num_bytes){
+    FunctionStatus result;
+    if (num_bytes == 0 || num_bytes > ADXL343_MAX_BURST){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+
+    uint64_t start = _adxl343_stats_now();
+    result = device->transport->write(device, register_address, data, num_bytes);
+    _adxl343_stats_record(device, 0, num_bytes, result, start);
+    if (result != FUNCTION_STATUS_OK){
+        // Unknown whether the device took the values, force a resync before the shadow is used again
+        device->shadow_valid = 0x00;
+        return result;
+    }
+    memcpy(&device->shadow[register_address], data, num_bytes);
 
-    return i2c_write(dataToWrite, sizeof(dataToWrite), ADXL343_DEFAULT_TIMEOUT);
+    return FUNCTION_STATUS_OK;
 }
 
-static void _clean_accelerometer_data(char* data){
-    // Finding resolution in number of bits
-    uint16_t cleaned_data;
-    uint8_t resolution = 10;
-    uint16_t resolution_mask = 1;
-    if (adxl343_settings.resolution == 0x01){
-        resolution += adxl343_settings.range;
+static FunctionStatus _adxl343_write(ADXL343Device* device, uint8_t register_address, uint8_t data){
+    return _adxl343_write_burst(device, register_address, &data, 1);
+}
+
+static void _adxl343_settings_from_shadow(ADXL343Device* device){
+    device->settings.measurement_mode = (device->shadow[ADXL343_REG_POWER_CTL] >> 3) & 0x01;
+    device->settings.rate = device->shadow[ADXL343_REG_BW_RATE] & 0x0F;
+    device->settings.range = device->shadow[ADXL343_REG_DATA_FORMAT] & 0x03;
+    device->settings.resolution = (device->shadow[ADXL343_REG_DATA_FORMAT] >> 3) & 0x01;
+    device->settings.bit_order = (device->shadow[ADXL343_REG_DATA_FORMAT] >> 2) & 0x01;
+    device->settings.fifo_mode = (device->shadow[ADXL343_REG_FIFO_CTL] >> 6) & 0x03;
+    device->settings.fifo_samples = device->shadow[ADXL343_REG_FIFO_CTL] & ADXL343_FIFO_SAMPLES_MASK;
+    for (uint8_t axis = 0; axis < 3; axis++){
+        device->settings.offset[axis] = (int8_t) device->shadow[ADXL343_REG_OFSX + axis];
     }
-    for (int i = 0; i < resolution; i++){
-        resolution_mask *= 2;
+    device->settings.low_power = (device->shadow[ADXL343_REG_BW_RATE] & ADXL343_LOW_POWER) ? 0x01 : 0x00;
+    device->settings.link = (device->shadow[ADXL343_REG_POWER_CTL] & ADXL343_POWER_LINK) ? 0x01 : 0x00;
+    device->settings.auto_sleep = (device->shadow[ADXL343_REG_POWER_CTL] & ADXL343_POWER_AUTO_SLEEP) ? 0x01 : 0x00;
+    device->settings.wakeup = device->shadow[ADXL343_REG_POWER_CTL] & 0x03;
+    device->decoder = adxl343_make_decoder(device->settings.range, device->settings.resolution,
+                                           device->settings.bit_order);
+}
+
+static void _adxl343_config_from_shadow(const ADXL343Device* device, ADXL343Config* config){
+    for (size_t i = 0; i < ADXL343_CONFIG_REGISTERS; i++){
+        ((uint8_t*) config)[adxl343_config_map[i].offset] = device->shadow[adxl343_config_map[i].register_address];
     }
-    resolution_mask -= 1;
-    // Ordering data to match bit-order
-    if (adxl343_settings.bit_order == 0x00){
-        // Data is right justified (note data is signed)
-        cleaned_data = ((((resolution_mask >> 8) & data[1]) << 8) | 0xFF & data[0]);
-    } else {
-        // Data is left justified
-        cleaned_data = (((data[1] << 8) | (0xFF & data[0])) >> (16 - resolution));
+}
+
+static inline uint64_t _adxl343_period_ns(uint8_t rate){
+    // 3200 Hz at rate 0x0F, halved with every step below
+    return (1000000000ull << (15 - (rate & 0x0F))) / 3200;
+}
+
+static uint64_t _adxl343_calibration_budget_ns(uint64_t period_ns, size_t remaining){
+    // The samples still wanted, 1/8 on top for an output data rate below nominal, and a margin
+    return ((uint64_t) remaining + remaining / 8 + ADXL343_CALIBRATION_MARGIN) * period_ns;
+}
+
+static int32_t _adxl343_offset_from_error(int64_t error_mg_q8, size_t num_samples){
+    // Offset that cancels the average error, rounded to the nearest 15.6 mg step and clamped to the 8 bit register
+    int64_t numerator = -error_mg_q8 * 64;
+    int64_t denominator = (int64_t) ADXL343_OFFSET_UNIT_MG_Q6 * 256 * (int64_t) num_samples;
+    int64_t offset = (numerator + ((numerator < 0) ? -denominator / 2 : denominator / 2)) / denominator;
+    if (offset > INT8_MAX){
+        offset = INT8_MAX;
+    } else if (offset < INT8_MIN){
+        offset = INT8_MIN;
+    }
+    return (int32_t) offset;
+}
+
+static FunctionStatus _adxl343_edit_config(ADXL343Device* device, ADXL343Config* config){
+    FunctionStatus result;
+    // Current configuration as the base of a change applied with adxl343_apply_config
+    if (!device->shadow_valid){
+        result = adxl343_resync_shadow(device);
+        if (result != FUNCTION_STATUS_OK){return result;}
+    }
+    _adxl343_config_from_shadow(device, config);
+
+    return FUNCTION_STATUS_OK;
+}
+
+static uint8_t _adxl343_to_register(uint32_t value, uint32_t unit){
+    // Nearest register step, saturating at the 8 bit register
+    uint32_t steps = value / unit + ((value % unit >= (unit + 1) / 2) ? 1 : 0);
+    return (steps > 0xFF) ? 0xFF : (uint8_t) steps;
+}
+
+static void _adxl343_activity_to_config(const ADXL343ActivityConfig* activity, ADXL343Config* config){
+    config->thresh_act = _adxl343_to_register((uint32_t) activity->threshold_mg * 1000, ADXL343_THRESH_UNIT_UG);
+    uint8_t control = (activity->axes & ADXL343_AXIS_ALL) | (activity->ac_coupled ? ADXL343_ACT_AC_COUPLED : 0x00);
+    config->act_inact_ctl = (uint8_t) ((config->act_inact_ctl & 0x0F) | (control << 4));
+}
+
+static void _adxl343_inactivity_to_config(const ADXL343InactivityConfig* inactivity, ADXL343Config* config){
+    config->thresh_inact = _adxl343_to_register((uint32_t) inactivity->threshold_mg * 1000, ADXL343_THRESH_UNIT_UG);
+    config->time_inact = inactivity->time_s;
+    uint8_t control = (inactivity->axes & ADXL343_AXIS_ALL) | (inactivity->ac_coupled ? ADXL343_ACT_AC_COUPLED : 0x00);
+    config->act_inact_ctl = (uint8_t) ((config->act_inact_ctl & 0xF0) | control);
+}
+
+static void _adxl343_wake_to_config(const ADXL343WakeProfile* profile, uint8_t active, ADXL343Config* config){
+    // Rate and watermark of the active or idle state, the rest of BW_RATE and FIFO_CTL is kept
+    uint8_t rate = active ? profile->active_rate : profile->idle_rate;
+    uint8_t low_power = (!active && profile->idle_low_power) ? ADXL343_LOW_POWER : 0x00;
+    uint8_t watermark = active ? profile->active_watermark : profile->idle_watermark;
+    config->bw_rate = (uint8_t) ((config->bw_rate & ~(ADXL343_LOW_POWER | 0x0F)) | low_power | rate);
+    config->fifo_ctl = (uint8_t) ((config->fifo_ctl & ~ADXL343_FIFO_SAMPLES_MASK) | watermark);
+}
+
+static void _adxl343_decode_event_status(uint8_t act_tap_status, ADXL343EventStatus* status){
+    status->activity_axes = (act_tap_status >> 4) & ADXL343_AXIS_ALL;
+    status->asleep = (act_tap_status >> 3) & 0x01;
+    status->tap_axes = act_tap_status & ADXL343_AXIS_ALL;
+}
+
+static FunctionStatus _adxl343_update_register(ADXL343Device* device, uint8_t register_address, uint8_t reg_mask,
+                                               uint8_t value){
+    FunctionStatus result;
+    // Read-modify-write against the shadow, the device is only read if the shadow is not trusted
+    if (!device->shadow_valid){
+        result = adxl343_resync_shadow(device);
+        if (result != FUNCTION_STATUS_OK){return result;}
     }
+    uint8_t register_value = (device->shadow[register_address] & ~reg_mask) | (value & reg_mask);
+
+    return _adxl343_write(device, register_address, register_value);
+}
+
+static inline int16_t _adxl343_decode_axis(const ADXL343Decoder* decoder, const uint8_t* raw){
+    // Move the sample's sign bit up to bit 15, then shift back down arithmetically to sign extend
+    uint16_t raw_value = (uint16_t) (raw[0] | (raw[1] << 8));
+    return (int16_t) (uint16_t) (raw_value << decoder->left_shift) >> decoder->right_shift;
+}
 
+static void _adxl343_store_axis(const ADXL343Decoder* decoder, char* data){
+    // Right justified and masked to the resolution, LSByte first
+    uint16_t cleaned_data = (uint16_t) _adxl343_decode_axis(decoder, (const uint8_t*) data) & decoder->mask;
     data[0] = (char) (cleaned_data & 0xFF);
     data[1] = (char) (cleaned_data >> 8);
 }
 
 
+static inline void _adxl343_decode_strided(const ADXL343Decoder* decoder, const uint8_t* raw, size_t count,
+                                           int16_t* x, int16_t* y, int16_t* z, size_t stride){
+    for (size_t i = 0; i < count; i++){
+        x[i * stride] = _adxl343_decode_axis(decoder, &raw[6 * i + 0]);
+        y[i * stride] = _adxl343_decode_axis(decoder, &raw[6 * i + 2]);
+        z[i * stride] = _adxl343_decode_axis(decoder, &raw[6 * i + 4]);
+    }
+}
+
+static FunctionStatus _adxl343_pop_fifo_strided(ADXL343Device* device, int16_t* x, int16_t* y, int16_t* z,
+                                                size_t stride, size_t n, size_t* count){
+    FunctionStatus result;
+    // Each 6 byte burst of DATAX0..DATAZ1 pops one entry from the FIFO
+    uint8_t raw [6];
+    for (size_t i = 0; i < n; i++){
+        result = _adxl343_read(device, ADXL343_DATA_X_0, sizeof(raw), (char*) raw);
+        if (result != FUNCTION_STATUS_OK){return result;}
+        _adxl343_decode_strided(&device->decoder, raw, 1, &x[i * stride], &y[i * stride], &z[i * stride], stride);
+        if (count != NULL){
+            *count = i + 1;
+        }
+    }
+
+    return FUNCTION_STATUS_OK;
+}
+
+static FunctionStatus _adxl343_pop_fifo(ADXL343Device* device, ADXL343Sample* samples, size_t n, size_t* count){
+    // An array of samples is three interleaved axis arrays with a stride of 3
+    return _adxl343_pop_fifo_strided(device, &samples->x, &samples->y, &samples->z, 3, n, count);
+}
+
+
+static size_t _adxl343_plan_bursts(const ADXL343Device* device, const ADXL343Config* config, uint8_t* target,
+                                   uint8_t bursts[][2]){
+    // Target register image and which registers differ from the shadow
+    uint8_t dirty [ADXL343_REG_MAP_SIZE] = {0};
+    memcpy(target, device->shadow, ADXL343_REG_MAP_SIZE);
+    for (size_t i = 0; i < ADXL343_CONFIG_REGISTERS; i++){
+        uint8_t reg = adxl343_config_map[i].register_address;
+        target[reg] = ((const uint8_t*) config)[adxl343_config_map[i].offset];
+        dirty[reg] = !device->shadow_valid || target[reg] != device->shadow[reg];
+    }
+
+    // Group dirty registers into bursts over contiguous writable registers
+    size_t num_bursts = 0;
+    size_t i = 0;
+    while (i < ADXL343_CONFIG_REGISTERS){
+        if (!dirty[adxl343_config_map[i].register_address]){
+            i++;
+            continue;
+        }
+        size_t first = i;
+        size_t last = i;
+        for (size_t j = i + 1; j < ADXL343_CONFIG_REGISTERS; j++){
+            // Stop at read-only gaps, the register map has to stay contiguous
+            if (adxl343_config_map[j].register_address != adxl343_config_map[j - 1].register_address + 1){break;}
+            if ((size_t) (adxl343_config_map[j].register_address -
+                          adxl343_config_map[first].register_address) >= ADXL343_MAX_BURST){break;}
+            if (dirty[adxl343_config_map[j].register_address]){
+                last = j;
+            } else if (j - last > ADXL343_BURST_BRIDGE){
+                break;
+            }
+        }
+        bursts[num_bursts][0] = adxl343_config_map[first].register_address;
+        bursts[num_bursts][1] = adxl343_config_map[last].register_address - bursts[num_bursts][0] + 1;
+        num_bursts++;
+        i = last + 1;
+    }
+
+    return num_bursts;
+}
+
+static void _adxl343_async_prepare(ADXL343AsyncOp* op, ADXL343Device* device, ADXL343AsyncCallback callback,
+                                   void* context){
+    op->device = device;
+    op->callback = callback;
+    op->context = context;
+    op->submitted = 0;
+    op->completed = 0;
+    op->available = 0;
+    op->scheduled = 0;
+    op->status = FUNCTION_STATUS_PENDING;
+}
+
+static FunctionStatus _adxl343_async_submit(ADXL343AsyncOp* op, uint8_t register_address, size_t write_length,
+                                            size_t read_length, I2CCompletionCallback done){
+    FunctionStatus result;
+    if (op->submitted >= ADXL343_ASYNC_TRANSACTIONS){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    // Frame is [device address, register address, data...], the payload is filled in by the caller
+    I2CTransaction* transaction = &op->transactions[op->submitted];
+    uint8_t* frame = op->frames[op->submitted];
+    frame[0] = (uint8_t) (op->device->address << 1);
+    frame[1] = register_address;
+    transaction->type = (read_length > 0) ? I2C_TRANSACTION_WRITE_READ : I2C_TRANSACTION_WRITE;
+    transaction->dataToWrite = (const char*) frame;
+    transaction->writeLength = write_length;
+    transaction->dataToRead = (char*) op->data[op->submitted];
+    transaction->readLength = read_length;
+    transaction->timeout = ADXL343_DEFAULT_TIMEOUT * (write_length + read_length);
+    transaction->callback = done;
+    transaction->context = op;
+
+#ifdef ADXL343_ENABLE_STATS
+    op->submitted_at[op->submitted] = _adxl343_stats_now();
+#endif
+    result = op->device->bus->submit(transaction);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    op->submitted++;
+
+    return FUNCTION_STATUS_OK;
+}
+
+static void _adxl343_async_record(ADXL343AsyncOp* op, const I2CTransaction* transaction){
+    // Latency of a queued transaction runs from its submit to its completion callback
+#ifdef ADXL343_ENABLE_STATS
+    size_t index = (size_t) (transaction - op->transactions);
+    _adxl343_stats_record(op->device, transaction->readLength > 0,
+                          (transaction->readLength > 0) ? transaction->readLength : transaction->writeLength - 2,
+                          transaction->status, op->submitted_at[index]);
+#else
+    (void) op;
+    (void) transaction;
+#endif
+}
+
+static void _adxl343_async_complete(ADXL343AsyncOp* op, size_t count){
+    if (op->status == FUNCTION_STATUS_PENDING){
+        op->status = FUNCTION_STATUS_OK;
+    }
+    if (op->callback != NULL){
+        op->callback(op->device, op->status, count, op->context);
+    }
+}
+
+static void _adxl343_drain_async_finish(ADXL343AsyncOp* op){
+    // Entries are read in order, decode up to the first one that failed
+    size_t count = 0;
+    for (size_t i = 1; i < op->submitted && op->transactions[i].status == FUNCTION_STATUS_OK; i++){
+        adxl343_decode(&op->device->decoder, op->data[i], &op->samples[count], 1);
+        count++;
+    }
+    _adxl343_async_complete(op, count);
+}
+
+static void _adxl343_drain_async_entry_done(I2CTransaction* transaction, void* context){
+    ADXL343AsyncOp* op = context;
+    _adxl343_async_record(op, transaction);
+    op->completed++;
+    if (transaction->status != FUNCTION_STATUS_OK && op->status == FUNCTION_STATUS_PENDING){
+        op->status = transaction->status;
+    }
+    if (op->completed == op->submitted){
+        _adxl343_drain_async_finish(op);
+    }
+}
+
+static void _adxl343_drain_async_status_done(I2CTransaction* transaction, void* context){
+    FunctionStatus result;
+    ADXL343AsyncOp* op = context;
+    _adxl343_async_record(op, transaction);
+    op->completed++;
+    if (transaction->status != FUNCTION_STATUS_OK){
+        op->status = transaction->status;
+        _adxl343_async_complete(op, 0);
+        return;
+    }
+    // Each 6 byte read of DATAX0..DATAZ1 pops one entry, all of them are queued at once
+    size_t entries = op->data[0][0] & ADXL343_FIFO_ENTRIES_MASK;
+    op->available = entries;
+    if (entries > op->max){
+        entries = op->max;
+    }
+    if (entries > ADXL343_ASYNC_TRANSACTIONS - 1){
+        entries = ADXL343_ASYNC_TRANSACTIONS - 1;
+    }
+    for (size_t i = 0; i < entries; i++){
+        result = _adxl343_async_submit(op, ADXL343_DATA_X_0, 2, 6, _adxl343_drain_async_entry_done);
+        if (result != FUNCTION_STATUS_OK){
+            op->status = result;
+            break;
+        }
+        op->scheduled++;
+    }
+    if (op->completed == op->submitted){
+        _adxl343_drain_async_finish(op);
+    }
+}
+
+static void _adxl343_config_async_finish(ADXL343AsyncOp* op){
+    if (op->status == FUNCTION_STATUS_PENDING){
+        op->device->shadow_valid = 0x01;
+        _adxl343_settings_from_shadow(op->device);
+    }
+    _adxl343_async_complete(op, op->completed);
+}
+
+static void _adxl343_config_async_done(I2CTransaction* transaction, void* context){
+    ADXL343AsyncOp* op = context;
+    _adxl343_async_record(op, transaction);
+    op->completed++;
+    if (transaction->status == FUNCTION_STATUS_OK){
+        const uint8_t* frame = (const uint8_t*) transaction->dataToWrite;
+        memcpy(&op->device->shadow[frame[1]], &frame[2], transaction->writeLength - 2);
+    } else {
+        // Unknown whether the device took the values, force a resync before the shadow is used again
+        op->device->shadow_valid = 0x00;
+        if (op->status == FUNCTION_STATUS_PENDING){
+            op->status = transaction->status;
+        }
+    }
+    if (op->completed == op->submitted){
+        _adxl343_config_async_finish(op);
+    }
+}
+
+static void _adxl343_step_done(I2CTransaction* transaction, void* context){
+    ADXL343Machine* machine = context;
+#ifdef ADXL343_ENABLE_STATS
+    _adxl343_stats_record(machine->device, transaction->readLength > 0,
+                          (transaction->readLength > 0) ? transaction->readLength : transaction->writeLength - 2,
+                          transaction->status, machine->submitted_at);
+#else
+    (void) transaction;
+#endif
+    machine->completed = 1;
+}
+
+static void _adxl343_step_prepare(ADXL343Machine* machine, ADXL343Device* device, uint8_t state){
+    memset(machine, 0x00, sizeof(ADXL343Machine));
+    machine->device = device;
+    machine->state = state;
+    machine->status = FUNCTION_STATUS_PENDING;
+}
+
+static FunctionStatus _adxl343_step_submit(ADXL343Machine* machine, uint8_t register_address, size_t write_length,
+                                           size_t read_length){
+    FunctionStatus result;
+    // Frame is [device address, register address, data...], the payload is filled in by the caller
+    I2CTransaction* transaction = &machine->transaction;
+    machine->frame[0] = (uint8_t) (machine->device->address << 1);
+    machine->frame[1] = register_address;
+    transaction->type = (read_length > 0) ? I2C_TRANSACTION_WRITE_READ : I2C_TRANSACTION_WRITE;
+    transaction->dataToWrite = (const char*) machine->frame;
+    transaction->writeLength = write_length;
+    transaction->dataToRead = (char*) machine->data;
+    transaction->readLength = read_length;
+    transaction->timeout = ADXL343_DEFAULT_TIMEOUT * (write_length + read_length);
+    transaction->callback = _adxl343_step_done;
+    transaction->context = machine;
+    machine->completed = 0;
+
+#ifdef ADXL343_ENABLE_STATS
+    machine->submitted_at = _adxl343_stats_now();
+#endif
+    result = machine->device->bus->submit(transaction);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    machine->in_flight = 1;
+
+    return FUNCTION_STATUS_OK;
+}
+
+static void _adxl343_step_finish(ADXL343Machine* machine, FunctionStatus status){
+    if (machine->state == ADXL343_STEP_CONFIG){
+        if (status == FUNCTION_STATUS_OK){
+            machine->device->shadow_valid = 0x01;
+            _adxl343_settings_from_shadow(machine->device);
+        } else {
+            // Unknown whether the device took the values, force a resync before the shadow is used again
+            machine->device->shadow_valid = 0x00;
+        }
+    }
+    machine->state = ADXL343_STEP_DONE;
+    machine->status = status;
+}
+
+static void _adxl343_step_complete(ADXL343Machine* machine){
+    FunctionStatus status = machine->transaction.status;
+    machine->in_flight = 0;
+    if (status != FUNCTION_STATUS_OK){
+        _adxl343_step_finish(machine, status);
+        return;
+    }
+    switch (machine->state){
+    case ADXL343_STEP_DRAIN_STATUS:
+        machine->entries = machine->data[0] & ADXL343_FIFO_ENTRIES_MASK;
+        if (machine->entries > machine->max){
+            machine->entries = machine->max;
+        }
+        machine->state = ADXL343_STEP_DRAIN_ENTRY;
+        if (machine->entries == 0){
+            _adxl343_step_finish(machine, FUNCTION_STATUS_OK);
+        }
+        break;
+    case ADXL343_STEP_DRAIN_ENTRY:
+        adxl343_decode(&machine->device->decoder, machine->data, &machine->samples[machine->count], 1);
+        machine->count++;
+        if (machine->count == machine->entries){
+            _adxl343_step_finish(machine, FUNCTION_STATUS_OK);
+        }
+        break;
+    case ADXL343_STEP_CONFIG:
+        memcpy(&machine->device->shadow[machine->frame[1]], &machine->frame[2], machine->transaction.writeLength - 2);
+        machine->burst++;
+        if (machine->burst == machine->num_bursts){
+            _adxl343_step_finish(machine, FUNCTION_STATUS_OK);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static FunctionStatus _adxl343_step_next(ADXL343Machine* machine){
+    switch (machine->state){
+    case ADXL343_STEP_DRAIN_STATUS:
+        return _adxl343_step_submit(machine, ADXL343_REG_FIFO_STATUS, 2, 1);
+    case ADXL343_STEP_DRAIN_ENTRY:
+        // Each 6 byte read of DATAX0..DATAZ1 pops one entry
+        return _adxl343_step_submit(machine, ADXL343_DATA_X_0, 2, 6);
+    case ADXL343_STEP_CONFIG: {
+        uint8_t first = machine->bursts[machine->burst][0];
+        uint8_t length = machine->bursts[machine->burst][1];
+        memcpy(&machine->frame[2], &machine->target[first], length);
+        return _adxl343_step_submit(machine, first, 2 + length, 0);
+    }
+    default:
+        return FUNCTION_STATUS_ERROR;
+    }
+}
+
+static FunctionStatus _adxl343_configure_defaults(ADXL343Device* device){
+    ADXL343Config config;
+    // Nothing is known about the device yet, so the whole configuration block is written
+    device->shadow_valid = 0x00;
+    adxl343_get_default_config(&config);
+
+    return adxl343_apply_config(device, &config);
+}
+
+
 // Functions
-FunctionStatus adxl343_init(){
+FunctionStatus adxl343_init(ADXL343Device* device, const ADXL343Bus* bus, uint8_t address){
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (address > ADXL343_ADDRESS_I2C_MAX){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+
+    // Bind the device to its bus, the driver's own i2c_driver binding by default
+    memset(device, 0x00, sizeof(ADXL343Device));
+    device->transport = &adxl343_i2c_transport;
+    device->bus = (bus != NULL) ? bus : &adxl343_i2c_bus;
+    device->address = address;
+
+    return _adxl343_configure_defaults(device);
+}
+
+FunctionStatus adxl343_init_spi(ADXL343Device* device, const ADXL343SpiBus* spi){
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+
+    // Bind the device to its bus, the driver's own spi_driver binding by default
+    memset(device, 0x00, sizeof(ADXL343Device));
+    device->transport = &adxl343_spi_transport;
+    device->spi = (spi != NULL) ? spi : &adxl343_spi_bus;
+
+    return _adxl343_configure_defaults(device);
+}
+
+FunctionStatus adxl343_start(ADXL343Device* device){
     FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Updating power_ctl register value to set measurement mode (D3) to active
+    result = _adxl343_update_register(device, ADXL343_REG_POWER_CTL, 0x08, 0x08);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    device->settings.measurement_mode = 0x01;
 
-    // Apply default settings to settings structure
-    adxl343_settings.measurement_mode = 0x00;
-    adxl343_settings.rate = ADXL343_DEFAULT_RATE;
-    adxl343_settings.range = ADXL343_DEFAULT_RANGE;
-    adxl343_settings.resolution = ADXL343_DEFAULT_RESOLUTION;
-    adxl343_settings.bit_order = ADXL343_DEFAULT_BITORDER;
+    return FUNCTION_STATUS_OK;
+}
 
-    // Configure data rate (default) - set in BW_RATE
-    result = adxl343_set_rate(ADXL343_DEFAULT_RATE);
+FunctionStatus adxl343_stop(ADXL343Device* device){
+    FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Updating power_ctl register value to set measurement mode (D3) to standby
+    result = _adxl343_update_register(device, ADXL343_REG_POWER_CTL, 0x08, 0x00);
     if (result != FUNCTION_STATUS_OK){return result;}
+    device->settings.measurement_mode = 0x00;
 
-    // Configure power control modes - sleep, measurement, auto_sleep
-    result = _adxl343_write(ADXL343_REG_POWER_CTL, ADXL343_DEFAULT_POWERCTRL);
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_set_rate(ADXL343Device* device, uint8_t rate){
+    FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Updating bw_rate register value to the new rate (D3:D0)
+    result = _adxl343_update_register(device, ADXL343_REG_BW_RATE, 0x0F, rate);
     if (result != FUNCTION_STATUS_OK){return result;}
-    
-    // Configuring DATA_FORMAT register (bit order, range, resolution)
-    uint8_t data_format_value = 0x00 |
-                                (ADXL343_DEFAULT_RESOLUTION << 3) |
-                                (ADXL343_DEFAULT_BITORDER << 2) |
-                                (ADXL343_DEFAULT_RANGE);
-    result = _adxl343_write(ADXL343_REG_DATA_FORMAT, data_format_value);
+    device->settings.rate = rate & 0x0F;
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_set_low_power(ADXL343Device* device, uint8_t enable){
+    FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Updating bw_rate register value to the new power mode (D4)
+    result = _adxl343_update_register(device, ADXL343_REG_BW_RATE, ADXL343_LOW_POWER, enable ? ADXL343_LOW_POWER : 0x00);
     if (result != FUNCTION_STATUS_OK){return result;}
+    device->settings.low_power = enable ? 0x01 : 0x00;
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_start(){
+FunctionStatus adxl343_set_range(ADXL343Device* device, uint8_t range){
     FunctionStatus result;
-    uint8_t reg_mask = 0xF7;
-    uint8_t register_value;
-    // Get current register (POWER_CTL) value
-    result = _adxl343_read(ADXL343_REG_POWER_CTL, 1, &register_value);
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Updating data_format register value to include the new range (D1:D0)
+    result = _adxl343_update_register(device, ADXL343_REG_DATA_FORMAT, 0x03, range);
     if (result != FUNCTION_STATUS_OK){return result;}
+    device->settings.range = range & 0x03;
+    device->decoder = adxl343_make_decoder(device->settings.range, device->settings.resolution,
+                                           device->settings.bit_order);
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_set_resolution_fixed(ADXL343Device* device){
+    FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Updated data_format register value to the set 10bit fixed resolution mode (D3)
+    result = _adxl343_update_register(device, ADXL343_REG_DATA_FORMAT, 0x08, 0x00);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    device->settings.resolution = 0x00;
+    device->decoder = adxl343_make_decoder(device->settings.range, device->settings.resolution,
+                                           device->settings.bit_order);
+
+    return FUNCTION_STATUS_OK;
+}
 
-    // Updating power_ctl register value to set measurement mode to active
-    register_value = (register_value & reg_mask) | (1 << 0x08);
-    // Send packet to ADXL343
-    result = _adxl343_write(ADXL343_REG_POWER_CTL, register_value);
+FunctionStatus adxl343_set_resolution_full(ADXL343Device* device){
+    FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Updating data_format register value to set full resolution mode (D3)
+    result = _adxl343_update_register(device, ADXL343_REG_DATA_FORMAT, 0x08, 0x08);
     if (result != FUNCTION_STATUS_OK){return result;}
+    device->settings.resolution = 0x01;
+    device->decoder = adxl343_make_decoder(device->settings.range, device->settings.resolution,
+                                           device->settings.bit_order);
 
-    adxl343_settings.measurement_mode = 0x01;
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_set_bit_order(ADXL343Device* device, uint8_t bit_order){
+    FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Updating data_format register value to set bit order (D2)
+    result = _adxl343_update_register(device, ADXL343_REG_DATA_FORMAT, 0x04, bit_order << 2);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    device->settings.bit_order = bit_order & 0x01;
+    device->decoder = adxl343_make_decoder(device->settings.range, device->settings.resolution,
+                                           device->settings.bit_order);
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_stop(){
+FunctionStatus adxl343_get_X_axis(ADXL343Device* device, char* data){
     FunctionStatus result;
-    uint8_t reg_mask = 0xF7;
-    uint8_t register_value;
-    // Get current register (POWER_CTL) value
-    result = _adxl343_read(ADXL343_REG_POWER_CTL, 1, &register_value);
+    if (device == NULL || data == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Read in values from the X axis 
+    result = _adxl343_read(device, ADXL343_DATA_X_0, 2, data);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Updating power_ctl register value to set measurement mode to standby
-    register_value = (register_value & reg_mask) | (0 << 0x08);
-    // Send packet to ADXL343
-    result = _adxl343_write(ADXL343_REG_POWER_CTL, register_value);
+    // Clean the data according to device settings
+    _adxl343_store_axis(&device->decoder, data);
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_get_Y_axis(ADXL343Device* device, char* data){
+    FunctionStatus result;
+    if (device == NULL || data == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Read in values from the Y axis 
+    result = _adxl343_read(device, ADXL343_DATA_Y_0, 2, data);
     if (result != FUNCTION_STATUS_OK){return result;}
+    // Clean the data according to device settings
+    _adxl343_store_axis(&device->decoder, data);
     
-    adxl343_settings.measurement_mode = 0x00;
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_get_Z_axis(ADXL343Device* device, char* data){
+    FunctionStatus result;
+    if (device == NULL || data == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Read in values from the Z axis 
+    result = _adxl343_read(device, ADXL343_DATA_Z_0, 2, data);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    // Clean the data according to device settings
+    _adxl343_store_axis(&device->decoder, data);
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_set_rate(uint8_t rate){
+FunctionStatus adxl343_get_all_axes(ADXL343Device* device, char* data){
     FunctionStatus result;
-    // Writing to ADXL343
-    result = _adxl343_write(ADXL343_REG_BW_RATE, rate);
+    if (device == NULL || data == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Read in values from all axes
+    result = _adxl343_read(device, ADXL343_DATA_X_0, 6, data);
     if (result != FUNCTION_STATUS_OK){return result;}
+    // Clean the data according to device settings, in place
+    _adxl343_store_axis(&device->decoder, &data[0]);
+    _adxl343_store_axis(&device->decoder, &data[2]);
+    _adxl343_store_axis(&device->decoder, &data[4]);
+
+    return FUNCTION_STATUS_OK;
+}
 
-    adxl343_settings.rate = rate;
+FunctionStatus adxl343_read_sample(ADXL343Device* device, ADXL343Sample* sample){
+    FunctionStatus result;
+    if (device == NULL || sample == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Received straight into the sample, then decoded in place (each axis is read before it is overwritten)
+    result = _adxl343_read(device, ADXL343_DATA_X_0, sizeof(ADXL343Sample), (char*) sample);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    adxl343_decode(&device->decoder, (const uint8_t*) sample, sample, 1);
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_set_range(uint8_t range){
+FunctionStatus adxl343_set_fifo_mode(ADXL343Device* device, uint8_t mode, uint8_t samples, uint8_t trigger){
     FunctionStatus result;
-    uint8_t reg_mask = 0xFC;
-    uint8_t register_value;
-    // Get current register (DATA_FORMAT) value
-    result = _adxl343_read(ADXL343_REG_DATA_FORMAT, 1, &register_value);
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (mode > ADXL343_FIFO_MODE_TRIGGER || samples > ADXL343_FIFO_SAMPLES_MASK ||
+        trigger > ADXL343_FIFO_TRIGGER_INT2){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    // FIFO_CTL - mode (D7:D6), trigger (D5), samples (D4:D0)
+    uint8_t register_value = (mode << 6) | (trigger << 5) | samples;
+    result = _adxl343_write(device, ADXL343_REG_FIFO_CTL, register_value);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Updating data_format register value to include the new range
-    register_value = (register_value & reg_mask) | range;
-    // Send packet to ADXL343
-    result = _adxl343_write(ADXL343_REG_DATA_FORMAT, register_value);
+    device->settings.fifo_mode = mode;
+    device->settings.fifo_samples = samples;
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_get_fifo_entries(ADXL343Device* device, uint8_t* entries){
+    FunctionStatus result;
+    if (device == NULL || entries == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    char register_value;
+    result = _adxl343_read(device, ADXL343_REG_FIFO_STATUS, 1, &register_value);
     if (result != FUNCTION_STATUS_OK){return result;}
-    adxl343_settings.range = range;
+    *entries = register_value & ADXL343_FIFO_ENTRIES_MASK;
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_set_resolution_fixed(){
+FunctionStatus adxl343_read_fifo(ADXL343Device* device, ADXL343Sample* samples, size_t max, size_t* count){
+    FunctionStatus result;
+    if (device == NULL || samples == NULL || count == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    *count = 0;
+    // Find out how many entries are waiting, one status read covers the whole drain
+    uint8_t entries;
+    result = adxl343_get_fifo_entries(device, &entries);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    if (entries > max){
+        entries = max;
+    }
+
+    return _adxl343_pop_fifo(device, samples, entries, count);
+}
+
+FunctionStatus adxl343_read_fifo_strided(ADXL343Device* device, int16_t* x, int16_t* y, int16_t* z, size_t stride,
+                                        size_t max, size_t* count){
     FunctionStatus result;
-    uint8_t reg_mask = 0xF7;
-    uint8_t register_value;
-    // Get current register (DATA_FORMAT) value
-    result = _adxl343_read(ADXL343_REG_DATA_FORMAT, 1, &register_value);
+    if (device == NULL || x == NULL || y == NULL || z == NULL || count == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (stride == 0){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    *count = 0;
+    uint8_t entries;
+    result = adxl343_get_fifo_entries(device, &entries);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Updated data_format register value to the set 10bit fixed resolution mode
-    register_value = register_value & reg_mask | (0 << 0x8);
-    // Send packet to ADXL343
-    result = _adxl343_write(ADXL343_REG_DATA_FORMAT, register_value);
+    if (entries > max){
+        entries = max;
+    }
+
+    return _adxl343_pop_fifo_strided(device, x, y, z, stride, entries, count);
+}
+
+FunctionStatus adxl343_drain_fifo_to_ring(ADXL343Device* device, struct ADXL343Ring* ring, size_t* count){
+    FunctionStatus result;
+    if (device == NULL || ring == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (count != NULL){
+        *count = 0;
+    }
+    uint8_t entries;
+    result = adxl343_get_fifo_entries(device, &entries);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    // Decode into the free space of the ring, at most two spans when it wraps around
+    while (entries > 0){
+        ADXL343Sample* span;
+        size_t length;
+        size_t popped = 0;
+        adxl343_ring_reserve(ring, &span, &length);
+        if (length == 0){break;}
+        if (length > entries){
+            length = entries;
+        }
+        result = _adxl343_pop_fifo(device, span, length, &popped);
+        adxl343_ring_commit(ring, popped);
+        entries -= popped;
+        if (count != NULL){
+            *count += popped;
+        }
+        if (result != FUNCTION_STATUS_OK){return result;}
+    }
+    if (entries == 0){return FUNCTION_STATUS_OK;}
+    // Ring is full, pop the rest anyway so the FIFO and its interrupt are cleared
+    ADXL343Sample discard;
+    adxl343_ring_drop(ring, entries);
+    for (; entries > 0; entries--){
+        result = _adxl343_pop_fifo(device, &discard, 1, NULL);
+        if (result != FUNCTION_STATUS_OK){return result;}
+    }
+
+    return FUNCTION_STATUS_BOUNDARY_ERROR;
+}
+
+
+FunctionStatus adxl343_read_fifo_timestamped(ADXL343Device* device, struct ADXL343Timeline* timeline,
+                                            ADXL343Sample* samples, uint64_t* timestamps, size_t max, size_t* count){
+    FunctionStatus result;
+    if (device == NULL || timeline == NULL || samples == NULL || timestamps == NULL || count == NULL){
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+    if (adxl343_timestamp_source == NULL){return FUNCTION_STATUS_NOT_INITIALIZED;}
+    *count = 0;
+    uint8_t entries;
+    result = adxl343_get_fifo_entries(device, &entries);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    // The clock reading that goes with the entry count, taken before the drain adds its own bus time
+    uint64_t host_ns = _adxl343_now();
+    if (timeline->nominal_q16 == 0 || timeline->rate != device->settings.rate){
+        result = adxl343_timeline_init(timeline, device->settings.rate);
+        if (result != FUNCTION_STATUS_OK){return result;}
+    }
+    size_t n = (entries > max) ? max : entries;
+    result = _adxl343_pop_fifo(device, samples, n, count);
     if (result != FUNCTION_STATUS_OK){return result;}
-    adxl343_settings.resolution = 0x00;
+
+    return adxl343_timeline_stamp(timeline, host_ns, entries, timestamps, *count);
+}
+
+FunctionStatus adxl343_drain_fifo_async(ADXL343Device* device, ADXL343AsyncOp* op, ADXL343Sample* samples, size_t max,
+                                        ADXL343AsyncCallback callback, void* context){
+    FunctionStatus result;
+    if (device == NULL || op == NULL || samples == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (device->bus == NULL || device->bus->submit == NULL){return FUNCTION_STATUS_ERROR;}
+    _adxl343_async_prepare(op, device, callback, context);
+    op->samples = samples;
+    op->max = max;
+
+    result = _adxl343_async_submit(op, ADXL343_REG_FIFO_STATUS, 2, 1, _adxl343_drain_async_status_done);
+    if (result != FUNCTION_STATUS_OK){
+        op->status = result;
+        return result;
+    }
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_set_interrupts(ADXL343Device* device, uint8_t enable, uint8_t map){
+    FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (!device->shadow_valid){
+        result = adxl343_resync_shadow(device);
+        if (result != FUNCTION_STATUS_OK){return result;}
+    }
+    // INT_ENABLE and INT_MAP are neighbours, write them together when both change
+    uint8_t values [2] = {enable, map};
+    uint8_t first = (device->shadow[ADXL343_REG_INT_ENABLE] != enable) ? 0 : 1;
+    uint8_t last = (device->shadow[ADXL343_REG_INT_MAP] != map) ? 1 : 0;
+    if (first > last){return FUNCTION_STATUS_OK;}
+
+    return _adxl343_write_burst(device, ADXL343_REG_INT_ENABLE + first, &values[first], last - first + 1);
+}
+
+FunctionStatus adxl343_set_interrupt_callback(ADXL343Device* device, uint8_t sources, ADXL343InterruptCallback callback,
+                                              void* context){
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    for (uint8_t bit = 0; bit < ADXL343_INT_COUNT; bit++){
+        if (sources & (1 << bit)){
+            device->interrupt_callbacks[bit] = callback;
+            device->interrupt_contexts[bit] = context;
+        }
+    }
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_set_resolution_full(){
+FunctionStatus adxl343_on_interrupt(ADXL343Device* device){
+    FunctionStatus result;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Event callbacks and the wake profile also get ACT_TAP_STATUS, read in the same transaction as INT_SOURCE
+    uint8_t with_status = device->wake_enabled;
+    for (uint8_t bit = 0; bit < ADXL343_INT_COUNT; bit++){
+        if ((ADXL343_EVENT_STATUS_SOURCES & device->shadow[ADXL343_REG_INT_ENABLE] & (1 << bit)) &&
+            device->interrupt_callbacks[bit] != NULL){
+            with_status = 1;
+        }
+    }
+    // One read of INT_SOURCE, this also clears the latched event sources
+    uint8_t data [ADXL343_REG_INT_SOURCE - ADXL343_REG_ACT_TAP_STATUS + 1];
+    uint8_t first = with_status ? ADXL343_REG_ACT_TAP_STATUS : ADXL343_REG_INT_SOURCE;
+    result = _adxl343_read(device, first, ADXL343_REG_INT_SOURCE - first + 1, (char*) data);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    uint8_t source = data[ADXL343_REG_INT_SOURCE - first];
+    if (with_status){
+        _adxl343_decode_event_status(data[0], &device->event_status);
+    }
+    // Data ready, watermark and overrun are flagged even when not enabled
+    source &= device->shadow[ADXL343_REG_INT_ENABLE];
+    // Wake-on-motion, the new rate and watermark are in place before the callbacks run
+    FunctionStatus wake_result = FUNCTION_STATUS_OK;
+    uint8_t motion = source & (ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY);
+    if (device->wake_enabled && motion){
+        // Both flagged, the sleep state tells which came last
+        uint8_t active = (motion == ADXL343_INT_ACTIVITY) ||
+                         (motion != ADXL343_INT_INACTIVITY && !device->event_status.asleep);
+        ADXL343Config target;
+        wake_result = _adxl343_edit_config(device, &target);
+        if (wake_result == FUNCTION_STATUS_OK){
+            _adxl343_wake_to_config(&device->wake_profile, active, &target);
+            wake_result = adxl343_apply_config(device, &target);
+        }
+    }
+    // Capture trigger, only timestamped here, the window is drained by adxl343_poll_capture once it is complete
+    ADXL343Capture* capture = device->capture;
+    if (capture != NULL && capture->state == ADXL343_CAPTURE_ARMED && (source & capture->config.sources)){
+        capture->state = ADXL343_CAPTURE_TRIGGERED;
+        capture->source = source & capture->config.sources;
+        capture->trigger_time = _adxl343_now();
+    }
+    for (uint8_t bit = 0; bit < ADXL343_INT_COUNT; bit++){
+        if ((source & (1 << bit)) && device->interrupt_callbacks[bit] != NULL){
+            device->interrupt_callbacks[bit](device, 1 << bit, device->interrupt_contexts[bit]);
+        }
+    }
+
+    return wake_result;
+}
+
+FunctionStatus adxl343_set_tap_config(ADXL343Device* device, const ADXL343TapConfig* config){
+    FunctionStatus result;
+    ADXL343Config target;
+    if (device == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    result = _adxl343_edit_config(device, &target);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    target.thresh_tap = _adxl343_to_register((uint32_t) config->threshold_mg * 1000, ADXL343_THRESH_UNIT_UG);
+    target.dur = _adxl343_to_register(config->duration_us, ADXL343_DUR_UNIT_US);
+    target.latent = _adxl343_to_register(config->latency_us, ADXL343_LATENT_UNIT_US);
+    target.window = _adxl343_to_register(config->window_us, ADXL343_LATENT_UNIT_US);
+    target.tap_axes = (config->axes & ADXL343_AXIS_ALL) | (config->suppress ? ADXL343_TAP_SUPPRESS : 0x00);
+
+    return adxl343_apply_config(device, &target);
+}
+
+FunctionStatus adxl343_set_activity_config(ADXL343Device* device, const ADXL343ActivityConfig* config){
+    FunctionStatus result;
+    ADXL343Config target;
+    if (device == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    result = _adxl343_edit_config(device, &target);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    _adxl343_activity_to_config(config, &target);
+
+    return adxl343_apply_config(device, &target);
+}
+
+FunctionStatus adxl343_set_inactivity_config(ADXL343Device* device, const ADXL343InactivityConfig* config){
     FunctionStatus result;
-    uint8_t reg_mask = 0xF7;
-    uint8_t register_value;
-    // Get current register (DATA_FORMAT) value
-    result = _adxl343_read(ADXL343_REG_DATA_FORMAT, 1, &register_value);
+    ADXL343Config target;
+    if (device == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    result = _adxl343_edit_config(device, &target);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Updating data_format register value to set full resolution mode
-    register_value = register_value & reg_mask | (1 << 0x8);
-    // Send packet to ADXL343
-    result = _adxl343_write(ADXL343_REG_DATA_FORMAT, register_value);
+    _adxl343_inactivity_to_config(config, &target);
+
+    return adxl343_apply_config(device, &target);
+}
+
+FunctionStatus adxl343_set_free_fall_config(ADXL343Device* device, const ADXL343FreeFallConfig* config){
+    FunctionStatus result;
+    ADXL343Config target;
+    if (device == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    result = _adxl343_edit_config(device, &target);
     if (result != FUNCTION_STATUS_OK){return result;}
-    adxl343_settings.resolution = 0x01;
+    target.thresh_ff = _adxl343_to_register((uint32_t) config->threshold_mg * 1000, ADXL343_THRESH_UNIT_UG);
+    target.time_ff = _adxl343_to_register((uint32_t) config->time_ms * 1000, ADXL343_TIME_FF_UNIT_US);
+
+    return adxl343_apply_config(device, &target);
+}
+
+FunctionStatus adxl343_get_event_status(ADXL343Device* device, ADXL343EventStatus* status){
+    FunctionStatus result;
+    if (device == NULL || status == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    uint8_t act_tap_status;
+    result = _adxl343_read(device, ADXL343_REG_ACT_TAP_STATUS, 1, (char*) &act_tap_status);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    _adxl343_decode_event_status(act_tap_status, status);
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_set_bit_order(uint8_t bit_order){
+FunctionStatus adxl343_set_power_config(ADXL343Device* device, const ADXL343PowerConfig* config){
+    FunctionStatus result;
+    ADXL343Config target;
+    if (device == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (config->wakeup > ADXL343_WAKEUP_1HZ || (config->auto_sleep && !config->link)){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    result = _adxl343_edit_config(device, &target);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    // BW_RATE and POWER_CTL are neighbours, one burst
+    target.bw_rate = (uint8_t) ((target.bw_rate & ~ADXL343_LOW_POWER) | (config->low_power ? ADXL343_LOW_POWER : 0x00));
+    target.power_ctl = (uint8_t) ((target.power_ctl & (0x08 | ADXL343_POWER_SLEEP)) |
+                                  (config->link ? ADXL343_POWER_LINK : 0x00) |
+                                  (config->auto_sleep ? ADXL343_POWER_AUTO_SLEEP : 0x00) |
+                                  config->wakeup);
+
+    return adxl343_apply_config(device, &target);
+}
+
+void adxl343_get_default_wake_profile(ADXL343WakeProfile* profile){
+    if (profile == NULL){return;}
+    memset(profile, 0x00, sizeof(ADXL343WakeProfile));
+    profile->activity.threshold_mg = 250;
+    profile->activity.axes = ADXL343_AXIS_ALL;
+    profile->activity.ac_coupled = 0x01;
+    profile->inactivity.threshold_mg = 187;
+    profile->inactivity.time_s = 5;
+    profile->inactivity.axes = ADXL343_AXIS_ALL;
+    profile->inactivity.ac_coupled = 0x01;
+    profile->wakeup = ADXL343_WAKEUP_8HZ;
+    profile->active_rate = ADXL343_RATE_800HZ;
+    profile->active_watermark = 16;
+    profile->idle_rate = ADXL343_RATE_12_5HZ;
+    profile->idle_low_power = 0x01;
+    profile->idle_watermark = 4;
+}
+
+FunctionStatus adxl343_set_wake_profile(ADXL343Device* device, const ADXL343WakeProfile* profile){
     FunctionStatus result;
-    uint8_t reg_mask = 0xFB;
-    uint8_t register_value;
-    // Get current register (DATA_FORMAT) value
-    result = _adxl343_read(ADXL343_REG_DATA_FORMAT, 1, &register_value);
+    ADXL343Config target;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (profile == NULL){
+        device->wake_enabled = 0x00;
+        return FUNCTION_STATUS_OK;
+    }
+    if (profile->active_rate > 0x0F || profile->idle_rate > 0x0F || profile->wakeup > ADXL343_WAKEUP_1HZ ||
+        profile->active_watermark > ADXL343_FIFO_SAMPLES_MASK || profile->idle_watermark > ADXL343_FIFO_SAMPLES_MASK){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    result = _adxl343_edit_config(device, &target);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Updating data_format register value to set bit order
-    register_value = register_value & reg_mask | (bit_order << 0x4);
-    // Send packet to ADXL343
-    result = _adxl343_write(ADXL343_REG_DATA_FORMAT, register_value);
+    // Detection, link with auto sleep and the idle state in one configuration change
+    _adxl343_activity_to_config(&profile->activity, &target);
+    _adxl343_inactivity_to_config(&profile->inactivity, &target);
+    target.power_ctl = (uint8_t) ((target.power_ctl & 0x08) | ADXL343_POWER_LINK | ADXL343_POWER_AUTO_SLEEP |
+                                  profile->wakeup);
+    target.int_enable |= ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY;
+    _adxl343_wake_to_config(profile, 0, &target);
+    result = adxl343_apply_config(device, &target);
     if (result != FUNCTION_STATUS_OK){return result;}
-    adxl343_settings.bit_order = bit_order;
+    device->wake_profile = *profile;
+    device->wake_enabled = 0x01;
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_get_X_axis(char* data){
+FunctionStatus adxl343_arm_capture(ADXL343Device* device, ADXL343Capture* capture, const ADXL343CaptureConfig* config){
     FunctionStatus result;
-    // Read in values from the X axis 
-    result = _adxl343_read(ADXL343_DATA_X_0, 2, data);
+    ADXL343Config target;
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (capture == NULL){
+        device->capture = NULL;
+        return FUNCTION_STATUS_OK;
+    }
+    if (config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (config->pre_samples == 0 || config->pre_samples > ADXL343_FIFO_SAMPLES_MASK ||
+        config->pin > ADXL343_FIFO_TRIGGER_INT2 || config->sources == 0 ||
+        (config->sources & ~ADXL343_CAPTURE_SOURCES) != 0){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    device->capture = NULL;
+    result = _adxl343_edit_config(device, &target);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Clean the data according to device settings
-    _clean_accelerometer_data(data);
+    // Trigger sources enabled on the trigger pin, bypass first to empty the FIFO and clear an earlier trigger
+    target.int_enable |= config->sources;
+    target.int_map = (config->pin == ADXL343_FIFO_TRIGGER_INT2) ? (uint8_t) (target.int_map | config->sources)
+                                                                : (uint8_t) (target.int_map & ~config->sources);
+    target.fifo_ctl = ADXL343_FIFO_MODE_BYPASS << 6;
+    result = adxl343_apply_config(device, &target);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    result = adxl343_set_fifo_mode(device, ADXL343_FIFO_MODE_TRIGGER, config->pre_samples, config->pin);
+    if (result != FUNCTION_STATUS_OK){return result;}
+
+    memset(capture, 0x00, sizeof(ADXL343Capture));
+    capture->config = *config;
+    capture->period_ns = _adxl343_period_ns(device->settings.rate);
+    capture->state = ADXL343_CAPTURE_ARMED;
+    device->capture = capture;
+
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_get_Y_axis(char* data){
+FunctionStatus adxl343_poll_capture(ADXL343Device* device, ADXL343Capture* capture){
     FunctionStatus result;
-    // Read in values from the Y axis 
-    result = _adxl343_read(ADXL343_DATA_Y_0, 2, data);
+    if (device == NULL || capture == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    switch (capture->state){
+    case ADXL343_CAPTURE_DONE:
+        return FUNCTION_STATUS_OK;
+    case ADXL343_CAPTURE_ARMED:
+        // Nothing on the bus until adxl343_on_interrupt has seen the trigger
+        return FUNCTION_STATUS_PENDING;
+    case ADXL343_CAPTURE_TRIGGERED:
+        break;
+    default:
+        return FUNCTION_STATUS_NOT_INITIALIZED;
+    }
+
+    // Complete once the FIFO has triggered and filled up, it then stops collecting
+    uint8_t status;
+    result = _adxl343_read(device, ADXL343_REG_FIFO_STATUS, 1, (char*) &status);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Clean the data according to device settings
-    _clean_accelerometer_data(data);
-    
+    uint8_t entries = status & ADXL343_FIFO_ENTRIES_MASK;
+    if (!(status & 0x80) || entries < ADXL343_FIFO_SIZE){return FUNCTION_STATUS_PENDING;}
+    if (entries > ADXL343_CAPTURE_WINDOW){
+        entries = ADXL343_CAPTURE_WINDOW;
+    }
+    result = _adxl343_pop_fifo(device, capture->samples, entries, &capture->count);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    capture->pre_trigger = (capture->count < capture->config.pre_samples) ? capture->count : capture->config.pre_samples;
+    capture->state = ADXL343_CAPTURE_DONE;
+    if (device->capture == capture){
+        device->capture = NULL;
+    }
+
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_get_Z_axis(char* data){
+FunctionStatus adxl343_read_multi(ADXL343Device* const* devices, size_t num_devices, ADXL343Sample* samples){
     FunctionStatus result;
-    // Read in values from the Z axis 
-    result = _adxl343_read(ADXL343_DATA_Z_0, 2, data);
+    if (devices == NULL || samples == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    for (size_t i = 0; i < num_devices; i++){
+        if (devices[i] == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    }
+    // Bus pass first, every sensor is read back to back with nothing in between to keep the skew down
+    uint8_t raw [6];
+    for (size_t i = 0; i < num_devices; i++){
+        result = _adxl343_read(devices[i], ADXL343_DATA_X_0, sizeof(raw), (char*) &samples[i]);
+        if (result != FUNCTION_STATUS_OK){return result;}
+    }
+    // Then decode, each sample's raw bytes were stored in its own slot
+    for (size_t i = 0; i < num_devices; i++){
+        memcpy(raw, &samples[i], sizeof(raw));
+        adxl343_decode(&devices[i]->decoder, raw, &samples[i], 1);
+    }
+
+    return FUNCTION_STATUS_OK;
+}
+
+ADXL343Settings adxl343_get_settings(const ADXL343Device* device){
+    ADXL343Settings settings = {0};
+    if (device == NULL){return settings;}
+    return device->settings;
+}
+
+FunctionStatus adxl343_update_settings(ADXL343Device* device, ADXL343Settings* settings){
+    FunctionStatus result;
+    if (device == NULL || settings == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Re-sync the shadow (and with it the settings) with the values on the device
+    result = adxl343_resync_shadow(device);
+    if (result != FUNCTION_STATUS_OK){
+        // A partial read may have overwritten part of the shadow
+        adxl343_invalidate_shadow(device);
+        return result;
+    }
+    *settings = device->settings;
+
+    return FUNCTION_STATUS_OK;
+}
+
+ADXL343Decoder adxl343_make_decoder(uint8_t range, uint8_t resolution, uint8_t bit_order){
+    ADXL343Decoder decoder;
+    // 10 bits in fixed resolution, full resolution adds one bit per range step
+    decoder.width = 10 + ((resolution & 0x01) ? (range & 0x03) : 0);
+    decoder.mask = (uint16_t) ((1u << decoder.width) - 1);
+    // Right justified samples have their sign bit at width - 1, left justified ones already at bit 15
+    decoder.left_shift = (bit_order & 0x01) ? 0 : 16 - decoder.width;
+    decoder.right_shift = 16 - decoder.width;
+    // 256 LSB/g (3.9 mg/LSB) at full resolution, halving with every range step in fixed resolution
+    decoder.scale_mg_q8 = (resolution & 0x01) ? 1000 : (uint16_t) (1000u << (range & 0x03));
+
+    return decoder;
+}
+
+ADXL343Decoder adxl343_get_decoder(const ADXL343Device* device){
+    if (device == NULL){return adxl343_make_decoder(0x00, 0x00, 0x00);}
+    return device->decoder;
+}
+
+void adxl343_decode(const ADXL343Decoder* decoder, const uint8_t* raw, ADXL343Sample* samples, size_t count){
+    for (size_t i = 0; i < count; i++){
+        samples[i].x = _adxl343_decode_axis(decoder, &raw[6 * i + 0]);
+        samples[i].y = _adxl343_decode_axis(decoder, &raw[6 * i + 2]);
+        samples[i].z = _adxl343_decode_axis(decoder, &raw[6 * i + 4]);
+    }
+}
+
+void adxl343_decode_strided(const ADXL343Decoder* decoder, const uint8_t* raw, size_t count, int16_t* x, int16_t* y,
+                            int16_t* z, size_t stride){
+    if (decoder == NULL || raw == NULL || x == NULL || y == NULL || z == NULL){return;}
+    _adxl343_decode_strided(decoder, raw, count, x, y, z, stride);
+}
+
+void adxl343_get_default_config(ADXL343Config* config){
+    if (config == NULL){return;}
+    // Every register at its reset value, apart from the driver defaults
+    memset(config, 0x00, sizeof(ADXL343Config));
+    config->bw_rate = ADXL343_DEFAULT_RATE;
+    config->power_ctl = ADXL343_DEFAULT_POWERCTRL;
+    config->data_format = 0x00 |
+                          (ADXL343_DEFAULT_RESOLUTION << 3) |
+                          (ADXL343_DEFAULT_BITORDER << 2) |
+                          (ADXL343_DEFAULT_RANGE);
+    config->fifo_ctl = ADXL343_DEFAULT_FIFOMODE << 6;
+}
+
+FunctionStatus adxl343_apply_config(ADXL343Device* device, const ADXL343Config* config){
+    FunctionStatus result;
+    if (device == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+
+    uint8_t target [ADXL343_REG_MAP_SIZE];
+    uint8_t bursts [ADXL343_CONFIG_REGISTERS][2];
+    size_t num_bursts = _adxl343_plan_bursts(device, config, target, bursts);
+    for (size_t i = 0; i < num_bursts; i++){
+        result = _adxl343_write_burst(device, bursts[i][0], &target[bursts[i][0]], bursts[i][1]);
+        if (result != FUNCTION_STATUS_OK){return result;}
+    }
+
+    device->shadow_valid = 0x01;
+    _adxl343_settings_from_shadow(device);
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_apply_config_async(ADXL343Device* device, ADXL343AsyncOp* op, const ADXL343Config* config,
+                                          ADXL343AsyncCallback callback, void* context){
+    FunctionStatus result;
+    if (device == NULL || op == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (device->bus == NULL || device->bus->submit == NULL){return FUNCTION_STATUS_ERROR;}
+    _adxl343_async_prepare(op, device, callback, context);
+
+    uint8_t target [ADXL343_REG_MAP_SIZE];
+    uint8_t bursts [ADXL343_CONFIG_REGISTERS][2];
+    size_t num_bursts = _adxl343_plan_bursts(device, config, target, bursts);
+    if (num_bursts == 0){
+        _adxl343_config_async_finish(op);
+        return FUNCTION_STATUS_OK;
+    }
+    for (size_t i = 0; i < num_bursts; i++){
+        uint8_t* frame = op->frames[op->submitted];
+        memcpy(&frame[2], &target[bursts[i][0]], bursts[i][1]);
+        result = _adxl343_async_submit(op, bursts[i][0], 2 + bursts[i][1], 0, _adxl343_config_async_done);
+        if (result != FUNCTION_STATUS_OK){
+            // Bursts already queued still complete and report the error through the callback
+            device->shadow_valid = 0x00;
+            op->status = result;
+            if (i == 0){return result;}
+            break;
+        }
+    }
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_begin_drain_fifo(ADXL343Device* device, ADXL343Machine* machine, ADXL343Sample* samples,
+                                        size_t max){
+    if (device == NULL || machine == NULL || samples == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (device->bus == NULL || device->bus->submit == NULL){return FUNCTION_STATUS_ERROR;}
+    _adxl343_step_prepare(machine, device, ADXL343_STEP_DRAIN_STATUS);
+    machine->samples = samples;
+    machine->max = max;
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_begin_apply_config(ADXL343Device* device, ADXL343Machine* machine,
+                                          const ADXL343Config* config){
+    if (device == NULL || machine == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (device->bus == NULL || device->bus->submit == NULL){return FUNCTION_STATUS_ERROR;}
+    _adxl343_step_prepare(machine, device, ADXL343_STEP_CONFIG);
+    machine->num_bursts = _adxl343_plan_bursts(device, config, machine->target, machine->bursts);
+    if (machine->num_bursts == 0){
+        _adxl343_step_finish(machine, FUNCTION_STATUS_OK);
+    }
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_step(ADXL343Machine* machine){
+    FunctionStatus result;
+    if (machine == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (machine->state == ADXL343_STEP_IDLE){return FUNCTION_STATUS_NOT_INITIALIZED;}
+    if (machine->state == ADXL343_STEP_DONE){return machine->status;}
+    // Handle the transaction in flight once it has completed
+    if (machine->in_flight){
+        if (!machine->completed){return FUNCTION_STATUS_PENDING;}
+        _adxl343_step_complete(machine);
+        if (machine->state == ADXL343_STEP_DONE){return machine->status;}
+    }
+
+    // Then queue the next one, a full queue is retried on the next step
+    result = _adxl343_step_next(machine);
+    if (result != FUNCTION_STATUS_OK && result != FUNCTION_STATUS_BUSY){
+        _adxl343_step_finish(machine, result);
+        return result;
+    }
+
+    return FUNCTION_STATUS_PENDING;
+}
+
+FunctionStatus adxl343_snapshot_config(ADXL343Device* device, ADXL343Config* config){
+    FunctionStatus result;
+    if (device == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    result = adxl343_resync_shadow(device);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Clean the data according to device settings
-    _clean_accelerometer_data(data);
+    _adxl343_config_from_shadow(device, config);
 
     return FUNCTION_STATUS_OK;
 }
 
-FunctionStatus adxl343_get_all_axes(char* data){
+void adxl343_invalidate_shadow(ADXL343Device* device){
+    if (device == NULL){return;}
+    device->shadow_valid = 0x00;
+}
+
+FunctionStatus adxl343_resync_shadow(ADXL343Device* device){
     FunctionStatus result;
-    // Read in values from the X axis 
-    result = _adxl343_read(ADXL343_DATA_X_0, 6, data);
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Burst read the configuration block, skipping INT_SOURCE (reading it clears latched events)
+    // and the data registers (reading them pops the FIFO)
+    result = _adxl343_read(device, ADXL343_REG_CONFIG_START, ADXL343_REG_INT_SOURCE - ADXL343_REG_CONFIG_START,
+                           (char*) &device->shadow[ADXL343_REG_CONFIG_START]);
     if (result != FUNCTION_STATUS_OK){return result;}
-    // Clean the data according to device settings
-    char x_data [2]= {data[0], data[1]};
-    _clean_accelerometer_data(x_data);
-    char y_data [2] = {data[2], data[3]};
-    _clean_accelerometer_data(y_data);
-    char z_data [2] = {data[4], data[5]};
-    _clean_accelerometer_data(z_data);
-    data[0] = x_data[0];
-    data[1] = x_data[1];
-    data[2] = y_data[0];
-    data[3] = y_data[1];
-    data[4] = z_data[0];
-    data[5] = z_data[1];
+    result = _adxl343_read(device, ADXL343_REG_DATA_FORMAT, 1, (char*) &device->shadow[ADXL343_REG_DATA_FORMAT]);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    result = _adxl343_read(device, ADXL343_REG_FIFO_CTL, 1, (char*) &device->shadow[ADXL343_REG_FIFO_CTL]);
+    if (result != FUNCTION_STATUS_OK){return result;}
+
+    device->shadow_valid = 0x01;
+    _adxl343_settings_from_shadow(device);
 
     return FUNCTION_STATUS_OK;
 }
 
-ADXL343Settings adxl343_get_settings(){
-    return adxl343_settings;
+FunctionStatus adxl343_calibrate_offsets(ADXL343Device* device, const int32_t expected_mg[3], size_t num_samples){
+    FunctionStatus result;
+    ADXL343Config saved;
+    ADXL343Config measure;
+    ADXL343Sample samples [ADXL343_FIFO_SIZE + 1];
+    if (device == NULL || expected_mg == NULL || num_samples == 0){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (!device->shadow_valid){
+        result = adxl343_resync_shadow(device);
+        if (result != FUNCTION_STATUS_OK){return result;}
+    }
+
+    // Measure without offsets, collecting into the FIFO
+    _adxl343_config_from_shadow(device, &saved);
+    measure = saved;
+    measure.ofsx = 0;
+    measure.ofsy = 0;
+    measure.ofsz = 0;
+    measure.power_ctl |= 0x08;
+    measure.fifo_ctl = (uint8_t) ((ADXL343_FIFO_MODE_STREAM << 6) | (saved.fifo_ctl & 0x3F));
+    result = adxl343_apply_config(device, &measure);
+    if (result != FUNCTION_STATUS_OK){return result;}
+
+    // Entries taken before the offsets were cleared are dropped, then whole FIFO drains are averaged
+    int64_t sum [3] = {0, 0, 0};
+    size_t collected = 0;
+    size_t count = 0;
+    // The wait since the last entry is measured on the timestamp source, without one in status reads
+    const uint64_t period_ns = _adxl343_period_ns(device->settings.rate);
+    uint64_t budget_ns = _adxl343_calibration_budget_ns(period_ns, num_samples);
+    uint64_t since = _adxl343_now();
+    uint64_t polls = 0;
+    result = adxl343_read_fifo(device, samples, ADXL343_FIFO_SIZE + 1, &count);
+    while (result == FUNCTION_STATUS_OK && collected < num_samples){
+        size_t wanted = num_samples - collected;
+        result = adxl343_read_fifo(device, samples, (wanted < ADXL343_FIFO_SIZE + 1) ? wanted : ADXL343_FIFO_SIZE + 1,
+                                   &count);
+        if (result != FUNCTION_STATUS_OK){break;}
+        if (count == 0){
+            polls++;
+            uint64_t waited_ns = (adxl343_timestamp_source != NULL) ? _adxl343_now() - since
+                                                                     : polls * ADXL343_CALIBRATION_MIN_POLL_NS;
+            if (waited_ns > budget_ns){
+                result = FUNCTION_STATUS_TIMEOUT;
+            }
+            continue;
+        }
+        budget_ns = _adxl343_calibration_budget_ns(period_ns, wanted - count);
+        since = _adxl343_now();
+        polls = 0;
+        for (size_t i = 0; i < count; i++){
+            sum[0] += samples[i].x;
+            sum[1] += samples[i].y;
+            sum[2] += samples[i].z;
+        }
+        collected += count;
+    }
+
+    // Restore the previous configuration, with the new offsets if the measurement went through
+    if (result == FUNCTION_STATUS_OK){
+        uint8_t* offsets [3] = {&saved.ofsx, &saved.ofsy, &saved.ofsz};
+        for (uint8_t axis = 0; axis < 3; axis++){
+            int64_t error_mg_q8 = sum[axis] * device->decoder.scale_mg_q8 - (int64_t) expected_mg[axis] * 256 *
+                                  (int64_t) num_samples;
+            *offsets[axis] = (uint8_t) (int8_t) _adxl343_offset_from_error(error_mg_q8, num_samples);
+        }
+    }
+    FunctionStatus restore = adxl343_apply_config(device, &saved);
+
+    return (result != FUNCTION_STATUS_OK) ? result : restore;
+}
+
+FunctionStatus adxl343_set_offsets(ADXL343Device* device, const int8_t offsets[3]){
+    FunctionStatus result;
+    if (device == NULL || offsets == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (device->shadow_valid && memcmp(&device->shadow[ADXL343_REG_OFSX], offsets, 3) == 0){return FUNCTION_STATUS_OK;}
+    // OFSX, OFSY and OFSZ are consecutive, one burst
+    result = _adxl343_write_burst(device, ADXL343_REG_OFSX, (const uint8_t*) offsets, 3);
+    if (result != FUNCTION_STATUS_OK){return result;}
+    memcpy(device->settings.offset, offsets, 3);
+
+    return FUNCTION_STATUS_OK;
 }
 
-ADXL343Settings adxl343_update_settings(){
-    char temp_reader;
+FunctionStatus adxl343_get_offsets(const ADXL343Device* device, int8_t offsets[3]){
+    if (device == NULL || offsets == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    memcpy(offsets, device->settings.offset, 3);
 
-    // Updating measurement mode
-    _adxl343_read(ADXL343_REG_POWER_CTL, 1, &temp_reader);
-    adxl343_settings.measurement_mode = temp_reader & 0x08;
-    // Updating rate
-    _adxl343_read(ADXL343_REG_BW_RATE, 1, &temp_reader);
-    adxl343_settings.rate = temp_reader & 0xF;
-    // Updating range
-    _adxl343_read(ADXL343_REG_DATA_FORMAT, 1, &temp_reader);
-    adxl343_settings.range = temp_reader & 0x3;
-    // Updating resolution
-    _adxl343_read(ADXL343_REG_DATA_FORMAT, 1, &temp_reader);
-    adxl343_settings.resolution = temp_reader & 0x08;
-    // Updating bit_order
-    _adxl343_read(ADXL343_REG_BW_RATE, 1, &temp_reader);
-    adxl343_settings.bit_order = temp_reader & 0x04;
+    return FUNCTION_STATUS_OK;
+}
 
-    return adxl343_settings;
+void adxl343_set_timestamp_source(ADXL343TimestampSource source){
+    adxl343_timestamp_source = source;
 }
 
+FunctionStatus adxl343_get_stats(const ADXL343Device* device, ADXL343Stats* stats){
+    if (device == NULL || stats == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+#ifdef ADXL343_ENABLE_STATS
+    *stats = device->stats;
+    return FUNCTION_STATUS_OK;
+#else
+    memset(stats, 0x00, sizeof(ADXL343Stats));
+    return FUNCTION_STATUS_ERROR;
+#endif
+}
+
+FunctionStatus adxl343_reset_stats(ADXL343Device* device){
+    if (device == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+#ifdef ADXL343_ENABLE_STATS
+    memset(&device->stats, 0x00, sizeof(ADXL343Stats));
+    return FUNCTION_STATUS_OK;
+#else
+    return FUNCTION_STATUS_ERROR;
+#endif
+}
@@ -0,0 +1,329 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  adxl343_features.c
+/// \brief incremental windowed vibration features (RMS, peak, crest, kurtosis, FFT bands) on adxl343 samples
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_features.h"
+
+#include <string.h>
+
+#define ADXL343_FEATURES_TABLE (ADXL343_FEATURES_MAX_WINDOW / 2)
+
+
+// Statics
+// - cos and sin of 2 pi j / 256 for j 0 - 127 in Q15, the second half of the circle is the first one negated
+static const int16_t _adxl343_features_cos [ADXL343_FEATURES_TABLE] = {
+    32767, 32758, 32729, 32679, 32610, 32522, 32413, 32286, 32138, 31972, 31786, 31581,
+    31357, 31114, 30853, 30572, 30274, 29957, 29622, 29269, 28899, 28511, 28106, 27684,
+    27246, 26791, 26320, 25833, 25330, 24812, 24279, 23732, 23170, 22595, 22006, 21403,
+    20788, 20160, 19520, 18868, 18205, 17531, 16846, 16151, 15447, 14733, 14010, 13279,
+    12540, 11793, 11039, 10279, 9512, 8740, 7962, 7180, 6393, 5602, 4808, 4011,
+    3212, 2411, 1608, 804, 0, -804, -1608, -2411, -3212, -4011, -4808, -5602,
+    -6393, -7180, -7962, -8740, -9512, -10279, -11039, -11793, -12540, -13279, -14010, -14733,
+    -15447, -16151, -16846, -17531, -18205, -18868, -19520, -20160, -20788, -21403, -22006, -22595,
+    -23170, -23732, -24279, -24812, -25330, -25833, -26320, -26791, -27246, -27684, -28106, -28511,
+    -28899, -29269, -29622, -29957, -30274, -30572, -30853, -31114, -31357, -31581, -31786, -31972,
+    -32138, -32286, -32413, -32522, -32610, -32679, -32729, -32758
+};
+static const int16_t _adxl343_features_sin [ADXL343_FEATURES_TABLE] = {
+    0, 804, 1608, 2411, 3212, 4011, 4808, 5602, 6393, 7180, 7962, 8740,
+    9512, 10279, 11039, 11793, 12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+    18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595, 23170, 23732, 24279, 24812,
+    25330, 25833, 26320, 26791, 27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972, 32138, 32286, 32413, 32522,
+    32610, 32679, 32729, 32758, 32767, 32758, 32729, 32679, 32610, 32522, 32413, 32286,
+    32138, 31972, 31786, 31581, 31357, 31114, 30853, 30572, 30274, 29957, 29622, 29269,
+    28899, 28511, 28106, 27684, 27246, 26791, 26320, 25833, 25330, 24812, 24279, 23732,
+    23170, 22595, 22006, 21403, 20788, 20160, 19520, 18868, 18205, 17531, 16846, 16151,
+    15447, 14733, 14010, 13279, 12540, 11793, 11039, 10279, 9512, 8740, 7962, 7180,
+    6393, 5602, 4808, 4011, 3212, 2411, 1608, 804
+};
+
+static inline int32_t _adxl343_features_cos_at(uint32_t j){
+    return (j < ADXL343_FEATURES_TABLE) ? _adxl343_features_cos[j] : -_adxl343_features_cos[j - ADXL343_FEATURES_TABLE];
+}
+
+static inline uint16_t _adxl343_features_saturate_u16(uint64_t value){
+    return (uint16_t) ((value > UINT16_MAX) ? UINT16_MAX : value);
+}
+
+static uint64_t _adxl343_features_isqrt(uint64_t value){
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > value){
+        bit >>= 2;
+    }
+    while (bit != 0){
+        if (value >= root + bit){
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+static uint8_t _adxl343_features_log2(size_t window){
+    uint8_t log2 = 0;
+    while (((size_t) 1 << log2) < window){
+        log2++;
+    }
+    return log2;
+}
+
+static FunctionStatus _adxl343_features_check(const ADXL343FeatureConfig* config){
+    const size_t window = config->window;
+    if (window < ADXL343_FEATURES_MIN_WINDOW || window > ADXL343_FEATURES_MAX_WINDOW || (window & (window - 1))){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    if (config->hop == 0 || config->hop > window){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    if (config->bands == 0 || config->bands > ADXL343_FEATURES_MAX_BANDS){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    if (config->band_edges[0] < 1 || config->band_edges[config->bands] > window / 2 + 1){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    for (size_t i = 0; i < config->bands; i++){
+        if (config->band_edges[i] >= config->band_edges[i + 1]){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    }
+
+    return FUNCTION_STATUS_OK;
+}
+
+// Adds sample n to the window of one axis, the sample n - window drops out
+static inline void _adxl343_features_add(ADXL343FeatureEngine* engine, int axis, int32_t value){
+    const uint32_t n = engine->samples;
+    const uint32_t window = engine->config.window;
+    const uint32_t mask = window - 1;
+    int16_t* history = engine->history[axis];
+    int64_t* sums = engine->sums[axis];
+    if (n >= window){
+        int64_t old = history[n & mask];
+        int64_t old2 = old * old;
+        sums[0] -= old;
+        sums[1] -= old2;
+        sums[2] -= old2 * old;
+        sums[3] -= old2 * old2;
+    }
+    int64_t square = (int64_t) value * value;
+    sums[0] += value;
+    sums[1] += square;
+    sums[2] += square * value;
+    sums[3] += square * square;
+    history[n & mask] = (int16_t) value;
+
+    // Monotonic queues: drop what left the window at the front, then what the new sample beats at the back
+    uint32_t* queue = engine->max_queue[axis];
+    uint16_t head = engine->max_head[axis];
+    uint16_t length = engine->max_length[axis];
+    if (length != 0 && n - queue[head] >= window){
+        head = (head + 1) & mask;
+        length--;
+    }
+    while (length != 0 && history[queue[(head + length - 1) & mask] & mask] <= value){
+        length--;
+    }
+    queue[(head + length++) & mask] = n;
+    engine->max_head[axis] = head;
+    engine->max_length[axis] = length;
+
+    queue = engine->min_queue[axis];
+    head = engine->min_head[axis];
+    length = engine->min_length[axis];
+    if (length != 0 && n - queue[head] >= window){
+        head = (head + 1) & mask;
+        length--;
+    }
+    while (length != 0 && history[queue[(head + length - 1) & mask] & mask] >= value){
+        length--;
+    }
+    queue[(head + length++) & mask] = n;
+    engine->min_head[axis] = head;
+    engine->min_length[axis] = length;
+}
+
+// In place radix-2 decimation in time, the input already in bit reversed order, no scaling between stages
+static void _adxl343_features_fft(int32_t* re, int32_t* im, size_t length){
+    // The first stage only adds and subtracts neighbours, the input is real
+    for (size_t i = 0; i < length; i += 2){
+        int32_t a = re[i];
+        int32_t b = re[i + 1];
+        re[i] = a + b;
+        re[i + 1] = a - b;
+        im[i] = 0;
+        im[i + 1] = 0;
+    }
+    for (size_t half = 2; half < length; half <<= 1){
+        const size_t step = ADXL343_FEATURES_MAX_WINDOW / (2 * half);
+        for (size_t k = 0; k < half; k++){
+            const int64_t wr = _adxl343_features_cos[k * step];
+            const int64_t wi = -_adxl343_features_sin[k * step];
+            for (size_t i = k; i < length; i += 2 * half){
+                const size_t j = i + half;
+                int32_t tr = (int32_t) ((wr * re[j] - wi * im[j] + (1 << 14)) >> 15);
+                int32_t ti = (int32_t) ((wr * im[j] + wi * re[j] + (1 << 14)) >> 15);
+                re[j] = re[i] - tr;
+                im[j] = im[i] - ti;
+                re[i] += tr;
+                im[i] += ti;
+            }
+        }
+    }
+}
+
+static void _adxl343_features_bands(ADXL343FeatureEngine* engine, int axis, int32_t mean, ADXL343AxisFeatures* out){
+    const ADXL343FeatureConfig* config = &engine->config;
+    const uint32_t window = config->window;
+    const uint32_t mask = window - 1;
+    const uint32_t oldest = engine->samples & mask;
+    const int16_t* history = engine->history[axis];
+    int32_t* re = engine->re;
+    int32_t* im = engine->im;
+
+    // Hann windowed deviations from the mean in Q4, loaded bit reversed
+    for (uint32_t n = 0; n < window; n++){
+        int32_t deviation = history[(oldest + n) & mask] - mean;
+        re[engine->reversed[n]] = (deviation * engine->hann[n]) >> (15 - ADXL343_FEATURES_FFT_Q);
+    }
+    _adxl343_features_fft(re, im, window);
+
+    // One sided |X|^2 / N^2 is half the mean square of the windowed signal, the Hann window keeps 3/8 of it
+    for (size_t band = 0; band < config->bands; band++){
+        uint64_t energy = 0;
+        for (size_t k = config->band_edges[band]; k < config->band_edges[band + 1]; k++){
+            energy += (uint64_t) ((int64_t) re[k] * re[k]) + (uint64_t) ((int64_t) im[k] * im[k]);
+        }
+        double mean_square = (double) energy * (16.0 / 3.0) / ((double) window * window);
+        out->bands_q8[band] = (mean_square >= UINT32_MAX) ? UINT32_MAX : (uint32_t) (mean_square + 0.5);
+    }
+}
+
+static void _adxl343_features_emit(ADXL343FeatureEngine* engine, ADXL343FeatureRecord* record){
+    const uint32_t window = engine->config.window;
+    const uint8_t log2 = engine->log2_window;
+    memset(record, 0, sizeof(*record));
+    record->sequence = engine->records++;
+    record->end_sample = engine->samples;
+    for (int axis = 0; axis < 3; axis++){
+        const int64_t* sums = engine->sums[axis];
+        ADXL343AxisFeatures* out = &record->axes[axis];
+        // N^2 times the variance is exact in integers, N is a power of two
+        int64_t spread = (int64_t) window * sums[1] - sums[0] * sums[0];
+        uint64_t rms_q4 = _adxl343_features_isqrt((uint64_t) spread << (2 * ADXL343_FEATURES_FFT_Q) >> (2 * log2));
+        int32_t high = engine->history[axis][engine->max_queue[axis][engine->max_head[axis]] & (window - 1)];
+        int32_t low = engine->history[axis][engine->min_queue[axis][engine->min_head[axis]] & (window - 1)];
+        // N times the distances of the extremes from the mean
+        int64_t above = (int64_t) high * window - sums[0];
+        int64_t below = sums[0] - (int64_t) low * window;
+        uint64_t peak_q4 = (uint64_t) ((above > below) ? above : below) << ADXL343_FEATURES_FFT_Q >> log2;
+        out->rms_q4 = _adxl343_features_saturate_u16(rms_q4);
+        out->peak_q4 = _adxl343_features_saturate_u16(peak_q4);
+        if (rms_q4 != 0){
+            out->crest_q8 = _adxl343_features_saturate_u16((peak_q4 << 8) / rms_q4);
+            // Central moments from the raw ones, double only here as the x^4 terms outgrow int64
+            double mean = (double) sums[0] / window;
+            double m2 = (double) spread / ((double) window * window);
+            double m4 = (double) sums[3] / window - 4.0 * mean * sums[2] / window + 6.0 * mean * mean * sums[1] / window
+                        - 3.0 * mean * mean * mean * mean;
+            double kurtosis = (m4 > 0.0) ? m4 / (m2 * m2) * 256.0 + 0.5 : 0.0;
+            out->kurtosis_q8 = (kurtosis >= UINT16_MAX) ? UINT16_MAX : (uint16_t) kurtosis;
+        }
+        int32_t mean = (int32_t) ((sums[0] + window / 2) >> log2);
+        _adxl343_features_bands(engine, axis, mean, out);
+    }
+}
+
+
+// Functions
+FunctionStatus adxl343_features_default_config(ADXL343FeatureConfig* config, size_t window, size_t hop, size_t bands){
+    if (config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (window < ADXL343_FEATURES_MIN_WINDOW || window > ADXL343_FEATURES_MAX_WINDOW){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    if (hop == 0 || hop > window){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    if (bands == 0 || bands > ADXL343_FEATURES_MAX_BANDS || bands > window / 2){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+
+    memset(config, 0, sizeof(*config));
+    config->window = (uint16_t) window;
+    config->hop = (uint16_t) hop;
+    config->bands = (uint8_t) bands;
+    for (size_t i = 0; i <= bands; i++){
+        config->band_edges[i] = (uint16_t) (1 + i * (window / 2) / bands);
+    }
+
+    return _adxl343_features_check(config);
+}
+
+FunctionStatus adxl343_features_init(ADXL343FeatureEngine* engine, const ADXL343FeatureConfig* config){
+    if (engine == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    FunctionStatus status = _adxl343_features_check(config);
+    if (status != FUNCTION_STATUS_OK){return status;}
+
+    engine->config = *config;
+    engine->log2_window = _adxl343_features_log2(config->window);
+    const uint8_t log2 = engine->log2_window;
+    for (uint32_t n = 0; n < config->window; n++){
+        uint32_t reversed = 0;
+        for (uint8_t bit = 0; bit < log2; bit++){
+            reversed |= ((n >> bit) & 1u) << (log2 - 1 - bit);
+        }
+        engine->reversed[n] = (uint8_t) reversed;
+        // Hann, (1 - cos(2 pi n / N)) / 2
+        engine->hann[n] = (int16_t) ((32768 - _adxl343_features_cos_at(n << (8 - log2))) / 2);
+    }
+    adxl343_features_reset(engine);
+
+    return FUNCTION_STATUS_OK;
+}
+
+void adxl343_features_reset(ADXL343FeatureEngine* engine){
+    if (engine == NULL){return;}
+    engine->samples = 0;
+    engine->until_record = engine->config.window;
+    engine->records = 0;
+    memset(engine->sums, 0, sizeof(engine->sums));
+    memset(engine->max_length, 0, sizeof(engine->max_length));
+    memset(engine->min_length, 0, sizeof(engine->min_length));
+    memset(engine->max_head, 0, sizeof(engine->max_head));
+    memset(engine->min_head, 0, sizeof(engine->min_head));
+}
+
+FunctionStatus adxl343_features_push(ADXL343FeatureEngine* engine, const ADXL343Sample* samples, size_t count,
+                                     ADXL343FeatureRecord* records, size_t max, size_t* consumed, size_t* emitted){
+    if (engine == NULL || consumed == NULL || emitted == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if ((samples == NULL && count != 0) || (records == NULL && max != 0)){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    *consumed = 0;
+    *emitted = 0;
+    if (engine->config.window == 0){return FUNCTION_STATUS_NOT_INITIALIZED;}
+
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++){
+        // Keep the sample that would complete a record for the next call
+        if (engine->until_record == 1 && written == max){
+            *consumed = i;
+            *emitted = written;
+            return FUNCTION_STATUS_BUSY;
+        }
+        const int16_t* values = &samples[i].x;
+        for (int axis = 0; axis < 3; axis++){
+            int32_t value = values[axis];
+            if (value > ADXL343_FEATURES_MAX_VALUE){
+                value = ADXL343_FEATURES_MAX_VALUE;
+            }
+            else if (value < -ADXL343_FEATURES_MAX_VALUE){
+                value = -ADXL343_FEATURES_MAX_VALUE;
+            }
+            _adxl343_features_add(engine, axis, value);
+        }
+        engine->samples++;
+        if (--engine->until_record == 0){
+            _adxl343_features_emit(engine, &records[written++]);
+            engine->until_record = engine->config.hop;
+        }
+    }
+    *consumed = count;
+    *emitted = written;
+
+    return FUNCTION_STATUS_OK;
+}
@@ -0,0 +1,335 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  adxl343_filter.c
+/// \brief fixed point filter and decimation pipeline on blocks of adxl343 samples
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_filter.h"
+
+#include <string.h>
+
+#if ADXL343_FILTER_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#elif ADXL343_FILTER_SIMD
+#include <arm_neon.h>
+#endif
+
+#define ADXL343_FILTER_ONE_Q8 (1 << ADXL343_FILTER_STATE_Q)
+
+
+// Statics
+static inline int16_t _adxl343_filter_saturate(int32_t value){
+    if (value > INT16_MAX){return INT16_MAX;}
+    if (value < INT16_MIN){return INT16_MIN;}
+    return (int16_t) value;
+}
+
+static inline int16_t _adxl343_filter_from_q8(int32_t value){
+    return _adxl343_filter_saturate((value + ADXL343_FILTER_ONE_Q8 / 2) >> ADXL343_FILTER_STATE_Q);
+}
+
+// Bit by bit square root, exact for any value
+static uint32_t _adxl343_filter_isqrt(uint32_t value){
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > value){
+        bit >>= 2;
+    }
+    while (bit != 0){
+        if (value >= root + bit){
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// Square root starting from the previous one, a moving RMS moves little per sample so one Newton step and a fix-up
+// of a LSB or so land on it
+static inline uint32_t _adxl343_filter_isqrt_near(uint32_t value, uint32_t root){
+    if (root == 0 || root > INT16_MAX){return _adxl343_filter_isqrt(value);}
+    root = (root + value / root) / 2;
+    uint32_t square = root * root;
+    uint32_t distance = (square > value) ? square - value : value - square;
+    if (root == 0 || root > INT16_MAX || distance > 4 * root + 4){return _adxl343_filter_isqrt(value);}
+    while (root * root > value){
+        root--;
+    }
+    while ((root + 1) * (root + 1) <= value){
+        root++;
+    }
+    return root;
+}
+
+// Q15 dot product, taps and window run forward over contiguous memory
+static int32_t _adxl343_filter_dot(const int16_t* taps, const int16_t* window, size_t length){
+    int32_t sum = 0;
+    size_t i = 0;
+#if ADXL343_FILTER_SIMD && defined(__SSE2__)
+    // pmaddwd multiplies 8 pairs and adds neighbouring products into 4 int32 lanes
+    __m128i lanes = _mm_setzero_si128();
+    for (; i + 8 <= length; i += 8){
+        __m128i t = _mm_loadu_si128((const __m128i*) &taps[i]);
+        __m128i w = _mm_loadu_si128((const __m128i*) &window[i]);
+        lanes = _mm_add_epi32(lanes, _mm_madd_epi16(t, w));
+    }
+    lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(1, 0, 3, 2)));
+    lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm_cvtsi128_si32(lanes);
+#elif ADXL343_FILTER_SIMD
+    int32x4_t lanes = vdupq_n_s32(0);
+    for (; i + 8 <= length; i += 8){
+        int16x8_t t = vld1q_s16(&taps[i]);
+        int16x8_t w = vld1q_s16(&window[i]);
+        lanes = vmlal_s16(lanes, vget_low_s16(t), vget_low_s16(w));
+        lanes = vmlal_s16(lanes, vget_high_s16(t), vget_high_s16(w));
+    }
+    int32x2_t pair = vadd_s32(vget_low_s32(lanes), vget_high_s32(lanes));
+    sum = vget_lane_s32(vpadd_s32(pair, pair), 0);
+#endif
+    for (; i < length; i++){
+        sum += (int32_t) taps[i] * window[i];
+    }
+    return sum;
+}
+
+static void _adxl343_filter_run_biquad(ADXL343Biquad* biquad, int16_t* values, size_t count, int axis){
+    const ADXL343BiquadCoeffs c = biquad->coeffs;
+    int32_t x1 = biquad->x1[axis];
+    int32_t x2 = biquad->x2[axis];
+    int32_t y1 = biquad->y1[axis];
+    int32_t y2 = biquad->y2[axis];
+    for (size_t i = 0; i < count; i++){
+        int32_t x = values[i];
+        // Inputs are integers and outputs Q8, both sides of the difference equation in Q36
+        int64_t acc = ((int64_t) c.b0 * x + (int64_t) c.b1 * x1 + (int64_t) c.b2 * x2) * ADXL343_FILTER_ONE_Q8;
+        acc -= (int64_t) c.a1 * y1 + (int64_t) c.a2 * y2;
+        int32_t y = (int32_t) ((acc + (1LL << (ADXL343_FILTER_BIQUAD_Q - 1))) >> ADXL343_FILTER_BIQUAD_Q);
+        // Keep the state in the output range so an unstable or overdriven section can not overflow it
+        if (y > INT16_MAX * ADXL343_FILTER_ONE_Q8){
+            y = INT16_MAX * ADXL343_FILTER_ONE_Q8;
+        }
+        else if (y < INT16_MIN * ADXL343_FILTER_ONE_Q8){
+            y = INT16_MIN * ADXL343_FILTER_ONE_Q8;
+        }
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        values[i] = _adxl343_filter_from_q8(y);
+    }
+    biquad->x1[axis] = x1;
+    biquad->x2[axis] = x2;
+    biquad->y1[axis] = y1;
+    biquad->y2[axis] = y2;
+}
+
+static size_t _adxl343_filter_run_fir(ADXL343FirDecimator* fir, int16_t* values, size_t count, int axis){
+    int16_t* history = fir->history[axis];
+    const size_t keep = fir->length - 1;
+    // Behind the last length - 1 inputs, so the window of every output is contiguous
+    memcpy(&history[keep], values, count * sizeof(int16_t));
+    size_t output = 0;
+    for (size_t i = fir->phase; i < count; i += fir->factor){
+        int32_t sum = _adxl343_filter_dot(fir->taps, &history[i], fir->length);
+        values[output++] = _adxl343_filter_saturate((sum + (1 << (ADXL343_FILTER_FIR_Q - 1))) >> ADXL343_FILTER_FIR_Q);
+    }
+    memmove(history, &history[count], keep * sizeof(int16_t));
+    return output;
+}
+
+static void _adxl343_filter_run_dc_block(ADXL343DcBlock* dc, int16_t* values, size_t count, int axis){
+    const uint8_t shift = dc->shift;
+    int32_t x1 = dc->x1[axis];
+    int32_t y1 = dc->y1[axis];
+    for (size_t i = 0; i < count; i++){
+        int32_t x = values[i];
+        y1 = (x - x1) * ADXL343_FILTER_ONE_Q8 + y1 - (y1 >> shift);
+        x1 = x;
+        values[i] = _adxl343_filter_from_q8(y1);
+    }
+    dc->x1[axis] = x1;
+    dc->y1[axis] = y1;
+}
+
+static void _adxl343_filter_run_rms(ADXL343MovingRms* rms, int16_t* values, size_t count, int axis){
+    uint32_t* squares = rms->squares[axis];
+    const uint16_t mask = rms->window - 1;
+    uint16_t index = rms->index;
+    uint64_t sum = rms->sum[axis];
+    uint32_t root = rms->root[axis];
+    for (size_t i = 0; i < count; i++){
+        uint32_t square = (uint32_t) ((int32_t) values[i] * values[i]);
+        sum = sum + square - squares[index];
+        squares[index] = square;
+        index = (index + 1) & mask;
+        root = _adxl343_filter_isqrt_near((uint32_t) (sum >> rms->log2_window), root);
+        values[i] = (int16_t) ((root > INT16_MAX) ? INT16_MAX : root);
+    }
+    rms->sum[axis] = sum;
+    rms->root[axis] = root;
+}
+
+static size_t _adxl343_filter_run_stage(ADXL343FilterStage* stage, int16_t work[3][ADXL343_FILTER_BLOCK],
+                                        size_t count){
+    size_t output = count;
+    switch (stage->type){
+        case ADXL343_FILTER_BIQUAD:
+            for (int axis = 0; axis < 3; axis++){
+                _adxl343_filter_run_biquad(&stage->biquad, work[axis], count, axis);
+            }
+            break;
+        case ADXL343_FILTER_FIR_DECIMATOR:
+            for (int axis = 0; axis < 3; axis++){
+                output = _adxl343_filter_run_fir(&stage->fir, work[axis], count, axis);
+            }
+            // Position of the next output in the following block
+            stage->fir.phase = (uint8_t) (stage->fir.phase + output * stage->fir.factor - count);
+            break;
+        case ADXL343_FILTER_DC_BLOCK:
+            for (int axis = 0; axis < 3; axis++){
+                _adxl343_filter_run_dc_block(&stage->dc, work[axis], count, axis);
+            }
+            break;
+        case ADXL343_FILTER_MOVING_RMS:
+            for (int axis = 0; axis < 3; axis++){
+                _adxl343_filter_run_rms(&stage->rms, work[axis], count, axis);
+            }
+            stage->rms.index = (uint16_t) ((stage->rms.index + count) & (stage->rms.window - 1));
+            break;
+        default:
+            break;
+    }
+    return output;
+}
+
+static void _adxl343_filter_reset_stage(ADXL343FilterStage* stage){
+    switch (stage->type){
+        case ADXL343_FILTER_BIQUAD:
+            memset(stage->biquad.x1, 0, sizeof(stage->biquad.x1));
+            memset(stage->biquad.x2, 0, sizeof(stage->biquad.x2));
+            memset(stage->biquad.y1, 0, sizeof(stage->biquad.y1));
+            memset(stage->biquad.y2, 0, sizeof(stage->biquad.y2));
+            break;
+        case ADXL343_FILTER_FIR_DECIMATOR:
+            memset(stage->fir.history, 0, sizeof(stage->fir.history));
+            // The first output has seen factor inputs
+            stage->fir.phase = stage->fir.factor - 1;
+            break;
+        case ADXL343_FILTER_DC_BLOCK:
+            memset(stage->dc.x1, 0, sizeof(stage->dc.x1));
+            memset(stage->dc.y1, 0, sizeof(stage->dc.y1));
+            break;
+        case ADXL343_FILTER_MOVING_RMS:
+            memset(stage->rms.squares, 0, sizeof(stage->rms.squares));
+            memset(stage->rms.sum, 0, sizeof(stage->rms.sum));
+            memset(stage->rms.root, 0, sizeof(stage->rms.root));
+            stage->rms.index = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+// Functions
+FunctionStatus adxl343_filter_biquad(ADXL343FilterStage* stage, const ADXL343BiquadCoeffs* coeffs){
+    if (stage == NULL || coeffs == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    stage->type = ADXL343_FILTER_BIQUAD;
+    stage->biquad.coeffs = *coeffs;
+    _adxl343_filter_reset_stage(stage);
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_filter_fir_decimator(ADXL343FilterStage* stage, const int16_t* taps, size_t length,
+                                            uint8_t factor){
+    if (stage == NULL || taps == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (length == 0 || length > ADXL343_FILTER_MAX_TAPS){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    if (factor == 0 || factor > ADXL343_FILTER_MAX_DECIMATION){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    stage->type = ADXL343_FILTER_FIR_DECIMATOR;
+    stage->fir.length = (uint16_t) length;
+    stage->fir.factor = factor;
+    // Reversed, the oldest sample of the window meets h[length - 1]
+    for (size_t i = 0; i < length; i++){
+        stage->fir.taps[i] = taps[length - 1 - i];
+    }
+    _adxl343_filter_reset_stage(stage);
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_filter_dc_block(ADXL343FilterStage* stage, uint8_t shift){
+    if (stage == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (shift == 0 || shift > 15){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    stage->type = ADXL343_FILTER_DC_BLOCK;
+    stage->dc.shift = shift;
+    _adxl343_filter_reset_stage(stage);
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_filter_moving_rms(ADXL343FilterStage* stage, size_t window){
+    if (stage == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (window == 0 || window > ADXL343_FILTER_MAX_RMS_WINDOW || (window & (window - 1)) != 0){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    stage->type = ADXL343_FILTER_MOVING_RMS;
+    stage->rms.window = (uint16_t) window;
+    stage->rms.log2_window = 0;
+    while ((1u << stage->rms.log2_window) < window){
+        stage->rms.log2_window++;
+    }
+    _adxl343_filter_reset_stage(stage);
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_filter_init(ADXL343FilterPipeline* pipeline, ADXL343FilterStage* stages, size_t count){
+    if (pipeline == NULL || (stages == NULL && count > 0)){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    for (size_t i = 0; i < count; i++){
+        if (stages[i].type < ADXL343_FILTER_BIQUAD || stages[i].type > ADXL343_FILTER_MOVING_RMS){
+            return FUNCTION_STATUS_NOT_INITIALIZED;
+        }
+    }
+    pipeline->stages = stages;
+    pipeline->count = count;
+
+    return FUNCTION_STATUS_OK;
+}
+
+void adxl343_filter_reset(ADXL343FilterPipeline* pipeline){
+    if (pipeline == NULL){return;}
+    for (size_t i = 0; i < pipeline->count; i++){
+        _adxl343_filter_reset_stage(&pipeline->stages[i]);
+    }
+}
+
+FunctionStatus adxl343_filter_process(ADXL343FilterPipeline* pipeline, ADXL343Sample* samples, size_t count,
+                                      size_t* output){
+    if (pipeline == NULL || (samples == NULL && count > 0) || output == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    size_t written = 0;
+    for (size_t start = 0; start < count; start += ADXL343_FILTER_BLOCK){
+        size_t n = (count - start < ADXL343_FILTER_BLOCK) ? count - start : ADXL343_FILTER_BLOCK;
+        for (size_t i = 0; i < n; i++){
+            pipeline->work[0][i] = samples[start + i].x;
+            pipeline->work[1][i] = samples[start + i].y;
+            pipeline->work[2][i] = samples[start + i].z;
+        }
+        for (size_t s = 0; s < pipeline->count && n > 0; s++){
+            n = _adxl343_filter_run_stage(&pipeline->stages[s], pipeline->work, n);
+        }
+        // Decimation only ever shrinks a block, the output never overtakes the input still to be read
+        for (size_t i = 0; i < n; i++){
+            samples[written + i].x = pipeline->work[0][i];
+            samples[written + i].y = pipeline->work[1][i];
+            samples[written + i].z = pipeline->work[2][i];
+        }
+        written += n;
+    }
+    *output = written;
+
+    return FUNCTION_STATUS_OK;
+}
@@ -0,0 +1,175 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  adxl343_reduce.c
+/// \brief deadband and swinging door reduction of timestamped adxl343 samples
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_reduce.h"
+
+#include <string.h>
+
+
+// Statics
+static inline void _adxl343_reduce_emit(ADXL343Reducer* reducer, const ADXL343ReducedPoint* point,
+                                        ADXL343ReducedPoint* points, size_t* written){
+    points[(*written)++] = *point;
+    reducer->outputs++;
+    // The point starts the next segment
+    reducer->anchor = *point;
+    reducer->pending = 0;
+    reducer->doors = 0;
+}
+
+static inline int _adxl343_reduce_heartbeat(const ADXL343Reducer* reducer, uint64_t timestamp){
+    const uint64_t heartbeat = reducer->config.heartbeat_ns;
+    return heartbeat != 0 && timestamp - reducer->anchor.timestamp >= heartbeat;
+}
+
+static int _adxl343_reduce_moved(const ADXL343Reducer* reducer, const ADXL343Sample* sample){
+    const int16_t* values = &sample->x;
+    const int16_t* last = &reducer->anchor.sample.x;
+    for (int axis = 0; axis < 3; axis++){
+        int32_t delta = (int32_t) values[axis] - last[axis];
+        if (delta > reducer->config.threshold[axis] || -delta > reducer->config.threshold[axis]){return 1;}
+    }
+    return 0;
+}
+
+// The line from the anchor to the point passes within the bound of every sample in between
+static int _adxl343_reduce_fits(const ADXL343Reducer* reducer, const ADXL343ReducedPoint* point){
+    if (!reducer->doors){return 1;}
+    const int64_t span = (int64_t) (point->timestamp - reducer->anchor.timestamp);
+    const int16_t* values = &point->sample.x;
+    const int16_t* start = &reducer->anchor.sample.x;
+    for (int axis = 0; axis < 3; axis++){
+        // Slopes compared as fractions, every denominator is positive
+        int64_t rise = (int64_t) values[axis] - start[axis];
+        if (rise * reducer->upper_den[axis] > (int64_t) reducer->upper_num[axis] * span){return 0;}
+        if (rise * reducer->lower_den[axis] < (int64_t) reducer->lower_num[axis] * span){return 0;}
+    }
+    return 1;
+}
+
+// Narrows the doors to the slopes that keep the point within the bound
+static void _adxl343_reduce_narrow(ADXL343Reducer* reducer, const ADXL343ReducedPoint* point){
+    const int64_t span = (int64_t) (point->timestamp - reducer->anchor.timestamp);
+    const int16_t* values = &point->sample.x;
+    const int16_t* start = &reducer->anchor.sample.x;
+    for (int axis = 0; axis < 3; axis++){
+        int32_t rise = (int32_t) values[axis] - start[axis];
+        int32_t upper = rise + reducer->config.threshold[axis];
+        int32_t lower = rise - reducer->config.threshold[axis];
+        if (!reducer->doors || (int64_t) upper * reducer->upper_den[axis] < (int64_t) reducer->upper_num[axis] * span){
+            reducer->upper_num[axis] = upper;
+            reducer->upper_den[axis] = span;
+        }
+        if (!reducer->doors || (int64_t) lower * reducer->lower_den[axis] > (int64_t) reducer->lower_num[axis] * span){
+            reducer->lower_num[axis] = lower;
+            reducer->lower_den[axis] = span;
+        }
+    }
+    reducer->doors = 1;
+}
+
+static void _adxl343_reduce_swinging_door(ADXL343Reducer* reducer, const ADXL343ReducedPoint* point,
+                                          ADXL343ReducedPoint* points, size_t* written){
+    const uint64_t timestamp = point->timestamp;
+    // No line can reach a sample back in time or too far ahead, it starts a segment of its own
+    const int jumped = timestamp <= reducer->anchor.timestamp
+                       || timestamp - reducer->anchor.timestamp >= ADXL343_REDUCE_MAX_SPAN_NS;
+    if (jumped || !_adxl343_reduce_fits(reducer, point)){
+        // The segment ends at the last sample it could reach, the next one starts there
+        if (reducer->pending){
+            _adxl343_reduce_emit(reducer, &reducer->previous, points, written);
+        }
+        if (jumped){
+            _adxl343_reduce_emit(reducer, point, points, written);
+            return;
+        }
+    }
+    if (_adxl343_reduce_heartbeat(reducer, timestamp)){
+        _adxl343_reduce_emit(reducer, point, points, written);
+        return;
+    }
+    // The point may end the segment, from the next sample on it lies in between
+    reducer->previous = *point;
+    reducer->pending = 1;
+    _adxl343_reduce_narrow(reducer, point);
+}
+
+
+// Functions
+FunctionStatus adxl343_reduce_init(ADXL343Reducer* reducer, const ADXL343ReduceConfig* config){
+    if (reducer == NULL || config == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (config->mode != ADXL343_REDUCE_DEADBAND && config->mode != ADXL343_REDUCE_SWINGING_DOOR){
+        return FUNCTION_STATUS_BOUNDARY_ERROR;
+    }
+    for (int axis = 0; axis < 3; axis++){
+        if (config->threshold[axis] > ADXL343_REDUCE_MAX_THRESHOLD){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    }
+
+    memset(reducer, 0, sizeof(*reducer));
+    reducer->config = *config;
+
+    return FUNCTION_STATUS_OK;
+}
+
+void adxl343_reduce_reset(ADXL343Reducer* reducer){
+    if (reducer == NULL){return;}
+    reducer->started = 0;
+    reducer->pending = 0;
+    reducer->doors = 0;
+    reducer->inputs = 0;
+    reducer->outputs = 0;
+}
+
+FunctionStatus adxl343_reduce_push(ADXL343Reducer* reducer, const ADXL343Sample* samples, const uint64_t* timestamps,
+                                   size_t count, ADXL343ReducedPoint* points, size_t max, size_t* consumed,
+                                   size_t* emitted){
+    if (reducer == NULL || consumed == NULL || emitted == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if ((count != 0 && (samples == NULL || timestamps == NULL)) || (points == NULL && max != 0)){
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+    *consumed = 0;
+    *emitted = 0;
+    if (reducer->config.mode == 0){return FUNCTION_STATUS_NOT_INITIALIZED;}
+
+    const size_t room = (reducer->config.mode == ADXL343_REDUCE_SWINGING_DOOR) ? 2 : 1;
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++){
+        if (max - written < room){
+            *consumed = i;
+            *emitted = written;
+            return FUNCTION_STATUS_BUSY;
+        }
+        ADXL343ReducedPoint point = {timestamps[i], samples[i]};
+        reducer->inputs++;
+        if (!reducer->started){
+            reducer->started = 1;
+            _adxl343_reduce_emit(reducer, &point, points, &written);
+        }
+        else if (reducer->config.mode == ADXL343_REDUCE_SWINGING_DOOR){
+            _adxl343_reduce_swinging_door(reducer, &point, points, &written);
+        }
+        else if (_adxl343_reduce_moved(reducer, &point.sample) || point.timestamp < reducer->anchor.timestamp
+                 || _adxl343_reduce_heartbeat(reducer, point.timestamp)){
+            _adxl343_reduce_emit(reducer, &point, points, &written);
+        }
+    }
+    *consumed = count;
+    *emitted = written;
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_reduce_flush(ADXL343Reducer* reducer, ADXL343ReducedPoint* points, size_t max,
+                                    size_t* emitted){
+    if (reducer == NULL || emitted == NULL || (points == NULL && max != 0)){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    *emitted = 0;
+    if (reducer->config.mode == 0){return FUNCTION_STATUS_NOT_INITIALIZED;}
+    if (!reducer->pending){return FUNCTION_STATUS_OK;}
+    if (max == 0){return FUNCTION_STATUS_BUSY;}
+
+    _adxl343_reduce_emit(reducer, &reducer->previous, points, emitted);
+
+    return FUNCTION_STATUS_OK;
+}
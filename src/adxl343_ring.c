@@ -0,0 +1,114 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  adxl343_ring.c
+/// \brief lock-free single producer/single consumer ring of adxl343 samples
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_ring.h"
+
+#include <string.h>
+
+
+// Functions
+FunctionStatus adxl343_ring_init(ADXL343Ring* ring, ADXL343Sample* storage, size_t capacity){
+    if (ring == NULL || storage == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->overruns, 0);
+    ring->cached_tail = 0;
+    ring->cached_head = 0;
+    ring->storage = storage;
+    ring->mask = capacity - 1;
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_ring_reserve(ADXL343Ring* ring, ADXL343Sample** span, size_t* length){
+    if (ring == NULL || span == NULL || length == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t capacity = ring->mask + 1;
+    size_t to_end = capacity - (head & ring->mask);
+    // Only go to the consumer's cache line when the cached tail cannot fill the whole span
+    size_t space = capacity - (head - ring->cached_tail);
+    if (space < to_end){
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        space = capacity - (head - ring->cached_tail);
+    }
+    *span = &ring->storage[head & ring->mask];
+    *length = (space < to_end) ? space : to_end;
+
+    return FUNCTION_STATUS_OK;
+}
+
+void adxl343_ring_commit(ADXL343Ring* ring, size_t count){
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+}
+
+FunctionStatus adxl343_ring_push(ADXL343Ring* ring, const ADXL343Sample* samples, size_t count){
+    FunctionStatus result;
+    if (ring == NULL || (samples == NULL && count > 0)){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // At most two spans, before and after the wrap
+    while (count > 0){
+        ADXL343Sample* span;
+        size_t length;
+        result = adxl343_ring_reserve(ring, &span, &length);
+        if (result != FUNCTION_STATUS_OK){return result;}
+        if (length == 0){
+            adxl343_ring_drop(ring, count);
+            return FUNCTION_STATUS_BOUNDARY_ERROR;
+        }
+        if (length > count){
+            length = count;
+        }
+        memcpy(span, samples, length * sizeof(ADXL343Sample));
+        adxl343_ring_commit(ring, length);
+        samples += length;
+        count -= length;
+    }
+
+    return FUNCTION_STATUS_OK;
+}
+
+void adxl343_ring_drop(ADXL343Ring* ring, size_t count){
+    if (count == 0){return;}
+    atomic_fetch_add_explicit(&ring->dropped, (uint32_t) count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ring->overruns, 1, memory_order_relaxed);
+}
+
+FunctionStatus adxl343_ring_peek(ADXL343Ring* ring, const ADXL343Sample** span, size_t* length){
+    if (ring == NULL || span == NULL || length == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t to_end = (ring->mask + 1) - (tail & ring->mask);
+    // Only go to the producer's cache line when the cached head cannot fill the whole span
+    size_t used = ring->cached_head - tail;
+    if (used < to_end){
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        used = ring->cached_head - tail;
+    }
+    *span = &ring->storage[tail & ring->mask];
+    *length = (used < to_end) ? used : to_end;
+
+    return FUNCTION_STATUS_OK;
+}
+
+void adxl343_ring_consume(ADXL343Ring* ring, size_t count){
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+}
+
+size_t adxl343_ring_size(ADXL343Ring* ring){
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return head - tail;
+}
+
+void adxl343_ring_get_counters(ADXL343Ring* ring, uint32_t* dropped, uint32_t* overruns){
+    if (dropped != NULL){
+        *dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    }
+    if (overruns != NULL){
+        *overruns = atomic_load_explicit(&ring->overruns, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,117 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  adxl343_timeline.c
+/// \brief back-dating of adxl343 FIFO batches onto the host clock
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_timeline.h"
+
+
+// Statics
+static void _adxl343_timeline_advance(ADXL343Timeline* timeline, uint64_t step_q16){
+    uint64_t frac = (uint64_t) timeline->last_frac + (step_q16 & 0xFFFF);
+    timeline->last_ns += (step_q16 >> 16) + (frac >> 16);
+    timeline->last_frac = (uint32_t) (frac & 0xFFFF);
+}
+
+static void _adxl343_timeline_anchor(ADXL343Timeline* timeline, int64_t newest_ns, size_t count){
+    // Place the sample before the batch so stamping lands the newest one on newest_ns
+    uint64_t back_q16 = (uint64_t) count * timeline->period_q16;
+    uint32_t back_frac = (uint32_t) (back_q16 & 0xFFFF);
+    timeline->last_ns = (uint64_t) newest_ns - (back_q16 >> 16) - (back_frac != 0);
+    timeline->last_frac = (back_frac != 0) ? 0x10000 - back_frac : 0;
+    timeline->ref_ns = (uint64_t) newest_ns;
+    timeline->ref_index = timeline->index + count - 1;
+}
+
+static void _adxl343_timeline_estimate(ADXL343Timeline* timeline, int64_t newest_ns, uint64_t newest_index){
+    uint64_t n = newest_index - timeline->ref_index;
+    // After a re-anchor the old estimate stays until the new baseline can match it
+    uint64_t needed = (timeline->baseline < ADXL343_TIMELINE_MAX_BASELINE / 2) ? timeline->baseline
+                                                                               : ADXL343_TIMELINE_MAX_BASELINE / 2;
+    if (needed < ADXL343_TIMELINE_MIN_BASELINE){
+        needed = ADXL343_TIMELINE_MIN_BASELINE;
+    }
+    if (n < needed || newest_ns <= (int64_t) timeline->ref_ns){return;}
+    uint64_t diff = (uint64_t) newest_ns - timeline->ref_ns;
+    uint64_t estimate = ((diff / n) << 16) + (((diff % n) << 16) / n);
+    uint64_t limit = (timeline->nominal_q16 / 1000000) * ADXL343_TIMELINE_MAX_DRIFT_PPM;
+    if (estimate + limit < timeline->nominal_q16 || estimate > timeline->nominal_q16 + limit){return;}
+    timeline->period_q16 = estimate;
+    timeline->baseline = n;
+    // Keep the baseline long: move its start up by half along the estimated period instead of restarting it, the new
+    // start is the average of the old start and the newest reading so its error does not grow
+    if (n >= ADXL343_TIMELINE_MAX_BASELINE){
+        uint64_t half = n / 2;
+        timeline->ref_ns += (half * estimate) >> 16;
+        timeline->ref_index += half;
+    }
+}
+
+// Functions
+FunctionStatus adxl343_timeline_init(ADXL343Timeline* timeline, uint8_t rate){
+    if (timeline == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (rate > 0x0F){return FUNCTION_STATUS_BOUNDARY_ERROR;}
+    timeline->rate = rate;
+    timeline->anchored = 0;
+    // ODR = 3200 Hz >> (15 - rate)
+    timeline->nominal_q16 = ((1000000000ULL << (15 - rate)) << 16) / 3200;
+    timeline->period_q16 = timeline->nominal_q16;
+    timeline->last_ns = 0;
+    timeline->last_frac = 0;
+    timeline->index = 0;
+    timeline->ref_ns = 0;
+    timeline->ref_index = 0;
+    timeline->baseline = 0;
+    timeline->resyncs = 0;
+
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus adxl343_timeline_stamp(ADXL343Timeline* timeline, uint64_t host_ns, size_t entries,
+                                      uint64_t* timestamps, size_t count){
+    if (timeline == NULL || (timestamps == NULL && count > 0)){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (count > entries){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    if (timeline->nominal_q16 == 0){return FUNCTION_STATUS_NOT_INITIALIZED;}
+    if (count == 0){return FUNCTION_STATUS_OK;}
+
+    // The newest entry was taken on average half a period before the reading, the older ones a period apart
+    uint64_t period_ns = timeline->period_q16 >> 16;
+    int64_t newest_ns = (int64_t) host_ns - (int64_t) (period_ns / 2) - (int64_t) ((entries - count) * period_ns);
+
+    if (!timeline->anchored){
+        _adxl343_timeline_anchor(timeline, newest_ns, count);
+        timeline->anchored = 1;
+    }
+    else {
+        ADXL343Timeline predicted = *timeline;
+        _adxl343_timeline_advance(&predicted, count * timeline->period_q16);
+        int64_t error = newest_ns - (int64_t) predicted.last_ns;
+        int64_t limit = (int64_t) ((timeline->nominal_q16 >> 16) * ADXL343_TIMELINE_RESYNC_PERIODS);
+        if (error > limit || error < -limit){
+            // Samples were lost or the drain was far off, the old timeline no longer lines up
+            _adxl343_timeline_anchor(timeline, newest_ns, count);
+            timeline->resyncs++;
+        }
+        else {
+            _adxl343_timeline_estimate(timeline, newest_ns, timeline->index + count - 1);
+            // Pull the phase towards the reading a fraction at a time, the reading jitters by up to a period
+            int64_t correction = error / ADXL343_TIMELINE_PHASE_GAIN;
+            timeline->last_ns = (uint64_t) ((int64_t) timeline->last_ns + correction);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++){
+        _adxl343_timeline_advance(timeline, timeline->period_q16);
+        timestamps[i] = timeline->last_ns;
+    }
+    timeline->index += count;
+
+    return FUNCTION_STATUS_OK;
+}
+
+int32_t adxl343_timeline_drift_ppm(const ADXL343Timeline* timeline){
+    if (timeline == NULL || timeline->nominal_q16 == 0){return 0;}
+    int64_t delta = (int64_t) timeline->period_q16 - (int64_t) timeline->nominal_q16;
+    // Q16 periods reach 2^59 at the lowest rates, scale the divisor down instead of the delta up
+    return (int32_t) (delta / (int64_t) (timeline->nominal_q16 / 1000000));
+}
@@ -20,6 +20,7 @@
 // --------------------------------------------------------------------------------------------------------------------
 // File-scope variables
 // --------------------------------------------------------------------------------------------------------------------
+static const I2CBackend* i2c_backend = NULL;
 
 // --------------------------------------------------------------------------------------------------------------------
 // Function declarations
@@ -28,12 +29,21 @@
 // --------------------------------------------------------------------------------------------------------------------
 // Function definitions
 // --------------------------------------------------------------------------------------------------------------------
+void i2c_set_backend(const I2CBackend* backend)
+{
+    i2c_backend = backend;
+}
+
 FunctionStatus i2c_write(const char* dataToWrite, size_t length, uint32_t timeout)
 {
     if (dataToWrite == NULL)
     {
         return FUNCTION_STATUS_ARGUMENT_ERROR;
     }
+    if (i2c_backend != NULL)
+    {
+        return i2c_backend->write(i2c_backend->context, dataToWrite, length, timeout);
+    }
 
     // Assume there is a nice implementation of I2C driver here :)
 
@@ -46,9 +56,31 @@ FunctionStatus i2c_read(char* dataToRead, size_t length, uint32_t timeout)
     {
         return FUNCTION_STATUS_ARGUMENT_ERROR;
     }
+    if (i2c_backend != NULL)
+    {
+        return i2c_backend->read(i2c_backend->context, dataToRead, length, timeout);
+    }
 
     // Assume there is a nice implementation of I2C driver here :)
 
     return FUNCTION_STATUS_OK;
 }
 
+FunctionStatus i2c_write_read(const char* dataToWrite, size_t writeLength, char* dataToRead, size_t readLength,
+                              uint32_t timeout)
+{
+    if (dataToWrite == NULL || dataToRead == NULL)
+    {
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+    if (i2c_backend != NULL)
+    {
+        return i2c_backend->write_read(i2c_backend->context, dataToWrite, writeLength, dataToRead, readLength,
+                                       timeout);
+    }
+
+    // Assume there is a nice implementation of a repeated-start I2C transfer here :)
+
+    return FUNCTION_STATUS_OK;
+}
+
@@ -0,0 +1,202 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  i2c_linux.c
+/// \brief i2c_driver backend on a Linux i2c-dev userspace adapter
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Include files
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "i2c_linux.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+// Constant and macro definitions
+// --------------------------------------------------------------------------------------------------------------------
+#define I2C_LINUX_TIMEOUT_UNIT 10               //!< I2C_TIMEOUT is set in units of 10 ms
+
+// --------------------------------------------------------------------------------------------------------------------
+// Type definitions
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// File-scope variables
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Function declarations
+// --------------------------------------------------------------------------------------------------------------------
+#ifdef __linux__
+static FunctionStatus _i2c_linux_write(void* context, const char* dataToWrite, size_t length, uint32_t timeout);
+static FunctionStatus _i2c_linux_read(void* context, char* dataToRead, size_t length, uint32_t timeout);
+static FunctionStatus _i2c_linux_write_read(void* context, const char* dataToWrite, size_t writeLength,
+                                            char* dataToRead, size_t readLength, uint32_t timeout);
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+// Function definitions
+// --------------------------------------------------------------------------------------------------------------------
+#ifdef __linux__
+static FunctionStatus _i2c_linux_status(int error)
+{
+    switch (error)
+    {
+    case ETIMEDOUT:
+        return FUNCTION_STATUS_TIMEOUT;
+    case EINVAL:
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    case EAGAIN:
+    case EBUSY:
+        return FUNCTION_STATUS_BUSY;
+    default:
+        // No acknowledge (ENXIO, EREMOTEIO), arbitration lost (EAGAIN on some adapters) and bus errors
+        return FUNCTION_STATUS_ERROR;
+    }
+}
+
+static FunctionStatus _i2c_linux_transfer(I2CLinuxAdapter* adapter, struct i2c_msg* messages, uint32_t count,
+                                          uint32_t timeout)
+{
+    struct i2c_rdwr_ioctl_data transfer;
+
+    if (adapter->fd < 0)
+    {
+        return FUNCTION_STATUS_NOT_INITIALIZED;
+    }
+    // The adapter timeout is only changed when it differs, most calls use the same one
+    if (timeout != adapter->timeout)
+    {
+        unsigned long units = (timeout + I2C_LINUX_TIMEOUT_UNIT - 1) / I2C_LINUX_TIMEOUT_UNIT;
+        if (ioctl(adapter->fd, I2C_TIMEOUT, units) < 0)
+        {
+            return _i2c_linux_status(errno);
+        }
+        adapter->timeout = timeout;
+    }
+
+    transfer.msgs = messages;
+    transfer.nmsgs = count;
+    if (ioctl(adapter->fd, I2C_RDWR, &transfer) < 0)
+    {
+        return _i2c_linux_status(errno);
+    }
+
+    return FUNCTION_STATUS_OK;
+}
+
+static FunctionStatus _i2c_linux_write(void* context, const char* dataToWrite, size_t length, uint32_t timeout)
+{
+    I2CLinuxAdapter* adapter = context;
+    struct i2c_msg message;
+
+    if (length == 0)
+    {
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+    // [device address, data...], the kernel adds the address byte itself
+    adapter->address = ((uint8_t) dataToWrite[0]) >> 1;
+    message.addr = adapter->address;
+    message.flags = 0;
+    message.len = (uint16_t) (length - 1);
+    message.buf = (uint8_t*) &dataToWrite[1];
+
+    return _i2c_linux_transfer(adapter, &message, 1, timeout);
+}
+
+static FunctionStatus _i2c_linux_read(void* context, char* dataToRead, size_t length, uint32_t timeout)
+{
+    I2CLinuxAdapter* adapter = context;
+    struct i2c_msg message;
+
+    // Reads from the device addressed last, at its current register pointer
+    message.addr = adapter->address;
+    message.flags = I2C_M_RD;
+    message.len = (uint16_t) length;
+    message.buf = (uint8_t*) dataToRead;
+
+    return _i2c_linux_transfer(adapter, &message, 1, timeout);
+}
+
+static FunctionStatus _i2c_linux_write_read(void* context, const char* dataToWrite, size_t writeLength,
+                                            char* dataToRead, size_t readLength, uint32_t timeout)
+{
+    I2CLinuxAdapter* adapter = context;
+    struct i2c_msg messages [2];
+
+    if (writeLength == 0)
+    {
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+    // Both messages in one ioctl, the adapter joins them with a repeated start
+    adapter->address = ((uint8_t) dataToWrite[0]) >> 1;
+    messages[0].addr = adapter->address;
+    messages[0].flags = 0;
+    messages[0].len = (uint16_t) (writeLength - 1);
+    messages[0].buf = (uint8_t*) &dataToWrite[1];
+    messages[1].addr = adapter->address;
+    messages[1].flags = I2C_M_RD;
+    messages[1].len = (uint16_t) readLength;
+    messages[1].buf = (uint8_t*) dataToRead;
+
+    return _i2c_linux_transfer(adapter, messages, 2, timeout);
+}
+#endif
+
+FunctionStatus i2c_linux_open(I2CLinuxAdapter* adapter, const char* path)
+{
+    if (adapter == NULL || path == NULL)
+    {
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+    adapter->fd = -1;
+    adapter->address = 0;
+    adapter->timeout = 0;
+    adapter->backend.context = adapter;
+
+#ifdef __linux__
+    unsigned long functionality = 0;
+
+    adapter->backend.write = _i2c_linux_write;
+    adapter->backend.read = _i2c_linux_read;
+    adapter->backend.write_read = _i2c_linux_write_read;
+    adapter->fd = open(path, O_RDWR);
+    if (adapter->fd < 0)
+    {
+        return FUNCTION_STATUS_ERROR;
+    }
+    // Combined messages need a plain I2C adapter, SMBus-only adapters can not do them
+    if (ioctl(adapter->fd, I2C_FUNCS, &functionality) < 0 || !(functionality & I2C_FUNC_I2C))
+    {
+        i2c_linux_close(adapter);
+        return FUNCTION_STATUS_ERROR;
+    }
+
+    return FUNCTION_STATUS_OK;
+#else
+    adapter->backend.write = NULL;
+    adapter->backend.read = NULL;
+    adapter->backend.write_read = NULL;
+
+    return FUNCTION_STATUS_ERROR;
+#endif
+}
+
+void i2c_linux_close(I2CLinuxAdapter* adapter)
+{
+    if (adapter == NULL || adapter->fd < 0)
+    {
+        return;
+    }
+#ifdef __linux__
+    close(adapter->fd);
+#endif
+    adapter->fd = -1;
+}
@@ -0,0 +1,146 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  i2c_queue.c
+/// \brief Non-blocking transaction queue on top of the blocking I2C primitives
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Include files
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifdef UNITTEST
+#define i2c_write mock_i2c_write
+#define i2c_read mock_i2c_read
+#define i2c_write_read mock_i2c_write_read
+#endif
+
+#include "i2c_driver.h"
+
+#include <stdatomic.h>
+
+// --------------------------------------------------------------------------------------------------------------------
+// Constant and macro definitions
+// --------------------------------------------------------------------------------------------------------------------
+
+#define I2C_QUEUE_MASK (I2C_QUEUE_DEPTH - 1)
+
+// --------------------------------------------------------------------------------------------------------------------
+// Type definitions
+// --------------------------------------------------------------------------------------------------------------------
+
+//! Single producer/single consumer ring of transaction pointers
+typedef struct
+{
+    I2CTransaction* slots[I2C_QUEUE_DEPTH];
+    _Atomic size_t head;
+    _Atomic size_t tail;
+} I2CQueue;
+
+// --------------------------------------------------------------------------------------------------------------------
+// File-scope variables
+// --------------------------------------------------------------------------------------------------------------------
+
+// Submitted by the application, taken by i2c_process
+static I2CQueue i2c_pending;
+// Finished by i2c_process, taken by i2c_poll
+static I2CQueue i2c_finished;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Function declarations
+// --------------------------------------------------------------------------------------------------------------------
+
+static void i2c_queue_push(I2CQueue* queue, I2CTransaction* transaction);
+static I2CTransaction* i2c_queue_pop(I2CQueue* queue);
+static FunctionStatus i2c_execute(const I2CTransaction* transaction);
+
+// --------------------------------------------------------------------------------------------------------------------
+// Function definitions
+// --------------------------------------------------------------------------------------------------------------------
+FunctionStatus i2c_submit(I2CTransaction* transaction)
+{
+    if (transaction == NULL || transaction->type > I2C_TRANSACTION_WRITE_READ)
+    {
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+
+    // Everything submitted but not yet polled counts, so neither ring can overflow
+    size_t submitted = atomic_load_explicit(&i2c_pending.head, memory_order_relaxed);
+    size_t polled = atomic_load_explicit(&i2c_finished.tail, memory_order_relaxed);
+    if (submitted - polled >= I2C_QUEUE_DEPTH)
+    {
+        return FUNCTION_STATUS_BUSY;
+    }
+
+    transaction->status = FUNCTION_STATUS_PENDING;
+    i2c_queue_push(&i2c_pending, transaction);
+
+    return FUNCTION_STATUS_OK;
+}
+
+size_t i2c_process(void)
+{
+    size_t processed = 0;
+    I2CTransaction* transaction;
+
+    while ((transaction = i2c_queue_pop(&i2c_pending)) != NULL)
+    {
+        transaction->status = i2c_execute(transaction);
+        i2c_queue_push(&i2c_finished, transaction);
+        processed++;
+    }
+
+    return processed;
+}
+
+size_t i2c_poll(void)
+{
+    size_t completed = 0;
+    I2CTransaction* transaction;
+
+    while ((transaction = i2c_queue_pop(&i2c_finished)) != NULL)
+    {
+        if (transaction->callback != NULL)
+        {
+            transaction->callback(transaction, transaction->context);
+        }
+        completed++;
+    }
+
+    return completed;
+}
+
+static void i2c_queue_push(I2CQueue* queue, I2CTransaction* transaction)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    queue->slots[head & I2C_QUEUE_MASK] = transaction;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+}
+
+static I2CTransaction* i2c_queue_pop(I2CQueue* queue)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&queue->head, memory_order_acquire))
+    {
+        return NULL;
+    }
+
+    I2CTransaction* transaction = queue->slots[tail & I2C_QUEUE_MASK];
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+
+    return transaction;
+}
+
+static FunctionStatus i2c_execute(const I2CTransaction* transaction)
+{
+    switch (transaction->type)
+    {
+    case I2C_TRANSACTION_WRITE:
+        return i2c_write(transaction->dataToWrite, transaction->writeLength, transaction->timeout);
+    case I2C_TRANSACTION_READ:
+        return i2c_read(transaction->dataToRead, transaction->readLength, transaction->timeout);
+    case I2C_TRANSACTION_WRITE_READ:
+        return i2c_write_read(transaction->dataToWrite, transaction->writeLength, transaction->dataToRead,
+                              transaction->readLength, transaction->timeout);
+    default:
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+}
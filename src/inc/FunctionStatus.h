@@ -23,6 +23,9 @@ typedef enum
     FUNCTION_STATUS_ARGUMENT_ERROR,                     //!< At least one argument of the function was NULL (invalid)
     FUNCTION_STATUS_BOUNDARY_ERROR,                     //!< At least one argument is out of boundary
     FUNCTION_STATUS_TIMEOUT,                            //!< A timeout occurred during function execution
+    FUNCTION_STATUS_PENDING,                            //!< The operation was started and has not completed yet
+    FUNCTION_STATUS_BUSY,                               //!< The function execution was aborted because the resource
+                                                        //!< (e.g. a queue) is full or in use
     
     // Feel free to add customized return status if you need. ;)
 
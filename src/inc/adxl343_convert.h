@@ -0,0 +1,66 @@
+#ifndef INC_ADXL343_CONVERT_H_
+#define INC_ADXL343_CONVERT_H_
+
+/**
+ * @file adxl343_convert.h
+ * @brief Accelerometer Sample Conversion Interface
+ *
+ * This module converts blocks of decoded ADXL343 samples (e.g. a drained FIFO) into physical units, either fixed point
+ * milli-g or floating point m/s^2. The scale factor is derived from the range and resolution in the settings
+ * structure once per block. The kernels are plain loops over the interleaved X/Y/Z values that the compiler can
+ * auto-vectorize. An explicit SSE2/NEON path can be enabled by building with ADXL343_USE_SIMD defined.
+ *
+ * @{
+ */
+
+
+// Includes 
+// - Compiler includes
+#include <stdint.h>
+#include <stddef.h>
+// - Project includes
+#include "adxl343_driver.h"
+
+
+// Defines
+#define ADXL343_STANDARD_GRAVITY 9.80665f       // m/s^2 per g
+#if defined(ADXL343_USE_SIMD) && (defined(__SSE2__) || defined(__ARM_NEON))
+#define ADXL343_CONVERT_SIMD 1                  // Explicit SIMD kernels compiled in
+#else
+#define ADXL343_CONVERT_SIMD 0
+#endif
+
+
+// Functions
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Converts a block of samples to milli-g.
+ *
+ * Each sample is converted to three int32 values (X, Y, Z) in milli-g, written interleaved to the output buffer.
+ * The conversion is fixed point (scale factor in Q8), rounded to the nearest milli-g with halves away from zero,
+ * so a negative input converts to exactly the negative of the positive one.
+ *
+ * @param settings A pointer to the settings the samples were taken with (range and resolution are used).
+ * @param samples  A pointer to the samples to convert.
+ * @param mg       A pointer to a buffer of at least 3 * count values where the result will be stored.
+ * @param count    The number of samples to convert.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_convert_mg(const ADXL343Settings* settings, const ADXL343Sample* samples, int32_t* mg, size_t count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Converts a block of samples to m/s^2.
+ *
+ * Each sample is converted to three float values (X, Y, Z) in m/s^2, written interleaved to the output buffer.
+ *
+ * @param settings A pointer to the settings the samples were taken with (range and resolution are used).
+ * @param samples  A pointer to the samples to convert.
+ * @param ms2      A pointer to a buffer of at least 3 * count values where the result will be stored.
+ * @param count    The number of samples to convert.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_convert_ms2(const ADXL343Settings* settings, const ADXL343Sample* samples, float* ms2, size_t count);
+
+/** @} */
+
+#endif /* INC_ADXL343_CONVERT_H_ */
@@ -13,6 +13,12 @@
  * offers functions for initialization, toggling measurement mode, and configuring various parameters such as data rate,
  * measurement range, resolution, and bit order.
  *
+ * Every function operates on a device handle (ADXL343Device) that carries the I2C address, the bus the device is
+ * reached through, and the per-device register shadow and decode state. Several devices can therefore be used side
+ * by side, on the same bus (0x53 and the 0x1D alternate address) or on different buses. The register accesses go
+ * through a transport (ADXL343Transport), I2C for devices set up with adxl343_init and 4-wire SPI for devices set up
+ * with adxl343_init_spi.
+ *
  * It also includes functions for reading the acceleration data along each axis (X, Y, Z),
  * as well as retrieving all axes' data simultaneously.
  *
@@ -27,12 +33,32 @@
 // - Project includes
 #include "FunctionStatus.h"
 #include "i2c_driver.h"
+#include "spi_driver.h"
 
 
 // Defines
 // - Addresses and registers
+#define ADXL343_REG_CONFIG_START 0x1D           // First register of the configuration block (THRESH_TAP)
+#define ADXL343_REG_THRESH_TAP 0x1D             // Tap threshold
+#define ADXL343_REG_OFSX 0x1E                   // X axis offset
+#define ADXL343_REG_OFSY 0x1F                   // Y axis offset
+#define ADXL343_REG_OFSZ 0x20                   // Z axis offset
+#define ADXL343_REG_DUR 0x21                    // Tap duration
+#define ADXL343_REG_LATENT 0x22                 // Tap latency
+#define ADXL343_REG_WINDOW 0x23                 // Tap window
+#define ADXL343_REG_THRESH_ACT 0x24             // Activity threshold
+#define ADXL343_REG_THRESH_INACT 0x25           // Inactivity threshold
+#define ADXL343_REG_TIME_INACT 0x26             // Inactivity time
+#define ADXL343_REG_ACT_INACT_CTL 0x27          // Axis enable control for activity and inactivity detection
+#define ADXL343_REG_THRESH_FF 0x28              // Free-fall threshold
+#define ADXL343_REG_TIME_FF 0x29                // Free-fall time
+#define ADXL343_REG_TAP_AXES 0x2A               // Axis control for single tap/double tap
+#define ADXL343_REG_ACT_TAP_STATUS 0x2B         // Source of single tap/double tap (read only)
 #define ADXL343_REG_BW_RATE 0x2C                // Controls devices data rates and power mode
 #define ADXL343_REG_POWER_CTL 0x2D              // Controls power and sleep states
+#define ADXL343_REG_INT_ENABLE 0x2E             // Interrupt enable control
+#define ADXL343_REG_INT_MAP 0x2F                // Interrupt mapping control
+#define ADXL343_REG_INT_SOURCE 0x30             // Source of interrupts (read only)
 #define ADXL343_REG_DATA_FORMAT 0x31            // Controls various device configurations
 #define ADXL343_DATA_X_0 0x32                   // LSB of X axis
 #define ADXL343_DATA_X_1 0x33                   // MSB of X axis
@@ -40,16 +66,102 @@
 #define ADXL343_DATA_Y_1 0x35                   // MSB of Y axis
 #define ADXL343_DATA_Z_0 0x36                   // LSB of Z axis
 #define ADXL343_DATA_Z_1 0x37                   // MSB of Z axis
+#define ADXL343_REG_FIFO_CTL 0x38               // Controls FIFO mode, trigger and sample count
+#define ADXL343_REG_FIFO_STATUS 0x39            // FIFO trigger flag and number of stored entries
+#define ADXL343_REG_MAP_SIZE 0x3A               // Registers 0x00 - 0x39
 #define ADXL343_ADDRESS_I2C 0x53                
 #define ADXL343_ADDRESS_I2CWRITE 0xA6
 #define ADXL343_ADDRESS_I2CREAD 0xA7
+#define ADXL343_ADDRESS_I2C_ALT 0x1D            // ALT ADDRESS pin high
+#define ADXL343_ADDRESS_I2C_ALT_WRITE 0x3A
+#define ADXL343_ADDRESS_I2C_ALT_READ 0x3B
+#define ADXL343_ADDRESS_I2C_MAX 0x7F            // Addresses are 7 bit
 // - Predefined values
 #define ADXL343_DEFAULT_POWERCTRL 0x00          // link, auto sleep, sleep, measurement - low
 #define ADXL343_DEFAULT_RATE 0x0A               // 100 Hz
 #define ADXL343_DEFAULT_RANGE 0x00              // +-2g range
 #define ADXL343_DEFAULT_RESOLUTION 0x00         // 10-bit (auto adjusting scale factor)
 #define ADXL343_DEFAULT_BITORDER 0x00           // Right-Justified - (LSB mode)
+#define ADXL343_DEFAULT_FIFOMODE 0x00           // Bypass - FIFO not used
 #define ADXL343_DEFAULT_TIMEOUT 200             // time in ms, should rather scale with F_CPU
+#define ADXL343_MAX_BURST 14                    // Longest run of writable registers (0x1D - 0x2A)
+#define ADXL343_BURST_BRIDGE 2                  // Unchanged registers re-written to join two bursts
+// - Offset calibration
+#define ADXL343_OFFSET_UNIT_MG_Q6 1000          // Offset register scale, 15.625 mg/LSB (1000 / 64)
+#define ADXL343_CALIBRATION_MARGIN 4            // Sample periods calibration waits beyond the samples still wanted
+#define ADXL343_CALIBRATION_MIN_POLL_NS 3200    // Shortest FIFO_STATUS read (2 SPI bytes at 5 MHz), without a clock
+// - SPI (4-wire, mode 3)
+#define ADXL343_SPI_READ 0x80                   // R/W bit of the command byte, set for reads
+#define ADXL343_SPI_MULTI_BYTE 0x40             // MB bit of the command byte, the register address auto increments
+#define ADXL343_SPI_MAX_CLOCK 5000000           // Maximum SCLK frequency, in Hz
+// - FIFO
+#define ADXL343_FIFO_MODE_BYPASS 0x00           // FIFO bypassed, only the latest sample is held
+#define ADXL343_FIFO_MODE_FIFO 0x01             // Collects up to 32 samples then stops
+#define ADXL343_FIFO_MODE_STREAM 0x02           // Holds the latest 32 samples, oldest overwritten
+#define ADXL343_FIFO_MODE_TRIGGER 0x03          // Holds samples before a trigger event, then fills up
+#define ADXL343_FIFO_SIZE 32                    // Number of entries in the on-chip FIFO
+#define ADXL343_ASYNC_TRANSACTIONS (ADXL343_FIFO_SIZE + 2)  // Status read plus FIFO and data register entries
+#define ADXL343_FIFO_ENTRIES_MASK 0x3F          // Entries field of FIFO_STATUS
+#define ADXL343_FIFO_SAMPLES_MASK 0x1F          // Samples field of FIFO_CTL
+#define ADXL343_FIFO_TRIGGER_INT1 0x00          // Trigger event routed from INT1
+#define ADXL343_FIFO_TRIGGER_INT2 0x01          // Trigger event routed from INT2
+// - Interrupts (bits of INT_ENABLE, INT_MAP and INT_SOURCE)
+#define ADXL343_INT_DATA_READY 0x80             // New data available
+#define ADXL343_INT_SINGLE_TAP 0x40             // Single tap event
+#define ADXL343_INT_DOUBLE_TAP 0x20             // Double tap event
+#define ADXL343_INT_ACTIVITY 0x10               // Activity event
+#define ADXL343_INT_INACTIVITY 0x08             // Inactivity event
+#define ADXL343_INT_FREE_FALL 0x04              // Free-fall event
+#define ADXL343_INT_WATERMARK 0x02              // FIFO entries reached the samples field of FIFO_CTL
+#define ADXL343_INT_OVERRUN 0x01                // Samples were overwritten before being read
+#define ADXL343_INT_COUNT 8                     // Number of interrupt sources
+#define ADXL343_INT_MAP_INT1 0x00               // INT_MAP bit value routing a source to INT1
+#define ADXL343_INT_MAP_INT2 0xFF               // INT_MAP bit value routing a source to INT2
+// - Event detection
+#define ADXL343_AXIS_X 0x04                     // X axis bit of the TAP_AXES, ACT_INACT_CTL and ACT_TAP_STATUS fields
+#define ADXL343_AXIS_Y 0x02                     // Y axis bit
+#define ADXL343_AXIS_Z 0x01                     // Z axis bit
+#define ADXL343_AXIS_ALL 0x07                   // All three axes
+#define ADXL343_THRESH_UNIT_UG 62500            // THRESH_TAP, THRESH_ACT, THRESH_INACT and THRESH_FF, 62.5 mg/LSB
+#define ADXL343_DUR_UNIT_US 625                 // DUR, 625 us/LSB
+#define ADXL343_LATENT_UNIT_US 1250             // LATENT and WINDOW, 1.25 ms/LSB
+#define ADXL343_TIME_FF_UNIT_US 5000            // TIME_FF, 5 ms/LSB
+#define ADXL343_TAP_SUPPRESS 0x08               // TAP_AXES bit, suppresses double taps
+#define ADXL343_ACT_AC_COUPLED 0x08             // ACT_INACT_CTL nibble bit, ac-coupled comparison
+#define ADXL343_EVENT_STATUS_SOURCES (ADXL343_INT_SINGLE_TAP | ADXL343_INT_DOUBLE_TAP | ADXL343_INT_ACTIVITY | \
+                                      ADXL343_INT_INACTIVITY)  // Sources described by ACT_TAP_STATUS
+// - Power modes (BW_RATE and POWER_CTL bits)
+#define ADXL343_LOW_POWER 0x10                  // BW_RATE bit, reduced power at 12.5 - 400 Hz with somewhat more noise
+#define ADXL343_POWER_LINK 0x20                 // POWER_CTL bit, activity and inactivity detection alternate
+#define ADXL343_POWER_AUTO_SLEEP 0x10           // POWER_CTL bit, sleeps on inactivity and wakes on activity (needs link)
+#define ADXL343_POWER_SLEEP 0x04                // POWER_CTL bit, sleep mode
+#define ADXL343_WAKEUP_8HZ 0x00                 // POWER_CTL wakeup field, sample rate while asleep
+#define ADXL343_WAKEUP_4HZ 0x01
+#define ADXL343_WAKEUP_2HZ 0x02
+#define ADXL343_WAKEUP_1HZ 0x03
+#define ADXL343_RATE_100HZ 0x0A                 // BW_RATE rate code, 100 Hz (reset default)
+#define ADXL343_RATE_800HZ 0x0D                 // BW_RATE rate code, 800 Hz
+#define ADXL343_RATE_12_5HZ 0x07                // BW_RATE rate code, 12.5 Hz (lowest low power rate)
+// - Trigger capture (adxl343_arm_capture)
+#define ADXL343_CAPTURE_IDLE 0x00               // Not armed
+#define ADXL343_CAPTURE_ARMED 0x01              // FIFO in trigger mode, waiting for the trigger event
+#define ADXL343_CAPTURE_TRIGGERED 0x02          // Trigger seen by adxl343_on_interrupt, post-trigger samples filling
+#define ADXL343_CAPTURE_DONE 0x03               // Window drained, samples valid
+#define ADXL343_CAPTURE_WINDOW (ADXL343_FIFO_SIZE + 1)  // FIFO entries plus the data registers
+#define ADXL343_CAPTURE_SOURCES (ADXL343_INT_SINGLE_TAP | ADXL343_INT_DOUBLE_TAP | ADXL343_INT_ACTIVITY | \
+                                 ADXL343_INT_INACTIVITY | ADXL343_INT_FREE_FALL)  // Events that can trigger
+// - Step machine (adxl343_step)
+#define ADXL343_STEP_IDLE 0x00                  // Not started
+#define ADXL343_STEP_DRAIN_STATUS 0x01          // Reading FIFO_STATUS
+#define ADXL343_STEP_DRAIN_ENTRY 0x02           // Reading one FIFO entry per step
+#define ADXL343_STEP_CONFIG 0x03                // Writing one configuration burst per step
+#define ADXL343_STEP_DONE 0x04                  // Finished, status holds the result
+#define ADXL343_STEP_MAX_BURSTS 20              // One burst per configuration register at most
+// - Statistics, only collected when built with ADXL343_ENABLE_STATS defined. The flag adds the statistics fields to
+//   ADXL343Device, ADXL343AsyncOp and ADXL343Machine (no overhead without it), so the driver and every file using these
+//   structures must be built with the same setting, mixing them changes their size and layout
+#define ADXL343_STATS_STATUSES (FUNCTION_STATUS_BUSY + 1)  // One counter per FunctionStatus value
+#define ADXL343_STATS_BUCKETS 32                // Log2 latency buckets, bucket n holds [2^(n-1), 2^n) ticks
 
 
 // Data structures
@@ -60,8 +172,262 @@ typedef struct {
     uint8_t range;
     uint8_t resolution;
     uint8_t bit_order;
+    uint8_t fifo_mode;
+    uint8_t fifo_samples;
+    int8_t offset[3];                           // OFSX, OFSY and OFSZ, 15.6 mg/LSB added to every sample
+    uint8_t low_power;
+    uint8_t link;
+    uint8_t auto_sleep;
+    uint8_t wakeup;                             // ADXL343_WAKEUP_*
 } ADXL343Settings;
 
+// - Configuration structure, one field per writable register
+typedef struct {
+    uint8_t thresh_tap;
+    uint8_t ofsx;
+    uint8_t ofsy;
+    uint8_t ofsz;
+    uint8_t dur;
+    uint8_t latent;
+    uint8_t window;
+    uint8_t thresh_act;
+    uint8_t thresh_inact;
+    uint8_t time_inact;
+    uint8_t act_inact_ctl;
+    uint8_t thresh_ff;
+    uint8_t time_ff;
+    uint8_t tap_axes;
+    uint8_t bw_rate;
+    uint8_t power_ctl;
+    uint8_t int_enable;
+    uint8_t int_map;
+    uint8_t data_format;
+    uint8_t fifo_ctl;
+} ADXL343Config;
+
+// - Decode descriptor, derived once from range, resolution and bit order
+typedef struct {
+    uint8_t width;                              // Sample resolution in bits (10 - 13)
+    uint8_t left_shift;                         // Moves the sample's sign bit to bit 15
+    uint8_t right_shift;                        // Arithmetic shift back to right-justified, sign extending
+    uint16_t mask;                              // Resolution mask of the right-justified sample
+    uint16_t scale_mg_q8;                       // Scale factor in milli-g per LSB, Q8 fixed point
+} ADXL343Decoder;
+
+// - Decoded sample structure (right-justified, sign extended)
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} ADXL343Sample;
+
+// - Tap detection (THRESH_TAP, DUR, LATENT, WINDOW, TAP_AXES), rounded to the register resolution
+typedef struct {
+    uint16_t threshold_mg;                      // Peak acceleration of a tap, 62.5 mg/LSB
+    uint32_t duration_us;                       // Longest time above threshold for a tap, 625 us/LSB
+    uint32_t latency_us;                        // Wait before the double tap window, 1.25 ms/LSB, 0 disables double taps
+    uint32_t window_us;                         // Double tap window after the latency, 1.25 ms/LSB
+    uint8_t axes;                               // ADXL343_AXIS_* taking part
+    uint8_t suppress;                           // Acceleration above threshold during the latency cancels a double tap
+} ADXL343TapConfig;
+
+// - Activity detection (THRESH_ACT, upper half of ACT_INACT_CTL)
+typedef struct {
+    uint16_t threshold_mg;                      // 62.5 mg/LSB
+    uint8_t axes;                               // ADXL343_AXIS_* taking part, any axis above threshold is activity
+    uint8_t ac_coupled;                         // Compared to the acceleration when detection started instead of 0 g
+} ADXL343ActivityConfig;
+
+// - Inactivity detection (THRESH_INACT, TIME_INACT, lower half of ACT_INACT_CTL)
+typedef struct {
+    uint16_t threshold_mg;                      // 62.5 mg/LSB
+    uint8_t time_s;                             // All axes below threshold for this long, 1 s/LSB
+    uint8_t axes;                               // ADXL343_AXIS_* taking part
+    uint8_t ac_coupled;                         // Compared to the acceleration when detection started instead of 0 g
+} ADXL343InactivityConfig;
+
+// - Free-fall detection (THRESH_FF, TIME_FF)
+typedef struct {
+    uint16_t threshold_mg;                      // All axes below, 62.5 mg/LSB (300 - 600 mg recommended)
+    uint16_t time_ms;                           // For at least this long, 5 ms/LSB (100 - 350 ms recommended)
+} ADXL343FreeFallConfig;
+
+// - Power configuration (LOW_POWER of BW_RATE, link, auto sleep and wakeup of POWER_CTL)
+typedef struct {
+    uint8_t low_power;                          // Low power sampling, 12.5 - 400 Hz
+    uint8_t link;                               // Activity is only detected after inactivity and the other way round
+    uint8_t auto_sleep;                         // Sleep on inactivity, wake on activity, requires link
+    uint8_t wakeup;                             // ADXL343_WAKEUP_* sample rate while asleep
+} ADXL343PowerConfig;
+
+// - Wake-on-motion profile, the driver switches rate and watermark on the activity and inactivity interrupts
+typedef struct {
+    ADXL343ActivityConfig activity;             // Motion that wakes the device
+    ADXL343InactivityConfig inactivity;         // Stillness that puts it back to sleep
+    uint8_t wakeup;                             // ADXL343_WAKEUP_* sample rate while asleep
+    uint8_t active_rate;                        // BW_RATE rate code after activity
+    uint8_t active_watermark;                   // FIFO_CTL samples field after activity
+    uint8_t idle_rate;                          // BW_RATE rate code after inactivity
+    uint8_t idle_low_power;                     // Low power sampling after inactivity
+    uint8_t idle_watermark;                     // FIFO_CTL samples field after inactivity
+} ADXL343WakeProfile;
+
+// - Decoded ACT_TAP_STATUS
+typedef struct {
+    uint8_t activity_axes;                      // ADXL343_AXIS_* first involved in the last activity event
+    uint8_t tap_axes;                           // ADXL343_AXIS_* first involved in the last tap event
+    uint8_t asleep;                             // The device is in sleep mode
+} ADXL343EventStatus;
+
+// - Bus binding, the I2C primitives of the bus a device is connected to
+typedef struct {
+    FunctionStatus (*write)(const char* dataToWrite, size_t length, uint32_t timeout);
+    FunctionStatus (*read)(char* dataToRead, size_t length, uint32_t timeout);
+    FunctionStatus (*write_read)(const char* dataToWrite, size_t writeLength, char* dataToRead, size_t readLength,
+                                 uint32_t timeout);
+    FunctionStatus (*submit)(I2CTransaction* transaction);  // Transaction queue, NULL if the bus has none
+} ADXL343Bus;
+
+// - SPI binding, the SPI primitive of the bus a device is connected to (chip select handled by the transfer)
+typedef struct {
+    FunctionStatus (*transfer)(const char* dataToWrite, char* dataToRead, size_t length, uint32_t timeout);
+} ADXL343SpiBus;
+
+// - Bus statistics of one transaction direction, latencies in ticks of the timestamp source
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;                             // Register data bytes, excluding the address and register bytes
+    uint32_t status[ADXL343_STATS_STATUSES];    // Transactions by their FunctionStatus
+    uint32_t latency[ADXL343_STATS_BUCKETS];    // Bucket 0 holds zero-tick transactions, the last one everything above
+    uint64_t latency_max;
+} ADXL343OpStats;
+
+// - Bus statistics of a device, by register reads and register writes
+typedef struct {
+    ADXL343OpStats read;
+    ADXL343OpStats write;
+} ADXL343Stats;
+
+// - Timestamp source for the latency histograms and timestamps, any monotonic tick counter
+typedef uint64_t (*ADXL343TimestampSource)(void);
+
+// - Sample ring, see adxl343_ring.h
+struct ADXL343Ring;
+
+// - Sample timeline, see adxl343_timeline.h
+struct ADXL343Timeline;
+
+// - Interrupt callback, called from adxl343_on_interrupt with the source bit that triggered it
+struct ADXL343Device;
+typedef void (*ADXL343InterruptCallback)(struct ADXL343Device* device, uint8_t source, void* context);
+
+// - Trigger capture, see below
+struct ADXL343Capture;
+
+// - Register transport, frames register reads and burst writes for the bus the device is connected to
+typedef struct {
+    FunctionStatus (*read)(const struct ADXL343Device* device, uint8_t register_address, size_t num_bytes,
+                           char* return_data);
+    FunctionStatus (*write)(const struct ADXL343Device* device, uint8_t register_address, const uint8_t* data,
+                            size_t num_bytes);
+} ADXL343Transport;
+
+// - Device handle
+typedef struct ADXL343Device {
+    const ADXL343Transport* transport;          // adxl343_i2c_transport or adxl343_spi_transport
+    const ADXL343Bus* bus;                      // I2C bus the device is reached through, NULL on SPI
+    const ADXL343SpiBus* spi;                   // SPI bus the device is reached through, NULL on I2C
+    uint8_t address;                            // 7 bit I2C address
+    ADXL343Settings settings;
+    ADXL343Decoder decoder;                     // Derived from range, resolution and bit order
+    uint8_t shadow[ADXL343_REG_MAP_SIZE];       // Write-through copy of the device register map
+    uint8_t shadow_valid;
+    ADXL343InterruptCallback interrupt_callbacks[ADXL343_INT_COUNT];  // Indexed by source bit position
+    void* interrupt_contexts[ADXL343_INT_COUNT];
+    ADXL343EventStatus event_status;            // Read with INT_SOURCE by adxl343_on_interrupt for event callbacks
+    ADXL343WakeProfile wake_profile;            // Applied by adxl343_on_interrupt while wake_enabled is set
+    uint8_t wake_enabled;
+    struct ADXL343Capture* capture;             // Armed capture, its trigger is seen by adxl343_on_interrupt
+#ifdef ADXL343_ENABLE_STATS
+    ADXL343Stats stats;
+#endif
+} ADXL343Device;
+
+// - Asynchronous operation, completion callback called from i2c_poll with the samples drained or bursts written
+typedef void (*ADXL343AsyncCallback)(ADXL343Device* device, FunctionStatus status, size_t count, void* context);
+
+// - Asynchronous operation state, owned by the caller until the callback has been called
+typedef struct ADXL343AsyncOp {
+    ADXL343Device* device;
+    ADXL343AsyncCallback callback;
+    void* context;
+    ADXL343Sample* samples;                     // Drain destination
+    size_t max;
+    size_t available;                           // Drain: entries FIFO_STATUS reported
+    size_t scheduled;                           // Drain: entry reads queued, fewer than available when capped
+    I2CTransaction transactions[ADXL343_ASYNC_TRANSACTIONS];
+    uint8_t frames[ADXL343_ASYNC_TRANSACTIONS][2 + ADXL343_MAX_BURST];  // Write phase of each transaction
+    uint8_t data[ADXL343_ASYNC_TRANSACTIONS][6];                        // Read phase of each transaction
+#ifdef ADXL343_ENABLE_STATS
+    uint64_t submitted_at[ADXL343_ASYNC_TRANSACTIONS];                  // Timestamp of each submit
+#endif
+    size_t submitted;
+    size_t completed;
+    FunctionStatus status;                      // FUNCTION_STATUS_PENDING while the operation runs
+} ADXL343AsyncOp;
+
+// - Resumable operation, advanced by adxl343_step with one transaction in flight at a time
+typedef struct {
+    ADXL343Device* device;
+    uint8_t state;                              // ADXL343_STEP_*
+    FunctionStatus status;                      // FUNCTION_STATUS_PENDING while the operation runs
+    I2CTransaction transaction;                 // The transaction in flight
+    uint8_t frame[2 + ADXL343_MAX_BURST];       // Its write phase
+    uint8_t data[6];                            // Its read phase
+    uint8_t in_flight;
+    volatile uint8_t completed;                 // Set by the completion callback, from i2c_poll
+    ADXL343Sample* samples;                     // Drain destination
+    size_t max;
+    size_t entries;                             // Entries to drain, from FIFO_STATUS
+    size_t count;                               // Samples drained so far
+    uint8_t target[ADXL343_REG_MAP_SIZE];       // Register image being written
+    uint8_t bursts[ADXL343_STEP_MAX_BURSTS][2]; // First register and length of each burst
+    size_t num_bursts;
+    size_t burst;                               // Bursts written so far
+#ifdef ADXL343_ENABLE_STATS
+    uint64_t submitted_at;
+#endif
+} ADXL343Machine;
+
+
+// - Trigger capture settings
+typedef struct {
+    uint8_t pre_samples;                        // Samples kept from before the trigger, 1 - 31 (FIFO_CTL samples field)
+    uint8_t sources;                            // ADXL343_INT_* events that trigger, e.g. activity or single tap
+    uint8_t pin;                                // ADXL343_FIFO_TRIGGER_INT1/INT2, the sources are routed to it
+} ADXL343CaptureConfig;
+
+// - Trigger capture, one pre- and post-trigger window, owned by the caller while armed
+typedef struct ADXL343Capture {
+    uint8_t state;                              // ADXL343_CAPTURE_*
+    ADXL343CaptureConfig config;
+    uint8_t source;                             // Event(s) that triggered the capture
+    uint64_t trigger_time;                      // Timestamp source ticks when adxl343_on_interrupt saw the trigger
+    uint64_t period_ns;                         // Sample period at the output data rate when armed
+    size_t count;                               // Samples in the window
+    size_t pre_trigger;                         // Samples from before the trigger, samples[pre_trigger] is the first after
+    ADXL343Sample samples[ADXL343_CAPTURE_WINDOW];
+} ADXL343Capture;
+
+// Variables
+// - Bus binding to the i2c_driver functions, used when no bus is given to adxl343_init
+extern const ADXL343Bus adxl343_i2c_bus;
+// - Bus binding to the spi_driver function, used when no bus is given to adxl343_init_spi
+extern const ADXL343SpiBus adxl343_spi_bus;
+// - Register transports, selected by adxl343_init (I2C) and adxl343_init_spi (SPI)
+extern const ADXL343Transport adxl343_i2c_transport;
+extern const ADXL343Transport adxl343_spi_transport;
+
 
 // Functions
 
@@ -72,13 +438,35 @@ typedef struct {
  * It sets up the accelerometer for subsequent operations. Upon successful initialization, the accelerometer is
  * configured to default in standby mode.
  *
+ * @param device  A pointer to the device handle to initialize.
+ * @param bus     A pointer to the bus the device is connected to, NULL for the i2c_driver bus (adxl343_i2c_bus).
+ * @param address The 7 bit I2C address of the device, ADXL343_ADDRESS_I2C or ADXL343_ADDRESS_I2C_ALT.
+ *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
  *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
  *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_init();
+FunctionStatus adxl343_init(ADXL343Device* device, const ADXL343Bus* bus, uint8_t address);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes an ADXL343 accelerometer connected over 4-wire SPI.
+ *
+ * Same as adxl343_init, with the device reached over SPI. Register reads of more than one byte set the MB bit so a
+ * whole FIFO entry or configuration block moves in one chip select cycle. Every function of the driver can be used
+ * on the device except the asynchronous ones, which need the I2C transaction queue.
+ *
+ * @param device A pointer to the device handle to initialize.
+ * @param spi    A pointer to the SPI bus the device is connected to, NULL for the spi_driver bus (adxl343_spi_bus).
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_init_spi(ADXL343Device* device, const ADXL343SpiBus* spi);
 
 
 /** -------------------------------------------------------------------------------------------------------------------
@@ -87,13 +475,15 @@ FunctionStatus adxl343_init();
  * This function starts the ADXL343 accelerometer, enabling it to begin measuring acceleration data along its
  * three axes. Once started, the accelerometer will continuously measure acceleration until stopped.
  *
+ * @param device A pointer to the device handle.
+ *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
  *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
  *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_start();
+FunctionStatus adxl343_start(ADXL343Device* device);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Stops the ADXL343 accelerometer.
@@ -101,19 +491,22 @@ FunctionStatus adxl343_start();
  * This function stops the ADXL343 accelerometer, halting the measurement of acceleration data along its three axes.
  * Once stopped, the accelerometer ceases to measure acceleration until started again.
  *
+ * @param device A pointer to the device handle.
+ *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
  *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
  *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_stop();
+FunctionStatus adxl343_stop(ADXL343Device* device);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Sets the data rate of the ADXL343 accelerometer.
  *
  * This function sets the data rate of the ADXL343 accelerometer to the specified value.
  *
+ * @param device A pointer to the device handle.
  * @param rate  The desired data rate value to set for the accelerometer.
  *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
@@ -122,7 +515,24 @@ FunctionStatus adxl343_stop();
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_set_rate(uint8_t);
+FunctionStatus adxl343_set_rate(ADXL343Device* device, uint8_t rate);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Enables or disables low power sampling (LOW_POWER bit of BW_RATE) of the ADXL343 accelerometer.
+ *
+ * Low power sampling saves current at output data rates of 12.5 Hz to 400 Hz, at the cost of somewhat higher noise.
+ * adxl343_set_rate leaves the bit as it is.
+ *
+ * @param device A pointer to the device handle.
+ * @param enable 0x01 to sample in low power mode, 0x00 for normal operation.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_low_power(ADXL343Device* device, uint8_t enable);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Sets the measurement range of the ADXL343 accelerometer.
@@ -130,6 +540,7 @@ FunctionStatus adxl343_set_rate(uint8_t);
  * This function sets the measurement range of the ADXL343 accelerometer to the specified value. The measurement
  * range determines the maximum acceleration that the accelerometer can measure along each axis.
  *
+ * @param device A pointer to the device handle.
  * @param range The desired measurement range value to set for the accelerometer.
  *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
@@ -138,7 +549,7 @@ FunctionStatus adxl343_set_rate(uint8_t);
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_set_range(uint8_t);
+FunctionStatus adxl343_set_range(ADXL343Device* device, uint8_t range);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Sets the resolution of the ADXL343 accelerometer to fixed resolution mode.
@@ -146,13 +557,15 @@ FunctionStatus adxl343_set_range(uint8_t);
  * This function sets the resolution of the ADXL343 accelerometer to fixed resolution mode. In this mode, the
  * accelerometer uses a fixed 10bit resolution for data output.
  *
+ * @param device A pointer to the device handle.
+ *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
  *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
  *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_set_resolution_fixed();
+FunctionStatus adxl343_set_resolution_fixed(ADXL343Device* device);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Sets the resolution of the ADXL343 accelerometer to full resolution mode.
@@ -160,13 +573,15 @@ FunctionStatus adxl343_set_resolution_fixed();
  * This function sets the resolution of the ADXL343 accelerometer to full resolution mode. In this mode, the
  * accelerometer provides full resolution for data output. Thes resolution varies depending on the configured range.
  *
+ * @param device A pointer to the device handle.
+ *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
  *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
  *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_set_resolution_full();
+FunctionStatus adxl343_set_resolution_full(ADXL343Device* device);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Sets the bit order of the ADXL343 accelerometer.
@@ -175,6 +590,7 @@ FunctionStatus adxl343_set_resolution_full();
  * the order in which the accelerometer outputs bits of data. 0 is right-justified (LSB) and 1 is left-justified (MSB).
  * Note the sign extension when right-justified
  *
+ * @param device A pointer to the device handle.
  * @param bit_order The desired bit order value to set for the accelerometer.
  *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
@@ -183,7 +599,7 @@ FunctionStatus adxl343_set_resolution_full();
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_set_bit_order(uint8_t bit_order);
+FunctionStatus adxl343_set_bit_order(ADXL343Device* device, uint8_t bit_order);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Gets the acceleration data along the X-axis from the ADXL343 accelerometer.
@@ -191,6 +607,7 @@ FunctionStatus adxl343_set_bit_order(uint8_t bit_order);
  * This function retrieves the acceleration data along the X-axis from the ADXL343 accelerometer and stores it
  * in the provided buffer.
  *
+ * @param device A pointer to the device handle.
  * @param data A pointer to a buffer where the X-axis acceleration data will be stored.
  *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
@@ -199,7 +616,7 @@ FunctionStatus adxl343_set_bit_order(uint8_t bit_order);
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_get_X_axis(char * data);
+FunctionStatus adxl343_get_X_axis(ADXL343Device* device, char * data);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Gets the acceleration data along the Y-axis from the ADXL343 accelerometer.
@@ -207,6 +624,7 @@ FunctionStatus adxl343_get_X_axis(char * data);
  * This function retrieves the acceleration data along the Y-axis from the ADXL343 accelerometer and stores it
  * in the provided buffer.
  *
+ * @param device A pointer to the device handle.
  * @param data A pointer to a buffer where the Y-axis acceleration data will be stored.
  *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
@@ -215,7 +633,7 @@ FunctionStatus adxl343_get_X_axis(char * data);
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_get_Y_axis(char * data);
+FunctionStatus adxl343_get_Y_axis(ADXL343Device* device, char * data);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Gets the acceleration data along the Z-axis from the ADXL343 accelerometer.
@@ -223,6 +641,7 @@ FunctionStatus adxl343_get_Y_axis(char * data);
  * This function retrieves the acceleration data along the Z-axis from the ADXL343 accelerometer and stores it
  * in the provided buffer.
  *
+ * @param device A pointer to the device handle.
  * @param data A pointer to a buffer where the Z-axis acceleration data will be stored.
  *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
@@ -231,7 +650,7 @@ FunctionStatus adxl343_get_Y_axis(char * data);
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_get_Z_axis(char *data);
+FunctionStatus adxl343_get_Z_axis(ADXL343Device* device, char *data);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Gets the acceleration data along all axes from the ADXL343 accelerometer.
@@ -239,6 +658,7 @@ FunctionStatus adxl343_get_Z_axis(char *data);
  * This function retrieves the acceleration data along all axes (X, Y, Z) from the ADXL343 accelerometer and
  * stores it in the provided buffer.
  *
+ * @param device A pointer to the device handle.
  * @param data A pointer to a buffer where the acceleration data along all axes will be stored.
  *
  * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
@@ -247,7 +667,435 @@ FunctionStatus adxl343_get_Z_axis(char *data);
  *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
  * --------------------------------------------------------------------------------------------------------------------
  */
-FunctionStatus adxl343_get_all_axes(char *data);
+FunctionStatus adxl343_get_all_axes(ADXL343Device* device, char *data);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Reads one decoded sample from the ADXL343 accelerometer.
+ *
+ * Typed replacement for adxl343_get_all_axes: DATAX0..DATAZ1 are read in one burst straight into the caller's
+ * sample and decoded in place into right-justified, sign extended values, no bytes need to be reassembled.
+ *
+ * @param device A pointer to the device handle.
+ * @param sample A pointer to where the sample will be stored.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_read_sample(ADXL343Device* device, ADXL343Sample* sample);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the acceleration data along all axes from several ADXL343 accelerometers.
+ *
+ * This function reads all axes of every device back to back in one pass over the bus(es), and only then decodes
+ * the samples, to keep the skew between the sensors' readings as small as possible.
+ *
+ * @param devices     An array of pointers to the device handles to read.
+ * @param num_devices The number of devices in the array.
+ * @param samples     A pointer to a buffer of num_devices samples where the decoded samples will be stored, in the 
+ *                    order of the devices array.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_read_multi(ADXL343Device* const* devices, size_t num_devices, ADXL343Sample* samples);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Sets the FIFO mode of the ADXL343 accelerometer.
+ *
+ * This function configures the on-chip 32 entry FIFO (FIFO_CTL). In bypass mode the FIFO is not used. In FIFO mode
+ * samples are collected until the FIFO is full. In stream mode the latest 32 samples are kept. In trigger mode the
+ * latest samples are kept until a trigger event occurs on the selected interrupt pin, after which the FIFO fills up.
+ * The samples value sets the watermark level (FIFO/stream) or the number of samples kept before the trigger.
+ *
+ * @param device A pointer to the device handle.
+ * @param mode     The FIFO mode, one of ADXL343_FIFO_MODE_BYPASS/FIFO/STREAM/TRIGGER.
+ * @param samples  The samples field of FIFO_CTL (0 - 31).
+ * @param trigger  The interrupt pin the trigger event is linked to, ADXL343_FIFO_TRIGGER_INT1 or INT2.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if any of the arguments are out of range.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_fifo_mode(ADXL343Device* device, uint8_t mode, uint8_t samples, uint8_t trigger);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the number of entries currently stored in the FIFO of the ADXL343 accelerometer.
+ *
+ * @param device A pointer to the device handle.
+ * @param entries A pointer to where the number of stored entries will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_get_fifo_entries(ADXL343Device* device, uint8_t* entries);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Drains the FIFO of the ADXL343 accelerometer into a buffer of decoded samples.
+ *
+ * This function reads FIFO_STATUS once and then pops every available entry (up to max) with a single 6 byte burst
+ * read per entry, which is the least the device allows as each burst of the data registers pops one entry. Samples
+ * are decoded according to the current settings into right-justified, sign extended values, oldest sample first.
+ *
+ * @param device A pointer to the device handle.
+ * @param samples A pointer to a buffer where the decoded samples will be stored.
+ * @param max     The number of samples the buffer can hold.
+ * @param count   A pointer to where the number of samples read will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_read_fifo(ADXL343Device* device, ADXL343Sample* samples, size_t max, size_t* count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Drains the FIFO of the ADXL343 accelerometer into struct-of-arrays buffers.
+ *
+ * Same as adxl343_read_fifo, but sample i is decoded into x[i * stride], y[i * stride] and z[i * stride]. A stride of
+ * 1 fills plain per-axis arrays, a stride of N interleaves N sensors into shared per-axis arrays.
+ *
+ * @param device A pointer to the device handle.
+ * @param x      A pointer to where the first X value will be stored.
+ * @param y      A pointer to where the first Y value will be stored.
+ * @param z      A pointer to where the first Z value will be stored.
+ * @param stride The distance between consecutive samples in each array, in values.
+ * @param max    The number of samples the buffers can hold.
+ * @param count  A pointer to where the number of samples read will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the stride is 0.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_read_fifo_strided(ADXL343Device* device, int16_t* x, int16_t* y, int16_t* z, size_t stride,
+                                        size_t max, size_t* count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Drains the FIFO of the ADXL343 accelerometer into a sample ring.
+ *
+ * This is the producer side of an ADXL343Ring (see adxl343_ring.h), meant to be called from the watermark/overrun
+ * interrupt. Like adxl343_read_fifo it reads FIFO_STATUS once and pops every available entry, but the samples are
+ * decoded straight into the free space of the ring. Entries that do not fit are still popped, so the device FIFO and
+ * its interrupt are cleared, and are counted as dropped by the ring.
+ *
+ * @param device A pointer to the device handle.
+ * @param ring   A pointer to the ring, see adxl343_ring.h.
+ * @param count  A pointer to where the number of samples added to the ring will be written, may be NULL.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if samples were dropped because the ring was full.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_drain_fifo_to_ring(ADXL343Device* device, struct ADXL343Ring* ring, size_t* count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Drains the FIFO of the ADXL343 accelerometer and timestamps every sample.
+ *
+ * Same as adxl343_read_fifo, but the host clock (adxl343_set_timestamp_source, it has to count nanoseconds) is read
+ * right after FIFO_STATUS and the samples are back-dated from it with the entry count and settings.rate, see
+ * adxl343_timeline.h. The timeline keeps the stamps continuous over successive drains and tracks the drift between
+ * the sensor's output data rate and the host clock, it is restarted when the rate has changed. Entries beyond max stay
+ * in the FIFO and are stamped by the next drain.
+ *
+ * @param device     A pointer to the device handle.
+ * @param timeline   A pointer to the timeline of the device, see adxl343_timeline.h.
+ * @param samples    A pointer to a buffer where the decoded samples will be stored.
+ * @param timestamps A pointer to a buffer where the timestamp of every sample will be stored, in ns.
+ * @param max        The number of samples the buffers can hold.
+ * @param count      A pointer to where the number of samples read will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_NOT_INITIALIZED if no timestamp source is set.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_read_fifo_timestamped(ADXL343Device* device, struct ADXL343Timeline* timeline,
+                                            ADXL343Sample* samples, uint64_t* timestamps, size_t max, size_t* count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Drains the FIFO of the ADXL343 accelerometer without blocking.
+ *
+ * This function queues the FIFO_STATUS read on the transaction queue of the bus (see i2c_submit) and returns. Once
+ * it completes (in i2c_poll) one 6 byte read per entry is queued, and once those complete the samples are decoded into
+ * the buffer and the callback is called. Only one operation may use the op structure at a time, and the register
+ * shadow should not be changed by blocking calls while an operation is pending.
+ *
+ * At most max and ADXL343_ASYNC_TRANSACTIONS - 1 entries are drained per operation. Once the status read completed
+ * op->available holds the entries FIFO_STATUS reported and op->scheduled the entry reads that were queued, when it is
+ * smaller the entries left behind stay in the FIFO for the next drain.
+ *
+ * @param device   A pointer to the device handle.
+ * @param op       A pointer to the operation state, must stay valid until the callback has been called.
+ * @param samples  A pointer to a buffer where the decoded samples will be stored.
+ * @param max      The number of samples the buffer can hold.
+ * @param callback The function to call once the drain has finished, may be NULL (poll op->status instead).
+ * @param context  A pointer handed back to the callback as is.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the drain was started.
+ *                         Returns FUNCTION_STATUS_ERROR if the bus has no transaction queue.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BUSY if the transaction queue is full.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_drain_fifo_async(ADXL343Device* device, ADXL343AsyncOp* op, ADXL343Sample* samples, size_t max,
+                                        ADXL343AsyncCallback callback, void* context);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Configures the interrupts of the ADXL343 accelerometer.
+ *
+ * This function enables the given interrupt sources (INT_ENABLE) and routes them to the INT1 or INT2 pin (INT_MAP).
+ * Both registers are written in one burst, and only if they differ from the register shadow.
+ *
+ * @param device A pointer to the device handle.
+ * @param enable The ADXL343_INT_* sources to enable, OR'd together.
+ * @param map    The ADXL343_INT_* sources to route to INT2, all other sources are routed to INT1.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_interrupts(ADXL343Device* device, uint8_t enable, uint8_t map);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Registers a callback for interrupt source(s) of the ADXL343 accelerometer.
+ *
+ * The callback is called from adxl343_on_interrupt whenever one of the given sources is flagged in INT_SOURCE and
+ * enabled. Passing NULL as callback removes it.
+ *
+ * @param device   A pointer to the device handle.
+ * @param sources  The ADXL343_INT_* sources the callback is registered for, OR'd together.
+ * @param callback The function to call.
+ * @param context  A pointer handed back to the callback as is.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the callback was registered.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_interrupt_callback(ADXL343Device* device, uint8_t sources, ADXL343InterruptCallback callback,
+                                              void* context);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Handles an interrupt of the ADXL343 accelerometer.
+ *
+ * To be called when the INT1/INT2 pin of the device is asserted (from the pin interrupt handler or a flag set by it).
+ * INT_SOURCE is read once and the callbacks of the flagged, enabled sources are called in order of their bit position
+ * (overrun, watermark, free-fall, inactivity, activity, double tap, single tap, data ready). Overrun and watermark
+ * therefore reach the application before data ready, so a FIFO drain can be started from the first callback.
+ * If a tap, activity or inactivity callback is registered for an enabled source, ACT_TAP_STATUS is read in the same
+ * transaction (ACT_TAP_STATUS to INT_SOURCE) and decoded into device->event_status before the callbacks run.
+ * With a wake profile set (adxl343_set_wake_profile), activity and inactivity switch the rate and watermark first,
+ * the callbacks are still called if that fails and the error is returned afterwards.
+ *
+ * @param device A pointer to the device handle.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_on_interrupt(ADXL343Device* device);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Configures the tap detection of the ADXL343 accelerometer.
+ *
+ * Writes THRESH_TAP, DUR, LATENT, WINDOW and TAP_AXES. Values are rounded to the register resolution and clamped to its range. Only the registers that change
+ * are written, see adxl343_apply_config. The single tap/double tap interrupt is enabled separately with adxl343_set_interrupts.
+ *
+ * @param device A pointer to the device handle.
+ * @param config The tap detection settings.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_tap_config(ADXL343Device* device, const ADXL343TapConfig* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Configures the activity detection of the ADXL343 accelerometer.
+ *
+ * Writes THRESH_ACT and the activity half of ACT_INACT_CTL. Values are rounded to the register resolution and clamped to its range. Only the registers that change
+ * are written, see adxl343_apply_config. The activity interrupt is enabled separately with adxl343_set_interrupts.
+ *
+ * @param device A pointer to the device handle.
+ * @param config The activity detection settings.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_activity_config(ADXL343Device* device, const ADXL343ActivityConfig* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Configures the inactivity detection of the ADXL343 accelerometer.
+ *
+ * Writes THRESH_INACT, TIME_INACT and the inactivity half of ACT_INACT_CTL. Values are rounded to the register resolution and clamped to its range. Only the registers that change
+ * are written, see adxl343_apply_config. The inactivity interrupt is enabled separately with adxl343_set_interrupts.
+ *
+ * @param device A pointer to the device handle.
+ * @param config The inactivity detection settings.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_inactivity_config(ADXL343Device* device, const ADXL343InactivityConfig* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Configures the free-fall detection of the ADXL343 accelerometer.
+ *
+ * Writes THRESH_FF and TIME_FF. Values are rounded to the register resolution and clamped to its range. Only the registers that change
+ * are written, see adxl343_apply_config. The free-fall interrupt is enabled separately with adxl343_set_interrupts.
+ *
+ * @param device A pointer to the device handle.
+ * @param config The free-fall detection settings.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_free_fall_config(ADXL343Device* device, const ADXL343FreeFallConfig* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Reads and decodes ACT_TAP_STATUS of the ADXL343 accelerometer.
+ *
+ * Gives the axes first involved in the last activity and tap events and whether the device is asleep.
+ * adxl343_on_interrupt already does this for registered event callbacks, see device->event_status.
+ *
+ * @param device A pointer to the device handle.
+ * @param status Where the decoded status will be stored.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_get_event_status(ADXL343Device* device, ADXL343EventStatus* status);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Sets the power configuration of the ADXL343 accelerometer.
+ *
+ * Writes the LOW_POWER bit of BW_RATE and the link, auto sleep and wakeup bits of POWER_CTL, the measurement and
+ * sleep bits are left as they are. With link and auto sleep set the device drops to the wakeup rate on inactivity and
+ * returns to the BW_RATE rate on activity by itself, see adxl343_set_activity_config/adxl343_set_inactivity_config.
+ *
+ * @param device A pointer to the device handle.
+ * @param config The power configuration.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the wakeup rate is out of range, or auto sleep
+ *                         is requested without link.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_power_config(ADXL343Device* device, const ADXL343PowerConfig* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the default wake-on-motion profile.
+ *
+ * Sleeps at 8 Hz after 5 s below 187.5 mg, samples at 12.5 Hz in low power with a watermark of 4 samples while idle
+ * and bursts to 800 Hz with a watermark of 16 samples on 250 mg of motion, all axes ac-coupled.
+ *
+ * @param profile Where the profile will be stored.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_get_default_wake_profile(ADXL343WakeProfile* profile);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Sets a wake-on-motion profile for the ADXL343 accelerometer.
+ *
+ * Configures activity and inactivity detection, link and auto sleep with the profile's wakeup rate, enables the
+ * activity and inactivity interrupts and starts out idle (idle rate and watermark). From then on adxl343_on_interrupt
+ * switches to the active rate and watermark on activity and back to the idle ones on inactivity, before the
+ * callbacks are called, so the host does not have to poll to decide. Route the activity and inactivity interrupts to
+ * a pin with adxl343_set_interrupts. Passing NULL stops the switching, the registers are left as they are.
+ *
+ * @param device  A pointer to the device handle.
+ * @param profile The profile, copied into the device handle.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if a rate, watermark or the wakeup rate is out of range.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_wake_profile(ADXL343Device* device, const ADXL343WakeProfile* profile);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Arms a trigger capture of the ADXL343 accelerometer.
+ *
+ * Enables the trigger sources and routes them to the trigger pin, empties the FIFO and puts it in trigger mode with
+ * pre_samples in the samples field. The device then keeps the latest samples on its own, without bus traffic, until
+ * a trigger event. adxl343_on_interrupt timestamps the trigger (adxl343_set_timestamp_source) and
+ * adxl343_poll_capture drains the window once the FIFO has filled up behind it. Arming again re-arms, passing a
+ * NULL capture disarms (the FIFO is left as it is).
+ *
+ * @param device  A pointer to the device handle.
+ * @param capture The capture to fill, has to stay valid until it is done or disarmed.
+ * @param config  The capture settings.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the capture was armed.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if pre_samples, the sources or the pin are out of range.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_arm_capture(ADXL343Device* device, ADXL343Capture* capture, const ADXL343CaptureConfig* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Completes a trigger capture of the ADXL343 accelerometer.
+ *
+ * Costs nothing before the trigger, afterwards one FIFO_STATUS read per call until the FIFO is full, which takes
+ * (ADXL343_CAPTURE_WINDOW - pre_samples) sample periods. The window is then drained in order: pre_trigger samples
+ * from before the trigger followed by the ones after it, sample i was taken about
+ * (i - pre_trigger) * period_ns after trigger_time.
+ *
+ * @param device  A pointer to the device handle.
+ * @param capture The armed capture.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK once the window has been drained (and on later calls).
+ *                         Returns FUNCTION_STATUS_PENDING while waiting for the trigger or the post-trigger samples.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_NOT_INITIALIZED if the capture was never armed.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_poll_capture(ADXL343Device* device, ADXL343Capture* capture);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Gets the current settings of the ADXL343 accelerometer.
@@ -255,22 +1103,340 @@ FunctionStatus adxl343_get_all_axes(char *data);
  * This function retrieves the current settings of the ADXL343 accelerometer, including measurement mode, data rate,
  * measurement range, resolution, and bit order. The settings are returned in a structure.
  *
+ * @param device A pointer to the device handle.
+ *
  * @return ADXL343Settings  The current settings of the ADXL343 accelerometer.
  * --------------------------------------------------------------------------------------------------------------------
  */
-ADXL343Settings adxl343_get_settings();
+ADXL343Settings adxl343_get_settings(const ADXL343Device* device);
 
 /** -------------------------------------------------------------------------------------------------------------------
  * @brief Gets the current settings of the ADXL343 accelerometer. Directly from the ADXL343 accelerometer
  *
  * This function retrieves the current settings of the ADXL343 accelerometer via the I2C bus, including measurement 
- * mode, data rate, measurement range, resolution, and bit order. The updated settings are returned in the settings
- * structure.
+ * mode, data rate, measurement range, resolution, and bit order. The updated settings are written to the settings
+ * structure. If the registers can not be read the structure is left untouched, the shadow stays untrusted and the
+ * next setter re-syncs it.
  *
- * @return ADXL343Settings  The current settings of the ADXL343 accelerometer.
+ * @param device   A pointer to the device handle.
+ * @param settings A pointer to where the settings will be stored.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the settings were read.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_update_settings(ADXL343Device* device, ADXL343Settings* settings);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Builds the decode descriptor for a range, resolution and bit order combination.
+ *
+ * The descriptor holds everything needed to turn raw DATAx0/DATAx1 bytes into signed samples (shift amounts, mask,
+ * resolution width and scale factor). The driver keeps one for the current settings and rebuilds it whenever the
+ * range, resolution or bit order changes, so nothing is recomputed per sample.
+ *
+ * @param range      The range setting (0 - 3, +-2g to +-16g).
+ * @param resolution The resolution setting (0 fixed 10-bit, 1 full resolution).
+ * @param bit_order  The bit order setting (0 right-justified, 1 left-justified).
+ *
+ * @return ADXL343Decoder  The decode descriptor.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+ADXL343Decoder adxl343_make_decoder(uint8_t range, uint8_t resolution, uint8_t bit_order);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the decode descriptor for the current settings of the ADXL343 accelerometer.
+ *
+ * @param device A pointer to the device handle.
+ *
+ * @return ADXL343Decoder  The decode descriptor.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+ADXL343Decoder adxl343_get_decoder(const ADXL343Device* device);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Decodes raw DATAX0..DATAZ1 bytes into signed samples.
+ *
+ * Branch-free decode of count consecutive 6 byte raw samples (as read from DATAX0..DATAZ1) into right-justified,
+ * sign extended samples.
+ *
+ * @param decoder A pointer to the decode descriptor to use.
+ * @param raw     A pointer to count * 6 raw bytes.
+ * @param samples A pointer to a buffer where the count decoded samples will be stored.
+ * @param count   The number of samples to decode.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_decode(const ADXL343Decoder* decoder, const uint8_t* raw, ADXL343Sample* samples, size_t count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Decodes raw DATAX0..DATAZ1 bytes into struct-of-arrays buffers.
+ *
+ * Same as adxl343_decode, but sample i is stored in x[i * stride], y[i * stride] and z[i * stride].
+ *
+ * @param decoder A pointer to the decode descriptor to use.
+ * @param raw     A pointer to count * 6 raw bytes.
+ * @param count   The number of samples to decode.
+ * @param x       A pointer to where the first X value will be stored.
+ * @param y       A pointer to where the first Y value will be stored.
+ * @param z       A pointer to where the first Z value will be stored.
+ * @param stride  The distance between consecutive samples in each array, in values.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_decode_strided(const ADXL343Decoder* decoder, const uint8_t* raw, size_t count, int16_t* x, int16_t* y,
+                            int16_t* z, size_t stride);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Fills a configuration structure with the driver default configuration.
+ *
+ * The defaults are the ADXL343_DEFAULT_* values (standby, 100 Hz, +-2g, 10-bit, right-justified, FIFO bypassed)
+ * with every other register at its reset value. This is the configuration adxl343_init applies.
+ *
+ * @param config A pointer to the configuration structure to fill.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_get_default_config(ADXL343Config* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Applies a complete configuration to the ADXL343 accelerometer.
+ *
+ * This function compares the requested configuration against the register shadow and only writes the registers
+ * that differ. Changed registers are grouped into multi-byte burst writes over the contiguous writable ranges
+ * (0x1D - 0x2A, 0x2C - 0x2F, 0x31 and 0x38), unchanged registers in small gaps are re-written to join two bursts.
+ * If the shadow is not trusted every register is written. The settings structure is updated on success.
+ *
+ * @param device A pointer to the device handle.
+ * @param config A pointer to the configuration to apply.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_apply_config(ADXL343Device* device, const ADXL343Config* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Applies a configuration to the ADXL343 accelerometer without blocking.
+ *
+ * Same bursts as adxl343_apply_config, but queued on the transaction queue of the bus (see i2c_submit). The register
+ * shadow is updated as the bursts complete (in i2c_poll). If nothing has to be written the callback is called
+ * before this function returns.
+ *
+ * @param device   A pointer to the device handle.
+ * @param op       A pointer to the operation state, must stay valid until the callback has been called.
+ * @param config   A pointer to the configuration to apply, it is copied into the op.
+ * @param callback The function to call once all bursts have completed, may be NULL (poll op->status instead).
+ * @param context  A pointer handed back to the callback as is.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the writes were started.
+ *                         Returns FUNCTION_STATUS_ERROR if the bus has no transaction queue.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BUSY if the transaction queue is full.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_apply_config_async(ADXL343Device* device, ADXL343AsyncOp* op, const ADXL343Config* config,
+                                          ADXL343AsyncCallback callback, void* context);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Starts a resumable FIFO drain of the ADXL343 accelerometer, advanced by adxl343_step.
+ *
+ * Nothing is sent yet. Every adxl343_step call that finds the previous transaction completed queues the next one
+ * (FIFO_STATUS, then one read per entry, up to max), so a drain can be interleaved with other work in a cooperative
+ * loop. Completions reach the machine through i2c_poll, which the loop has to call as well. The machine must not
+ * have a transaction in flight when it is started again.
+ *
+ * @param device  A pointer to the device handle.
+ * @param machine A pointer to the machine state, owned by the caller until the operation has finished.
+ * @param samples A pointer to a buffer of max samples, machine->count holds the number drained.
+ * @param max     The maximum number of samples to read.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the operation was started.
+ *                         Returns FUNCTION_STATUS_ERROR if the bus has no transaction queue.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_begin_drain_fifo(ADXL343Device* device, ADXL343Machine* machine, ADXL343Sample* samples,
+                                        size_t max);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Starts a resumable configuration write to the ADXL343 accelerometer, advanced by adxl343_step.
+ *
+ * The bursts are planned as in adxl343_apply_config and written one per adxl343_step. The register shadow follows
+ * each burst that went through, a failed burst invalidates it.
+ *
+ * @param device  A pointer to the device handle.
+ * @param machine A pointer to the machine state, owned by the caller until the operation has finished.
+ * @param config  A pointer to the configuration, copied before the function returns.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the operation was started.
+ *                         Returns FUNCTION_STATUS_ERROR if the bus has no transaction queue.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_begin_apply_config(ADXL343Device* device, ADXL343Machine* machine,
+                                          const ADXL343Config* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Advances a resumable operation without blocking.
+ *
+ * Handles the transaction completed since the last call, if any, and queues the next one. A full transaction queue
+ * is not an error, the transaction is queued on a later step. Once finished the result is returned on every call.
+ *
+ * @param machine A pointer to the machine state started with adxl343_begin_drain_fifo or adxl343_begin_apply_config.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_PENDING while the operation runs.
+ *                         Returns FUNCTION_STATUS_OK once it has finished.
+ *                         Returns FUNCTION_STATUS_NOT_INITIALIZED if the machine was never started.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers are passed.
+ *                         Returns the status of the failed transaction (e.g. FUNCTION_STATUS_TIMEOUT) otherwise.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_step(ADXL343Machine* machine);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Reads the complete configuration back from the ADXL343 accelerometer.
+ *
+ * This function re-syncs the register shadow with burst reads of the configuration block (see
+ * adxl343_resync_shadow), decodes it into the settings structure and returns the raw configuration.
+ *
+ * @param device A pointer to the device handle.
+ * @param config A pointer to where the configuration will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_snapshot_config(ADXL343Device* device, ADXL343Config* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Marks the local register shadow of the ADXL343 accelerometer as stale.
+ *
+ * The driver keeps a write-through copy of the configuration registers so that setters do not need to read a
+ * register before writing it back. After a failed write the shadow is invalidated automatically, this function
+ * allows it to be done explicitly (e.g. after the device has been reset externally). The next setter will then
+ * re-sync the shadow from the device before using it.
+ *
+ * @param device A pointer to the device handle.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_invalidate_shadow(ADXL343Device* device);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Re-syncs the local register shadow and settings with the values on the ADXL343 accelerometer.
+ *
+ * This function reads the configuration registers back from the device in burst reads and refreshes the register
+ * shadow and the settings structure from them. It is made primarily with error handling in mind.
+ *
+ * @param device A pointer to the device handle.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_resync_shadow(ADXL343Device* device);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Calibrates the offset registers (OFSX, OFSY, OFSZ) of the ADXL343 accelerometer.
+ *
+ * With the device at rest, this function collects num_samples samples through the FIFO (stream mode, measurement
+ * mode, offsets cleared), averages them per axis and writes the offsets that move the average onto the expected
+ * acceleration, rounded to the 15.6 mg/LSB of the offset registers. The configuration the device had before is
+ * restored with the new offsets in the same burst, and the offsets are reflected in the settings. The device adds
+ * them to every sample itself, so no per-sample correction is needed on the host. This function blocks until
+ * num_samples samples have been collected at the configured output data rate.
+ *
+ * It gives up when the samples still wanted are overdue: after the last entry, the FIFO may stay empty for the sample
+ * periods of the remaining samples (plus 1/8 for a slow oscillator and ADXL343_CALIBRATION_MARGIN periods). The wait
+ * is measured on the timestamp source (adxl343_set_timestamp_source) when one is set, otherwise every empty status
+ * read counts as ADXL343_CALIBRATION_MIN_POLL_NS, which can only make the wait longer, never shorter.
+ *
+ * @param device      A pointer to the device handle.
+ * @param expected_mg The acceleration each axis should read at rest, in mg (e.g. {0, 0, 1000} lying flat).
+ * @param num_samples The number of samples to average.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the offsets were calibrated and written.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the samples did not arrive in time at the output data
+ *                         rate, or a transfer did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_calibrate_offsets(ADXL343Device* device, const int32_t expected_mg[3], size_t num_samples);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Writes the offset registers (OFSX, OFSY, OFSZ) of the ADXL343 accelerometer.
+ *
+ * Restores offsets saved from an earlier calibration (e.g. at boot) in one burst write, nothing is written if the
+ * device already holds them.
+ *
+ * @param device  A pointer to the device handle.
+ * @param offsets The X, Y and Z offsets, 15.6 mg/LSB.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transmission was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_set_offsets(ADXL343Device* device, const int8_t offsets[3]);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the offsets of the ADXL343 accelerometer from the settings, without bus traffic.
+ *
+ * @param device  A pointer to the device handle.
+ * @param offsets Where the X, Y and Z offsets (15.6 mg/LSB) will be stored, e.g. to be saved after calibration.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the offsets were copied.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_get_offsets(const ADXL343Device* device, int8_t offsets[3]);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Sets the timestamp source used for the bus latency histograms, capture triggers and sample timestamps.
+ *
+ * With ADXL343_ENABLE_STATS the source is called before and after every bus transaction, its ticks are the unit of
+ * the latency histograms. It also stamps the trigger of a capture (ADXL343Capture trigger_time) and is the host clock
+ * of adxl343_read_fifo_timestamped, which needs it to count nanoseconds. Without a source (NULL, the default) every
+ * transaction is counted with zero latency and triggers are stamped 0.
+ *
+ * @param source The timestamp source, NULL to stop measuring latencies.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_set_timestamp_source(ADXL343TimestampSource source);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the bus statistics of the ADXL343 accelerometer.
+ *
+ * Counts every transaction the driver ran for the device since adxl343_init or the last adxl343_reset_stats,
+ * synchronous ones and those of asynchronous operations (counted on completion), by direction, with the bytes
+ * transferred, the FunctionStatus each one ended with and its latency.
+ *
+ * @param device A pointer to the device handle.
+ * @param stats  A pointer to where the statistics will be copied.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the statistics were copied.
+ *                         Returns FUNCTION_STATUS_ERROR if the driver was built without ADXL343_ENABLE_STATS.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_get_stats(const ADXL343Device* device, ADXL343Stats* stats);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Clears the bus statistics of the ADXL343 accelerometer.
+ *
+ * @param device A pointer to the device handle.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the statistics were cleared.
+ *                         Returns FUNCTION_STATUS_ERROR if the driver was built without ADXL343_ENABLE_STATS.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers are passed.
  * --------------------------------------------------------------------------------------------------------------------
  */
-ADXL343Settings adxl343_update_settings();
+FunctionStatus adxl343_reset_stats(ADXL343Device* device);
 
 /** @} */
 
@@ -0,0 +1,153 @@
+#ifndef INC_ADXL343_FEATURES_H_
+#define INC_ADXL343_FEATURES_H_
+
+/**
+ * @file adxl343_features.h
+ * @brief Accelerometer Vibration Feature Interface
+ *
+ * This module turns the sample stream (e.g. the blocks returned by adxl343_read_fifo) into compact feature records
+ * per window: per axis the RMS, peak, crest factor, kurtosis and the energy in a set of FFT bands. Windows are
+ * tumbling (hop equal to the window) or sliding (smaller hop, overlapping windows), a record is emitted every hop
+ * samples once the first window is full.
+ *
+ * The window statistics are kept up to date per sample: running sums of x, x^2, x^3 and x^4 get the new sample added
+ * and the one leaving the window removed, and monotonic queues hold the window minimum and maximum. Emitting a record
+ * only reads them out and runs a radix-2 fixed point FFT (Q15 twiddles from a precomputed table, int32 data, Hann
+ * window) per axis. The engine is caller provided, typically static, there is no allocation.
+ *
+ * Values are in LSB of the samples (convert with the scale of the range, see adxl343_convert.h), samples are
+ * expected in the 13 bit range of the sensor and are clamped to it.
+ *
+ * @{
+ */
+
+
+// Includes
+// - Compiler includes
+#include <stdint.h>
+#include <stddef.h>
+// - Project includes
+#include "FunctionStatus.h"
+#include "adxl343_driver.h"
+
+
+// Defines
+// - Sizes
+#define ADXL343_FEATURES_MIN_WINDOW 16          // Window length, a power of two
+#define ADXL343_FEATURES_MAX_WINDOW 256         // Also the resolution of the twiddle table
+#define ADXL343_FEATURES_MAX_BANDS 8            // FFT bands per axis
+// - Fixed point
+#define ADXL343_FEATURES_MAX_VALUE 4095         // Samples are clamped to +-this (13 bit), keeps the x^4 sums in int64
+#define ADXL343_FEATURES_FFT_Q 4                // Fractional bits of the FFT input, bands come out in Q8
+
+
+// Data structures
+typedef struct {
+    uint16_t window;                            // Samples per window, a power of two
+    uint16_t hop;                               // Samples between records, window for tumbling windows
+    uint8_t bands;                              // Number of FFT bands, bin k is at k * rate / window
+    uint16_t band_edges [ADXL343_FEATURES_MAX_BANDS + 1];  // Band i covers bins [edge i, edge i + 1)
+} ADXL343FeatureConfig;
+
+typedef struct {
+    uint16_t rms_q4;                            // Standard deviation (RMS without DC), LSB in Q4
+    uint16_t peak_q4;                           // Largest distance from the mean, LSB in Q4, saturated
+    uint16_t crest_q8;                          // Peak / RMS in Q8, saturated, 0 for a constant window
+    uint16_t kurtosis_q8;                       // Fourth standardized moment in Q8, 3.0 for Gaussian noise
+    uint32_t bands_q8 [ADXL343_FEATURES_MAX_BANDS];  // Mean square in the band (A^2 / 2 for a sine), LSB^2 in Q8
+} ADXL343AxisFeatures;
+
+typedef struct {
+    uint32_t sequence;                          // Records emitted before this one
+    uint32_t end_sample;                        // Samples fed up to the end of the window
+    ADXL343AxisFeatures axes [3];
+} ADXL343FeatureRecord;
+
+typedef struct {
+    ADXL343FeatureConfig config;
+    uint8_t log2_window;
+    int16_t hann [ADXL343_FEATURES_MAX_WINDOW];         // Window weights in Q15, filled at init
+    uint8_t reversed [ADXL343_FEATURES_MAX_WINDOW];     // Bit reversed index of every window position
+    uint32_t samples;                           // Samples fed since the last reset
+    uint32_t until_record;                      // Samples until the next record is due
+    uint32_t records;
+    int16_t history [3][ADXL343_FEATURES_MAX_WINDOW];  // Window ring, sample n at n % window
+    int64_t sums [3][4];                        // Sums of x, x^2, x^3 and x^4 over the window, per axis
+    uint32_t max_queue [3][ADXL343_FEATURES_MAX_WINDOW];  // Sample numbers of decreasing values, per axis
+    uint32_t min_queue [3][ADXL343_FEATURES_MAX_WINDOW];  // Sample numbers of increasing values, per axis
+    uint16_t max_head [3];
+    uint16_t max_length [3];
+    uint16_t min_head [3];
+    uint16_t min_length [3];
+    int32_t re [ADXL343_FEATURES_MAX_WINDOW];   // FFT work
+    int32_t im [ADXL343_FEATURES_MAX_WINDOW];
+} ADXL343FeatureEngine;
+
+
+// Functions
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets a configuration with equal width bands.
+ *
+ * Splits bins 1 to window / 2 into bands of equal width.
+ *
+ * @param config A pointer to where the configuration will be written.
+ * @param window The window length.
+ * @param hop    The samples between records.
+ * @param bands  The number of bands.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the configuration was written.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the window, hop or band count is out of range.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_features_default_config(ADXL343FeatureConfig* config, size_t window, size_t hop, size_t bands);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a feature engine.
+ *
+ * @param engine A pointer to the engine.
+ * @param config A pointer to the configuration, copied into the engine.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the engine was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the window is not a power of two from 16 to 256,
+ *                         the hop is not 1 to window, or the band edges are not increasing within bins 1 to
+ *                         window / 2 + 1.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_features_init(ADXL343FeatureEngine* engine, const ADXL343FeatureConfig* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Empties the window, e.g. after a gap in the stream.
+ *
+ * @param engine A pointer to the engine.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_features_reset(ADXL343FeatureEngine* engine);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Feeds a block of samples to the engine.
+ *
+ * Every sample updates the window statistics, a record is written for every hop that completes. When the record
+ * buffer is full the remaining samples are not consumed, feed them again with an empty buffer.
+ *
+ * @param engine   A pointer to the engine.
+ * @param samples  A pointer to the samples, oldest first.
+ * @param count    The number of samples.
+ * @param records  A pointer to where the records will be written.
+ * @param max      The number of records the buffer can hold.
+ * @param consumed A pointer to where the number of samples consumed will be written.
+ * @param emitted  A pointer to where the number of records written will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if all samples were consumed.
+ *                         Returns FUNCTION_STATUS_NOT_INITIALIZED if the engine was not initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BUSY if the record buffer filled up before all samples were consumed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_features_push(ADXL343FeatureEngine* engine, const ADXL343Sample* samples, size_t count,
+                                     ADXL343FeatureRecord* records, size_t max, size_t* consumed, size_t* emitted);
+
+/** @} */
+
+#endif /* INC_ADXL343_FEATURES_H_ */
@@ -0,0 +1,219 @@
+#ifndef INC_ADXL343_FILTER_H_
+#define INC_ADXL343_FILTER_H_
+
+/**
+ * @file adxl343_filter.h
+ * @brief Accelerometer Sample Filter Interface
+ *
+ * This module runs blocks of decoded ADXL343 samples (e.g. a drained FIFO) through a pipeline of fixed point filter
+ * stages: biquad IIR sections, FIR decimators, a DC removal high-pass and a moving RMS. The stages are chained in the
+ * order they are given and keep their state between blocks, so a continuous stream can be fed in blocks of any size.
+ *
+ * The pipeline splits the samples into per-axis arrays of up to ADXL343_FILTER_BLOCK samples and runs every stage on
+ * contiguous arrays of one axis at a time, the FIR dot products are loops the compiler can vectorize (or explicit
+ * SSE2/NEON with ADXL343_USE_SIMD defined). The stages and the pipeline are caller provided, typically static, there
+ * is no allocation. Samples are expected in the range of the sensor (13 bit), stage outputs are saturated to int16.
+ *
+ * Coefficients are fixed point, designed offline: biquad coefficients in Q28 (the coefficient times 2^28, a0
+ * normalized to 1), FIR taps in Q15.
+ *
+ * @{
+ */
+
+
+// Includes
+// - Compiler includes
+#include <stdint.h>
+#include <stddef.h>
+// - Project includes
+#include "FunctionStatus.h"
+#include "adxl343_driver.h"
+
+
+// Defines
+// - Sizes
+#define ADXL343_FILTER_BLOCK 64                 // Samples per axis run through the stages at a time
+#define ADXL343_FILTER_MAX_TAPS 64              // FIR length
+#define ADXL343_FILTER_MAX_DECIMATION 16        // FIR decimation factor
+#define ADXL343_FILTER_MAX_RMS_WINDOW 256       // Moving RMS window, a power of two
+// - Stage types
+#define ADXL343_FILTER_BIQUAD 0x01              // Biquad IIR section, Q28 coefficients
+#define ADXL343_FILTER_FIR_DECIMATOR 0x02       // FIR low-pass keeping every n-th output, Q15 taps
+#define ADXL343_FILTER_DC_BLOCK 0x03            // One pole high-pass removing gravity/offsets
+#define ADXL343_FILTER_MOVING_RMS 0x04          // RMS of every axis over the last n samples
+// - Fixed point
+#define ADXL343_FILTER_BIQUAD_Q 28              // Fractional bits of the biquad coefficients
+#define ADXL343_FILTER_FIR_Q 15                 // Fractional bits of the FIR taps
+#define ADXL343_FILTER_STATE_Q 8                // Fractional bits kept on recursive outputs
+#if defined(ADXL343_USE_SIMD) && (defined(__SSE2__) || defined(__ARM_NEON))
+#define ADXL343_FILTER_SIMD 1                   // Explicit SIMD FIR kernel compiled in
+#else
+#define ADXL343_FILTER_SIMD 0
+#endif
+
+
+// Data structures
+// - Biquad coefficients, y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2], in Q28
+typedef struct {
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;
+    int32_t a2;
+} ADXL343BiquadCoeffs;
+
+typedef struct {
+    ADXL343BiquadCoeffs coeffs;
+    int32_t x1 [3];                             // Previous inputs, per axis
+    int32_t x2 [3];
+    int32_t y1 [3];                             // Previous outputs, per axis in Q8
+    int32_t y2 [3];
+} ADXL343Biquad;
+
+typedef struct {
+    int16_t taps [ADXL343_FILTER_MAX_TAPS];     // Q15, stored oldest sample first so the dot product runs forward
+    uint16_t length;
+    uint8_t factor;                             // Decimation factor, 1 filters without decimating
+    uint8_t phase;                              // Input samples until the next output
+    int16_t history [3][ADXL343_FILTER_MAX_TAPS - 1 + ADXL343_FILTER_BLOCK];  // Last length - 1 inputs, then the block
+} ADXL343FirDecimator;
+
+typedef struct {
+    uint8_t shift;                              // Pole at 1 - 2^-shift, cut-off about rate / (2 pi 2^shift)
+    int32_t x1 [3];                             // Previous inputs, per axis
+    int32_t y1 [3];                             // Previous outputs, per axis in Q8
+} ADXL343DcBlock;
+
+typedef struct {
+    uint16_t window;
+    uint8_t log2_window;
+    uint16_t index;                             // Oldest square, overwritten by the next sample
+    uint32_t squares [3][ADXL343_FILTER_MAX_RMS_WINDOW];
+    uint64_t sum [3];                           // Sum of the squares in the window, per axis
+    uint32_t root [3];                          // Last RMS, per axis, where the next square root starts
+} ADXL343MovingRms;
+
+typedef struct {
+    uint8_t type;                               // ADXL343_FILTER_* stage type
+    union {
+        ADXL343Biquad biquad;
+        ADXL343FirDecimator fir;
+        ADXL343DcBlock dc;
+        ADXL343MovingRms rms;
+    };
+} ADXL343FilterStage;
+
+typedef struct {
+    ADXL343FilterStage* stages;                 // Caller provided, run in order
+    size_t count;
+    int16_t work [3][ADXL343_FILTER_BLOCK];     // Per-axis block the stages run on
+} ADXL343FilterPipeline;
+
+
+// Functions
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a biquad IIR stage.
+ *
+ * @param stage  A pointer to the stage.
+ * @param coeffs A pointer to the Q28 coefficients, copied into the stage.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the stage was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_filter_biquad(ADXL343FilterStage* stage, const ADXL343BiquadCoeffs* coeffs);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a FIR decimator stage.
+ *
+ * The stage filters with the given taps and passes on every factor-th output, the outputs in between are not
+ * computed. The sum of the absolute taps should not exceed 2.0 (65536 in Q15).
+ *
+ * @param stage  A pointer to the stage.
+ * @param taps   A pointer to the Q15 taps, h[0] first, copied into the stage.
+ * @param length The number of taps (1 - ADXL343_FILTER_MAX_TAPS).
+ * @param factor The decimation factor (1 - ADXL343_FILTER_MAX_DECIMATION).
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the stage was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the length or factor is out of range.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_filter_fir_decimator(ADXL343FilterStage* stage, const int16_t* taps, size_t length,
+                                            uint8_t factor);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a DC removal stage.
+ *
+ * A one pole high-pass y = x - x[-1] + (1 - 2^-shift) y[-1], e.g. shift 7 has its cut-off at 4 Hz at 3200 Hz.
+ *
+ * @param stage A pointer to the stage.
+ * @param shift The pole shift (1 - 15).
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the stage was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the shift is out of range.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_filter_dc_block(ADXL343FilterStage* stage, uint8_t shift);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a moving RMS stage.
+ *
+ * Every sample is replaced by the RMS of each axis over the last window samples (the window starts out as zeros).
+ * The sum of squares is updated per sample and the square root is searched from the previous RMS, the cost does not
+ * depend on the window.
+ *
+ * @param stage  A pointer to the stage.
+ * @param window The window length, a power of two up to ADXL343_FILTER_MAX_RMS_WINDOW.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the stage was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the window is out of range or not a power of two.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_filter_moving_rms(ADXL343FilterStage* stage, size_t window);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a pipeline over initialized stages.
+ *
+ * @param pipeline A pointer to the pipeline.
+ * @param stages   A pointer to the stages, run in order. Must stay valid while the pipeline is used.
+ * @param count    The number of stages.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the pipeline was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_NOT_INITIALIZED if a stage has not been initialized.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_filter_init(ADXL343FilterPipeline* pipeline, ADXL343FilterStage* stages, size_t count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Clears the state of every stage, e.g. after a gap in the stream or a rate change.
+ *
+ * @param pipeline A pointer to the pipeline.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_filter_reset(ADXL343FilterPipeline* pipeline);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Runs a block of samples through the pipeline.
+ *
+ * The samples are filtered in place, decimating stages leave fewer samples than were passed in. The block may have
+ * any size, the stage state carries over to the next call.
+ *
+ * @param pipeline A pointer to the pipeline.
+ * @param samples  A pointer to the samples, overwritten with the output.
+ * @param count    The number of samples.
+ * @param output   A pointer to where the number of output samples will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the samples were processed.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_filter_process(ADXL343FilterPipeline* pipeline, ADXL343Sample* samples, size_t count,
+                                      size_t* output);
+
+/** @} */
+
+#endif /* INC_ADXL343_FILTER_H_ */
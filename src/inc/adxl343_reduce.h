@@ -0,0 +1,142 @@
+#ifndef INC_ADXL343_REDUCE_H_
+#define INC_ADXL343_REDUCE_H_
+
+/**
+ * @file adxl343_reduce.h
+ * @brief Accelerometer Data Reduction Interface
+ *
+ * This module thins out a stream of timestamped samples (e.g. from adxl343_read_fifo_timestamped) before it is
+ * transmitted, a sensor that sits still reports little more than a heartbeat. Two modes:
+ *
+ * - Deadband: a sample is passed on when an axis moved more than its threshold from the last sample passed on.
+ *   Holding the last point reproduces every sample within the thresholds.
+ * - Swinging door: the stream is cut into straight segments between passed on samples, a segment is extended as long
+ *   as the line from its start to the newest sample stays within the per-axis error bound of every sample in
+ *   between. Drawing lines between the points reproduces every sample within the bounds.
+ *
+ * In both modes a point is also passed on when the heartbeat interval has gone by since the last one, so a receiver
+ * can tell a quiet sensor from a lost one. The reducer is caller provided, typically static, there is no allocation.
+ *
+ * @{
+ */
+
+
+// Includes
+// - Compiler includes
+#include <stdint.h>
+#include <stddef.h>
+// - Project includes
+#include "FunctionStatus.h"
+#include "adxl343_driver.h"
+
+
+// Defines
+// - Modes
+#define ADXL343_REDUCE_DEADBAND 0x01            // Pass on samples that moved more than the threshold
+#define ADXL343_REDUCE_SWINGING_DOOR 0x02       // Pass on the ends of segments within the error bound
+// - Limits
+#define ADXL343_REDUCE_MAX_THRESHOLD 4095       // Deadband or error bound, LSB
+#define ADXL343_REDUCE_MAX_SPAN_NS (1ull << 40) // Longest segment (about 18 minutes), keeps the slope products in int64
+
+
+// Data structures
+typedef struct {
+    uint64_t timestamp;                         // ns on the host clock
+    ADXL343Sample sample;
+} ADXL343ReducedPoint;
+
+typedef struct {
+    uint8_t mode;                               // ADXL343_REDUCE_* mode
+    uint16_t threshold [3];                     // Deadband or error bound per axis, LSB
+    uint64_t heartbeat_ns;                      // Longest time without a point, 0 for none
+} ADXL343ReduceConfig;
+
+typedef struct {
+    ADXL343ReduceConfig config;
+    uint8_t started;                            // A first point was passed on
+    uint8_t pending;                            // previous is the end of the open segment, not passed on yet
+    uint8_t doors;                              // The open segment has samples in between, the slopes are set
+    ADXL343ReducedPoint anchor;                 // Last point passed on, start of the open segment
+    ADXL343ReducedPoint previous;               // Newest sample of the open segment
+    int32_t upper_num [3];                      // Steepest slope still within the bound of every sample in between,
+    int64_t upper_den [3];                      // per axis as LSB over ns
+    int32_t lower_num [3];                      // Flattest slope
+    int64_t lower_den [3];
+    uint64_t inputs;                            // Samples pushed since the last reset
+    uint64_t outputs;                           // Points passed on since the last reset
+} ADXL343Reducer;
+
+
+// Functions
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a reducer.
+ *
+ * @param reducer A pointer to the reducer.
+ * @param config  A pointer to the configuration, copied into the reducer.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the reducer was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the mode is unknown or a threshold is above
+ *                         ADXL343_REDUCE_MAX_THRESHOLD.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_reduce_init(ADXL343Reducer* reducer, const ADXL343ReduceConfig* config);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Starts over, the next sample is passed on, e.g. after a gap in the stream.
+ *
+ * @param reducer A pointer to the reducer.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_reduce_reset(ADXL343Reducer* reducer);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Feeds a block of timestamped samples to the reducer.
+ *
+ * A sample passes on at most one point in deadband mode and two in swinging door mode (the end of the segment it
+ * breaks and, on a heartbeat or a time step back, itself). A sample is only taken while the point buffer has room
+ * for that many, the rest is left for the next call. Timestamps are expected to increase, a step back or a gap
+ * over ADXL343_REDUCE_MAX_SPAN_NS closes the segment.
+ *
+ * @param reducer    A pointer to the reducer.
+ * @param samples    A pointer to the samples, oldest first.
+ * @param timestamps A pointer to the timestamps of the samples, in ns.
+ * @param count      The number of samples.
+ * @param points     A pointer to where the points passed on will be written.
+ * @param max        The number of points the buffer can hold.
+ * @param consumed   A pointer to where the number of samples consumed will be written.
+ * @param emitted    A pointer to where the number of points written will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if all samples were consumed.
+ *                         Returns FUNCTION_STATUS_NOT_INITIALIZED if the reducer was not initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BUSY if the point buffer filled up before all samples were consumed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_reduce_push(ADXL343Reducer* reducer, const ADXL343Sample* samples, const uint64_t* timestamps,
+                                   size_t count, ADXL343ReducedPoint* points, size_t max, size_t* consumed,
+                                   size_t* emitted);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Passes on the end of the open segment, e.g. before the stream stops.
+ *
+ * In swinging door mode the newest sample is held back until it is known where its segment ends, deadband mode
+ * holds nothing back.
+ *
+ * @param reducer A pointer to the reducer.
+ * @param points  A pointer to where the point will be written.
+ * @param max     The number of points the buffer can hold.
+ * @param emitted A pointer to where the number of points written (0 or 1) will be written.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if nothing is held back anymore.
+ *                         Returns FUNCTION_STATUS_NOT_INITIALIZED if the reducer was not initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BUSY if a point is held back and the buffer has no room.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_reduce_flush(ADXL343Reducer* reducer, ADXL343ReducedPoint* points, size_t max,
+                                    size_t* emitted);
+
+/** @} */
+
+#endif /* INC_ADXL343_REDUCE_H_ */
@@ -0,0 +1,159 @@
+#ifndef INC_ADXL343_RING_H_
+#define INC_ADXL343_RING_H_
+
+/**
+ * @file adxl343_ring.h
+ * @brief Accelerometer Sample Ring Interface
+ *
+ * This module provides a fixed capacity, lock-free single producer/single consumer ring of decoded ADXL343 samples.
+ * The producer is meant to be the interrupt path (adxl343_drain_fifo_to_ring) and the consumer the processing loop,
+ * no interrupts need to be disabled as each index is only written by one side. The producer and consumer indices
+ * live on separate cache lines so the two sides do not false-share. Both sides work on contiguous spans of the
+ * storage, so samples are decoded straight into the ring and processed in place without extra copies.
+ *
+ * The storage is provided by the caller and its capacity must be a power of two. Samples that do not fit are
+ * dropped (newest first) and counted, the producer never waits on the consumer.
+ *
+ * @{
+ */
+
+
+// Includes
+// - Compiler includes
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+// - Project includes
+#include "FunctionStatus.h"
+#include "adxl343_driver.h"
+
+
+// Defines
+#define ADXL343_RING_CACHE_LINE 64              // Alignment separating producer and consumer state
+
+
+// Data structures
+typedef struct ADXL343Ring {
+    // - Producer side
+    _Alignas(ADXL343_RING_CACHE_LINE) _Atomic size_t head;  // Free running write index
+    size_t cached_tail;                                     // Last consumer index seen by the producer
+    _Atomic uint32_t dropped;                               // Samples discarded because the ring was full
+    _Atomic uint32_t overruns;                              // Pushes that found the ring full
+    // - Consumer side
+    _Alignas(ADXL343_RING_CACHE_LINE) _Atomic size_t tail;  // Free running read index
+    size_t cached_head;                                     // Last producer index seen by the consumer
+    // - Shared, read only after init
+    _Alignas(ADXL343_RING_CACHE_LINE) ADXL343Sample* storage;
+    size_t mask;
+} ADXL343Ring;
+
+
+// Functions
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a sample ring on caller provided storage.
+ *
+ * Neither side may use the ring while it is initialized.
+ *
+ * @param ring     A pointer to the ring.
+ * @param storage  A pointer to the sample storage.
+ * @param capacity The number of samples in the storage, must be a power of two.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the ring was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_ring_init(ADXL343Ring* ring, ADXL343Sample* storage, size_t capacity);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Reserves a contiguous span of free samples (producer).
+ *
+ * The span ends at the end of the storage or at the oldest unconsumed sample, so a second reserve after committing
+ * may return the part that wrapped around. Samples written to the span become visible on adxl343_ring_commit.
+ *
+ * @param ring   A pointer to the ring.
+ * @param span   A pointer to where the start of the span will be written.
+ * @param length A pointer to where the number of samples in the span will be written, 0 if the ring is full.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the span was reserved.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_ring_reserve(ADXL343Ring* ring, ADXL343Sample** span, size_t* length);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Publishes samples written to a reserved span (producer).
+ *
+ * @param ring  A pointer to the ring.
+ * @param count The number of samples written, at most the length of the last reserved span.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_ring_commit(ADXL343Ring* ring, size_t count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Copies samples into the ring (producer).
+ *
+ * Samples that do not fit are dropped and added to the drop counter.
+ *
+ * @param ring    A pointer to the ring.
+ * @param samples A pointer to the samples to push.
+ * @param count   The number of samples to push.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if all samples were pushed.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if samples were dropped.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_ring_push(ADXL343Ring* ring, const ADXL343Sample* samples, size_t count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Records samples the producer had to discard (producer).
+ *
+ * @param ring  A pointer to the ring.
+ * @param count The number of samples dropped.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_ring_drop(ADXL343Ring* ring, size_t count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the contiguous span of the oldest unconsumed samples (consumer).
+ *
+ * The span ends at the end of the storage or at the newest sample, the samples stay valid until they are consumed.
+ *
+ * @param ring   A pointer to the ring.
+ * @param span   A pointer to where the start of the span will be written.
+ * @param length A pointer to where the number of samples in the span will be written, 0 if the ring is empty.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the span was retrieved.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_ring_peek(ADXL343Ring* ring, const ADXL343Sample** span, size_t* length);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Releases processed samples back to the producer (consumer).
+ *
+ * @param ring  A pointer to the ring.
+ * @param count The number of samples processed, at most the length of the last peeked span.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_ring_consume(ADXL343Ring* ring, size_t count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the number of samples waiting in the ring (either side).
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+size_t adxl343_ring_size(ADXL343Ring* ring);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the drop counters of the ring (either side).
+ *
+ * @param ring     A pointer to the ring.
+ * @param dropped  A pointer to where the number of dropped samples will be written, may be NULL.
+ * @param overruns A pointer to where the number of pushes that found the ring full will be written, may be NULL.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+void adxl343_ring_get_counters(ADXL343Ring* ring, uint32_t* dropped, uint32_t* overruns);
+
+/** @} */
+
+#endif /* INC_ADXL343_RING_H_ */
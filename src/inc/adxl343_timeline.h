@@ -0,0 +1,104 @@
+#ifndef INC_ADXL343_TIMELINE_H_
+#define INC_ADXL343_TIMELINE_H_
+
+/**
+ * @file adxl343_timeline.h
+ * @brief Accelerometer Sample Timeline Interface
+ *
+ * This module reconstructs when the samples of a FIFO batch were taken from a single host clock reading per drain.
+ * The newest sample in the FIFO was taken within one output data period before FIFO_STATUS was read, every older
+ * entry one period earlier. Samples are stamped evenly spaced and continuous from batch to batch, with the period
+ * estimated from the host clock over a long baseline (up to 65536 samples) so the drift between the sensor's
+ * oscillator and the host clock is tracked. Small timing errors are corrected gradually, a gap (lost samples, a late
+ * drain) re-anchors the timeline and the period estimate is kept until the new baseline is as long as the old one. A
+ * single sample lost to a FIFO overrun can not be told apart from read jitter, it is absorbed by the phase correction.
+ *
+ * Timestamps are in nanoseconds of the host clock that is passed in.
+ *
+ * @{
+ */
+
+
+// Includes
+// - Compiler includes
+#include <stdint.h>
+#include <stddef.h>
+// - Project includes
+#include "FunctionStatus.h"
+
+
+// Defines
+#define ADXL343_TIMELINE_MIN_BASELINE 1024      // Samples between clock readings before the period is estimated
+#define ADXL343_TIMELINE_MAX_BASELINE 65536     // Baseline start moves up by half when it gets this long
+#define ADXL343_TIMELINE_MAX_DRIFT_PPM 50000    // Period estimates further off nominal are ignored
+#define ADXL343_TIMELINE_PHASE_GAIN 8           // 1/n of the timing error is corrected per batch
+#define ADXL343_TIMELINE_RESYNC_PERIODS 2       // Timing errors beyond this many periods re-anchor the timeline
+
+
+// Data structures
+typedef struct ADXL343Timeline {
+    uint8_t rate;                               // BW_RATE rate code the timeline runs at
+    uint8_t anchored;                           // Set once the first batch has been stamped
+    uint64_t nominal_q16;                       // Data sheet period at the rate, ns in Q16 fixed point
+    uint64_t period_q16;                        // Estimated sample period, ns in Q16 fixed point
+    uint64_t last_ns;                           // Timestamp of the last stamped sample
+    uint32_t last_frac;                         // Its fraction, 1/65536 ns
+    uint64_t index;                             // Samples stamped since the timeline was anchored
+    uint64_t ref_ns;                            // Start of the period baseline, clock reading of a sample
+    uint64_t ref_index;                         // Index of that sample
+    uint64_t baseline;                          // Samples the period estimate spans, 0 while nominal
+    uint32_t resyncs;                           // Times the timeline was re-anchored after a gap
+} ADXL343Timeline;
+
+
+// Functions
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Initializes a timeline for an output data rate.
+ *
+ * Also used to restart the timeline, e.g. after the rate changed.
+ *
+ * @param timeline A pointer to the timeline.
+ * @param rate     The BW_RATE rate code (0x00 - 0x0F) the samples are taken at.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the timeline was initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BOUNDARY_ERROR if the rate code is out of range.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_timeline_init(ADXL343Timeline* timeline, uint8_t rate);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Stamps a batch of samples drained from the FIFO.
+ *
+ * host_ns is the host clock when the FIFO held entries samples (when FIFO_STATUS was read, or at the watermark
+ * interrupt with entries being the watermark). The oldest count of them are stamped, oldest first, the ones left in
+ * the FIFO continue the timeline in the next batch.
+ *
+ * @param timeline   A pointer to the timeline.
+ * @param host_ns    The host clock reading, in ns.
+ * @param entries    The number of samples in the FIFO at host_ns.
+ * @param timestamps A pointer to where the count timestamps will be written.
+ * @param count      The number of samples to stamp, at most entries.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the samples were stamped.
+ *                         Returns FUNCTION_STATUS_NOT_INITIALIZED if the timeline was not initialized.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+FunctionStatus adxl343_timeline_stamp(ADXL343Timeline* timeline, uint64_t host_ns, size_t entries,
+                                      uint64_t* timestamps, size_t count);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Gets the estimated drift of the sensor's output data rate against the host clock.
+ *
+ * @param timeline A pointer to the timeline.
+ *
+ * @return int32_t  Parts per million the sample period is longer (positive) or shorter than nominal, 0 until the
+ *                  baseline is long enough.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+int32_t adxl343_timeline_drift_ppm(const ADXL343Timeline* timeline);
+
+/** @} */
+
+#endif /* INC_ADXL343_TIMELINE_H_ */
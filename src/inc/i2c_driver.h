@@ -40,13 +40,42 @@
 // --------------------------------------------------------------------------------------------------------------------
 // Constant and macro definitions 
 // --------------------------------------------------------------------------------------------------------------------
+#define I2C_QUEUE_DEPTH 64                      //!< Transactions that can be in flight, must be a power of two
 
+#define I2C_TRANSACTION_WRITE 0x00              //!< Transaction type, i2c_write
+#define I2C_TRANSACTION_READ 0x01               //!< Transaction type, i2c_read
+#define I2C_TRANSACTION_WRITE_READ 0x02         //!< Transaction type, i2c_write_read
 
 
 // --------------------------------------------------------------------------------------------------------------------
 // Type definitions. 
 // --------------------------------------------------------------------------------------------------------------------
-
+struct I2CTransaction;
+
+//! Completion callback, called from i2c_poll once the transaction has finished
+typedef void (*I2CCompletionCallback)(struct I2CTransaction* transaction, void* context);
+
+//! Descriptor of a queued transaction, owned by the caller until its completion callback has been called
+typedef struct I2CTransaction {
+    uint8_t type;                               //!< I2C_TRANSACTION_*
+    const char* dataToWrite;                    //!< Write phase, including the device address (write, write_read)
+    size_t writeLength;
+    char* dataToRead;                           //!< Read phase (read, write_read)
+    size_t readLength;
+    uint32_t timeout;                           //!< Timeout of the transfer once it is started, in milliseconds
+    I2CCompletionCallback callback;             //!< May be NULL
+    void* context;                              //!< Handed back to the callback as is
+    volatile FunctionStatus status;             //!< FUNCTION_STATUS_PENDING until the transaction has finished
+} I2CTransaction;
+
+//! Bus backend, the implementation behind i2c_write, i2c_read and i2c_write_read (same frames and return values)
+typedef struct I2CBackend {
+    FunctionStatus (*write)(void* context, const char* dataToWrite, size_t length, uint32_t timeout);
+    FunctionStatus (*read)(void* context, char* dataToRead, size_t length, uint32_t timeout);
+    FunctionStatus (*write_read)(void* context, const char* dataToWrite, size_t writeLength, char* dataToRead,
+                                 size_t readLength, uint32_t timeout);
+    void* context;                              //!< Handed to every call as is, e.g. the adapter handle
+} I2CBackend;
 
 
 
@@ -100,6 +129,86 @@ extern FunctionStatus i2c_write(const char* dataToWrite, size_t length, uint32_t
  */
 extern FunctionStatus i2c_read(char* dataToRead, size_t length, uint32_t timeout);
 
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Writes byte(s) to and then reads byte(s) from an I2C device in one combined (repeated-start) transaction.
+ *
+ * This function sends the bytes in dataToWrite, issues a repeated start instead of a stop condition, re-addresses the
+ * same device with the read bit set and reads length bytes into dataToRead before releasing the bus. It is typically 
+ * used to set a device's register pointer and read back from it without giving up the bus in between, which saves a 
+ * stop/start pair and a full address phase compared to separate i2c_write and i2c_read calls.
+ *
+ * @param dataToWrite A pointer to a buffer containing the sequence of bytes to be transmitted. This buffer should 
+ *                    include the target device's (write) address and the register address within the device. The
+ *                    read address used after the repeated start is derived from it by setting the read bit.
+ * @param writeLength The number of bytes to transmit from the dataToWrite buffer.
+ * @param dataToRead  A pointer to a buffer where the read data will be stored. The caller must ensure that the 
+ *                    buffer is large enough to hold the number of bytes specified by the readLength parameter.
+ * @param readLength  The number of bytes to read into the dataToRead buffer.
+ * @param timeout     The maximum duration to wait for the whole transaction to complete, in milliseconds. A timeout 
+ *                    value of 0 indicates a non-blocking operation, where the function will return immediately 
+ *                    if the bus is busy.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transaction was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+extern FunctionStatus i2c_write_read(const char* dataToWrite, size_t writeLength, char* dataToRead, size_t readLength,
+                                     uint32_t timeout);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Selects the backend the I2C primitives run on.
+ *
+ * Without a backend (NULL, the default) i2c_write, i2c_read and i2c_write_read use the built-in implementation of the
+ * target this file is linked for. With one, every call (including those made by i2c_process) is forwarded to it, 
+ * e.g. to a Linux i2c-dev adapter (i2c_linux.h) or an in-process fake. The backend must stay valid while it is
+ * selected and should not be changed while transactions are queued.
+ *
+ * @param backend A pointer to the backend, NULL for the built-in implementation.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+extern void i2c_set_backend(const I2CBackend* backend);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Queues a transaction on the I2C bus without blocking.
+ *
+ * The descriptor is appended to the transaction queue and its status is set to FUNCTION_STATUS_PENDING. Queued 
+ * transactions are executed in submission order by i2c_process and completed by i2c_poll. The descriptor and the 
+ * buffers it points to must stay valid until the completion callback has been called. i2c_submit and i2c_poll belong
+ * to the application side and must be called from the same thread (or from completion callbacks).
+ *
+ * @param transaction A pointer to the transaction descriptor.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transaction was queued.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_BUSY if I2C_QUEUE_DEPTH transactions are already in flight.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+extern FunctionStatus i2c_submit(I2CTransaction* transaction);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Executes the queued transactions.
+ *
+ * This is the bus side of the queue: on a target it runs from the I2C/DMA interrupt or an RTOS task, on a host from a
+ * worker thread. Each transaction is run to completion with the blocking primitives above and handed over to i2c_poll.
+ *
+ * @return size_t  The number of transactions executed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+extern size_t i2c_process(void);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Completes finished transactions.
+ *
+ * Calls the completion callbacks of the transactions finished by i2c_process, in submission order, on the calling
+ * (application) thread. Callbacks may submit follow-up transactions.
+ *
+ * @return size_t  The number of transactions completed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+extern size_t i2c_poll(void);
+
 
 
 /** @} */
@@ -0,0 +1,79 @@
+#ifndef INC_I2C_LINUX_H_
+#define INC_I2C_LINUX_H_
+
+/**
+ * @file i2c_linux.h
+ * @brief Linux i2c-dev Backend Interface
+ *
+ * @defgroup hal Hardware Abstraction Layer (HAL)
+ * @brief Abstracts hardware specifics through a unified API.
+ *
+ * This module runs the I2C primitives of i2c_driver.h on a Linux userspace adapter (/dev/i2c-N). Every call is one
+ * I2C_RDWR ioctl, so i2c_write_read sends the register address write and the data read as one combined message with
+ * a repeated start, in a single system call. The adapter is selected with i2c_set_backend(&adapter.backend) once it
+ * has been opened. On other platforms opening an adapter fails.
+ *
+ * @{
+ */
+
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// Include files 
+// --------------------------------------------------------------------------------------------------------------------
+
+// CompilerIncludes
+//  All include files that are provided by the compiler directly
+#include <stdint.h>                             //!< Include to use integer types
+
+// ProjectIncludes
+// All include files that are provided by the project
+#include "FunctionStatus.h"                     //!< Include to use the generic function status enumeration type
+#include "i2c_driver.h"                         //!< Include to use the backend interface
+
+// --------------------------------------------------------------------------------------------------------------------
+// Constant and macro definitions 
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Type definitions. 
+// --------------------------------------------------------------------------------------------------------------------
+
+//! Open adapter, owned by the caller
+typedef struct {
+    I2CBackend backend;                         //!< Backend to hand to i2c_set_backend, its context is the adapter
+    int fd;                                     //!< File descriptor of the adapter, -1 when closed
+    uint8_t address;                            //!< 7 bit address of the last write, used by i2c_read
+    uint32_t timeout;                           //!< Timeout last set on the adapter, in milliseconds
+} I2CLinuxAdapter;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Function declarations 
+// --------------------------------------------------------------------------------------------------------------------
+
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Opens a Linux I2C adapter.
+ *
+ * @param adapter A pointer to the adapter handle to initialize.
+ * @param path    The device node of the adapter, e.g. "/dev/i2c-1".
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the adapter was opened.
+ *                         Returns FUNCTION_STATUS_ERROR if the device node can not be opened or is not an I2C adapter
+ *                         supporting combined messages (I2C_FUNC_I2C), or on other platforms than Linux.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers are passed.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+extern FunctionStatus i2c_linux_open(I2CLinuxAdapter* adapter, const char* path);
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Closes a Linux I2C adapter, it must not be the selected backend anymore.
+ *
+ * @param adapter A pointer to the adapter handle.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+extern void i2c_linux_close(I2CLinuxAdapter* adapter);
+
+/** @} */
+
+#endif /* INC_I2C_LINUX_H_ */
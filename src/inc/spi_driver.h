@@ -0,0 +1,70 @@
+#ifndef INC_SPI_DRIVER_H_
+#define INC_SPI_DRIVER_H_
+
+/**
+ * @file spi_driver.h
+ * @brief SPI Driver Module Interface
+ *
+ * @defgroup hal Hardware Abstraction Layer (HAL)
+ * @brief Abstracts hardware specifics through a unified API.
+ *
+ * This module provides an interface for 4-wire SPI (Serial Peripheral Interface) communication. It abstracts the
+ * lower-level details of hardware interaction, facilitating communication with SPI peripherals. Transfers are full
+ * duplex, a byte is shifted in for every byte shifted out, and the chip select line is held active for the whole
+ * transfer.
+ *
+ * @{
+ */
+
+
+
+// --------------------------------------------------------------------------------------------------------------------
+// Include files 
+// --------------------------------------------------------------------------------------------------------------------
+
+// CompilerIncludes
+//  All include files that are provided by the compiler directly
+#include <stdint.h>                             //!< Include to use integer types
+#include <stddef.h>
+
+// ProjectIncludes
+// All include files that are provided by the project
+#include "FunctionStatus.h"                     //!< Include to use the generic function status enumeration type
+
+// --------------------------------------------------------------------------------------------------------------------
+// Constant and macro definitions 
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Type definitions. 
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Function declarations 
+// --------------------------------------------------------------------------------------------------------------------
+
+
+/** -------------------------------------------------------------------------------------------------------------------
+ * @brief Exchanges byte(s) of data with the SPI device in one chip select cycle.
+ *
+ * This function asserts the chip select line, shifts out length bytes from dataToWrite while shifting in length
+ * bytes into dataToRead, and releases the chip select line. This function blocks until the transfer is complete or
+ * the timeout expires.
+ *
+ * @param dataToWrite A pointer to a buffer containing the sequence of bytes to be transmitted, typically a command
+ *                    byte followed by the data (or dummy bytes when reading).
+ * @param dataToRead  A pointer to a buffer where the received bytes will be stored, NULL if they are not needed.
+ * @param length      The number of bytes to exchange.
+ * @param timeout     The maximum duration to wait for the transfer to complete, in milliseconds.
+ *
+ * @return FunctionStatus  Returns FUNCTION_STATUS_OK if the transfer was successful.
+ *                         Returns FUNCTION_STATUS_ERROR for non-specific errors.
+ *                         Returns FUNCTION_STATUS_ARGUMENT_ERROR if null pointers or invalid arguments are passed.
+ *                         Returns FUNCTION_STATUS_TIMEOUT if the operation did not complete within the specified timeout period.
+ * --------------------------------------------------------------------------------------------------------------------
+ */
+extern FunctionStatus spi_transfer(const char* dataToWrite, char* dataToRead, size_t length, uint32_t timeout);
+
+/** @} */
+
+#endif /* INC_SPI_DRIVER_H_ */
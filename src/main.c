@@ -7,20 +7,22 @@
 #include "adxl343_driver.h"
 
 int main(){
+    ADXL343Device accelerometer;
+
     // Configuring micro
     // - just imagine
     // Configuring i2c
     // - pretend its just majestic things here as well
     
     // Initialise Accelerometer
-    if (adxl343_init() != FUNCTION_STATUS_OK){
+    if (adxl343_init(&accelerometer, NULL, ADXL343_ADDRESS_I2C) != FUNCTION_STATUS_OK){
         // Sad :(
     }
     
     // Using the Accelerometer
-    adxl343_set_resolution_full();
-    adxl343_set_bit_order(0x01);
-    adxl343_start();
+    adxl343_set_resolution_full(&accelerometer);
+    adxl343_set_bit_order(&accelerometer, 0x01);
+    adxl343_start(&accelerometer);
     
     return 0;
 }
\ No newline at end of file
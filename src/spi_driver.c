@@ -0,0 +1,43 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  spi_driver.c
+/// \brief Description
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Include files
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "spi_driver.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Constant and macro definitions
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Type definitions
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// File-scope variables
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Function declarations
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Function definitions
+// --------------------------------------------------------------------------------------------------------------------
+FunctionStatus spi_transfer(const char* dataToWrite, char* dataToRead, size_t length, uint32_t timeout)
+{
+    if (dataToWrite == NULL || length == 0)
+    {
+        return FUNCTION_STATUS_ARGUMENT_ERROR;
+    }
+    (void)dataToRead;
+    (void)timeout;
+
+    // Assume there is a nice implementation of a chip select framed SPI transfer here :)
+
+    return FUNCTION_STATUS_OK;
+}
@@ -0,0 +1,259 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_adxl343.c
+/// \brief register accurate ADXL343 model answering the simulated i2c bus
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "sim_adxl343.h"
+#include "sim_spi_bus.h"
+#include "adxl343_driver.h"
+
+#include <string.h>
+
+
+// Statics
+static void _sim_adxl343_begin(void* state, uint64_t time_ns);
+static uint8_t _sim_adxl343_read(void* state, uint8_t register_address);
+static void _sim_adxl343_write(void* state, uint8_t register_address, uint8_t value);
+static void _sim_adxl343_end(void* state);
+
+static const SimI2CDevice sim_adxl343_device = {
+    _sim_adxl343_begin, _sim_adxl343_read, _sim_adxl343_write, _sim_adxl343_end
+};
+
+static uint8_t _sim_adxl343_fifo_mode(const SimADXL343* sim){
+    return sim->registers[ADXL343_REG_FIFO_CTL] >> 6;
+}
+
+static uint8_t _sim_adxl343_fifo_samples(const SimADXL343* sim){
+    return sim->registers[ADXL343_REG_FIFO_CTL] & ADXL343_FIFO_SAMPLES_MASK;
+}
+
+static void _sim_adxl343_encode(const SimADXL343* sim, const int32_t mg[3], uint8_t raw[6]){
+    uint8_t format = sim->registers[ADXL343_REG_DATA_FORMAT];
+    uint8_t range = format & 0x03;
+    uint8_t full_resolution = (format >> 3) & 0x01;
+    uint8_t left_justified = (format >> 2) & 0x01;
+    // 3.9 mg/LSB in full resolution, otherwise 10 bits over the range
+    uint8_t width = full_resolution ? 10 + range : 10;
+    int32_t lsb_per_g = full_resolution ? 256 : (256 >> range);
+    int32_t limit = 1 << (width - 1);
+    for (int axis = 0; axis < 3; axis++){
+        // OFSX, OFSY and OFSZ are added to every sample, 15.6 mg/LSB
+        int32_t mg_q6 = mg[axis] * 64 + (int8_t) sim->registers[ADXL343_REG_OFSX + axis] * 1000;
+        int32_t counts = (mg_q6 * lsb_per_g + ((mg_q6 < 0) ? -32000 : 32000)) / 64000;
+        if (counts > limit - 1){
+            counts = limit - 1;
+        } else if (counts < -limit){
+            counts = -limit;
+        }
+        uint16_t value = left_justified ? (uint16_t) (counts * (1 << (16 - width))) : (uint16_t) counts;
+        raw[2 * axis] = (uint8_t) value;
+        raw[2 * axis + 1] = (uint8_t) (value >> 8);
+    }
+}
+
+static void _sim_adxl343_drop_oldest(SimADXL343* sim, uint8_t keep){
+    if (sim->entries <= keep){return;}
+    uint8_t dropped = sim->entries - keep;
+    memmove(sim->fifo[0], sim->fifo[dropped], keep * sizeof(sim->fifo[0]));
+    sim->entries = keep;
+    sim->samples_lost += dropped;
+    sim->overrun = 1;
+}
+
+static void _sim_adxl343_store(SimADXL343* sim, const uint8_t raw[6]){
+    switch (_sim_adxl343_fifo_mode(sim)){
+    case ADXL343_FIFO_MODE_BYPASS:
+        // Only the data registers, unread data is replaced
+        _sim_adxl343_drop_oldest(sim, 0);
+        break;
+    case ADXL343_FIFO_MODE_FIFO:
+        if (sim->entries == SIM_ADXL343_FIFO_ENTRIES){
+            sim->samples_lost++;
+            sim->overrun = 1;
+            return;
+        }
+        break;
+    case ADXL343_FIFO_MODE_TRIGGER:
+        // Collecting stops once full after the trigger, before it the FIFO streams
+        if (sim->triggered && sim->entries == SIM_ADXL343_FIFO_ENTRIES){
+            sim->samples_lost++;
+            sim->overrun = 1;
+            return;
+        }
+        _sim_adxl343_drop_oldest(sim, SIM_ADXL343_FIFO_ENTRIES - 1);
+        break;
+    default:
+        _sim_adxl343_drop_oldest(sim, SIM_ADXL343_FIFO_ENTRIES - 1);
+        break;
+    }
+    memcpy(sim->fifo[sim->entries], raw, 6);
+    sim->entries++;
+}
+
+static void _sim_adxl343_begin(void* state, uint64_t time_ns){
+    sim_adxl343_advance_to(state, time_ns);
+}
+
+static uint8_t _sim_adxl343_read(void* state, uint8_t register_address){
+    SimADXL343* sim = state;
+    if (register_address >= ADXL343_DATA_X_0 && register_address <= ADXL343_DATA_Z_1){
+        sim->data_read = 1;
+        const uint8_t* data = (sim->entries > 0) ? sim->fifo[0] : sim->output;
+        return data[register_address - ADXL343_DATA_X_0];
+    }
+    if (register_address == ADXL343_REG_INT_SOURCE){
+        uint8_t source = sim_adxl343_int_source(sim);
+        sim->latched = 0;
+        return source;
+    }
+    if (register_address == ADXL343_REG_FIFO_STATUS){
+        return (uint8_t) ((sim->triggered << 7) | sim->entries);
+    }
+    return sim->registers[register_address % SIM_I2C_BUS_REGISTERS];
+}
+
+static void _sim_adxl343_write(void* state, uint8_t register_address, uint8_t value){
+    SimADXL343* sim = state;
+    switch (register_address){
+    case 0x00:
+    case ADXL343_REG_ACT_TAP_STATUS:
+    case ADXL343_REG_INT_SOURCE:
+    case ADXL343_DATA_X_0:
+    case ADXL343_DATA_X_1:
+    case ADXL343_DATA_Y_0:
+    case ADXL343_DATA_Y_1:
+    case ADXL343_DATA_Z_0:
+    case ADXL343_DATA_Z_1:
+    case ADXL343_REG_FIFO_STATUS:
+        // Read only
+        return;
+    case ADXL343_REG_POWER_CTL:
+        // Sampling starts one period after entering measurement mode
+        if ((value & 0x08) && !(sim->registers[ADXL343_REG_POWER_CTL] & 0x08)){
+            sim->registers[ADXL343_REG_POWER_CTL] = value;
+            sim->next_sample_ns = sim->now_ns + sim_adxl343_period_ns(sim);
+            return;
+        }
+        break;
+    case ADXL343_REG_FIFO_CTL:
+        // A mode change restarts the FIFO, bypass holds no entries
+        if ((value >> 6) != _sim_adxl343_fifo_mode(sim)){
+            sim->triggered = 0;
+            if ((value >> 6) == ADXL343_FIFO_MODE_BYPASS && sim->entries > 0){
+                memcpy(sim->output, sim->fifo[sim->entries - 1], 6);
+                sim->entries = 0;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    sim->registers[register_address % SIM_I2C_BUS_REGISTERS] = value;
+}
+
+static void _sim_adxl343_end(void* state){
+    SimADXL343* sim = state;
+    // Reading the data registers pops the FIFO once the transaction ends
+    if (sim->data_read && sim->entries > 0){
+        memcpy(sim->output, sim->fifo[0], 6);
+        memmove(sim->fifo[0], sim->fifo[1], (sim->entries - 1) * sizeof(sim->fifo[0]));
+        sim->entries--;
+    }
+    if (sim->data_read){
+        sim->overrun = 0;
+    }
+    sim->data_read = 0;
+}
+
+static void _sim_adxl343_power_on(SimADXL343* sim){
+    memset(sim, 0, sizeof(SimADXL343));
+    sim->registers[0x00] = SIM_ADXL343_DEVID;
+    sim->registers[ADXL343_REG_BW_RATE] = 0x0A;
+    sim->now_ns = sim_i2c_bus_now_ns();
+}
+
+
+// Functions
+void sim_adxl343_attach(SimADXL343* sim, uint8_t address){
+    _sim_adxl343_power_on(sim);
+    sim_i2c_bus_attach(address, &sim_adxl343_device, sim);
+}
+
+void sim_adxl343_attach_spi(SimADXL343* sim){
+    _sim_adxl343_power_on(sim);
+    sim_spi_bus_attach(&sim_adxl343_device, sim);
+}
+
+void sim_adxl343_set_acceleration(SimADXL343* sim, int32_t x_mg, int32_t y_mg, int32_t z_mg){
+    sim->acceleration[0] = x_mg;
+    sim->acceleration[1] = y_mg;
+    sim->acceleration[2] = z_mg;
+    sim->source = NULL;
+}
+
+void sim_adxl343_set_source(SimADXL343* sim, SimADXL343Source source, void* context){
+    sim->source = source;
+    sim->source_context = context;
+}
+
+void sim_adxl343_advance_to(SimADXL343* sim, uint64_t time_ns){
+    if (time_ns < sim->now_ns){return;}
+    sim->now_ns = time_ns;
+    if (!(sim->registers[ADXL343_REG_POWER_CTL] & 0x08)){return;}
+    while (sim->next_sample_ns <= sim->now_ns){
+        int32_t mg [3] = {sim->acceleration[0], sim->acceleration[1], sim->acceleration[2]};
+        uint8_t raw [6];
+        if (sim->source != NULL){
+            sim->source(sim->source_context, sim->next_sample_ns, mg);
+        }
+        _sim_adxl343_encode(sim, mg, raw);
+        _sim_adxl343_store(sim, raw);
+        sim->samples_generated++;
+        sim->next_sample_ns += sim_adxl343_period_ns(sim);
+    }
+}
+
+void sim_adxl343_raise_event(SimADXL343* sim, uint8_t sources){
+    sim->latched |= sources & (ADXL343_INT_SINGLE_TAP | ADXL343_INT_DOUBLE_TAP | ADXL343_INT_ACTIVITY |
+                               ADXL343_INT_INACTIVITY | ADXL343_INT_FREE_FALL);
+    // Trigger mode keeps the samples field of history once an event reaches the trigger pin
+    uint8_t trigger_map = (sim->registers[ADXL343_REG_FIFO_CTL] & 0x20) ? sim->registers[ADXL343_REG_INT_MAP]
+                                                                         : (uint8_t) ~sim->registers[ADXL343_REG_INT_MAP];
+    if (_sim_adxl343_fifo_mode(sim) == ADXL343_FIFO_MODE_TRIGGER && !sim->triggered &&
+        (sources & sim->registers[ADXL343_REG_INT_ENABLE] & trigger_map)){
+        sim->triggered = 1;
+        uint8_t keep = _sim_adxl343_fifo_samples(sim);
+        if (sim->entries > keep){
+            memmove(sim->fifo[0], sim->fifo[sim->entries - keep], keep * sizeof(sim->fifo[0]));
+            sim->entries = keep;
+        }
+    }
+}
+
+uint8_t sim_adxl343_int_source(const SimADXL343* sim){
+    uint8_t source = sim->latched;
+    uint8_t samples = _sim_adxl343_fifo_samples(sim);
+    if (sim->entries > 0){
+        source |= ADXL343_INT_DATA_READY;
+    }
+    if (_sim_adxl343_fifo_mode(sim) != ADXL343_FIFO_MODE_BYPASS && samples > 0 && sim->entries >= samples){
+        source |= ADXL343_INT_WATERMARK;
+    }
+    if (sim->overrun){
+        source |= ADXL343_INT_OVERRUN;
+    }
+    return source;
+}
+
+uint8_t sim_adxl343_int_pin(const SimADXL343* sim, uint8_t pin){
+    uint8_t active = sim_adxl343_int_source(sim) & sim->registers[ADXL343_REG_INT_ENABLE];
+    uint8_t routed = (pin == 2) ? sim->registers[ADXL343_REG_INT_MAP] : (uint8_t) ~sim->registers[ADXL343_REG_INT_MAP];
+    return (active & routed) ? 1 : 0;
+}
+
+uint64_t sim_adxl343_period_ns(const SimADXL343* sim){
+    // Rate code 0x0F is 3200 Hz, every step down halves the output data rate
+    uint8_t rate = sim->registers[ADXL343_REG_BW_RATE] & 0x0F;
+    return (1000000000ull << (15 - rate)) / 3200;
+}
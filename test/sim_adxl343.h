@@ -0,0 +1,55 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_adxl343.h
+/// \brief register accurate ADXL343 model answering the simulated i2c bus
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifndef TEST_SIM_ADXL343_H_
+#define TEST_SIM_ADXL343_H_
+
+#include <stdint.h>
+
+#include "sim_i2c_bus.h"
+
+#define SIM_ADXL343_DEVID 0xE5                  // Fixed device ID
+#define SIM_ADXL343_FIFO_ENTRIES 33             // 32 FIFO entries plus the data registers
+
+// Acceleration source, called once per output data sample with its simulated time
+typedef void (*SimADXL343Source)(void* context, uint64_t time_ns, int32_t mg[3]);
+
+typedef struct {
+    uint8_t registers[SIM_I2C_BUS_REGISTERS];
+    uint8_t fifo[SIM_ADXL343_FIFO_ENTRIES][6];  // Encoded samples, fifo[0] is shown in the data registers
+    uint8_t entries;
+    uint8_t output[6];                          // Data registers once the FIFO is empty
+    uint8_t latched;                            // Event sources, cleared by reading INT_SOURCE
+    uint8_t overrun;
+    uint8_t triggered;
+    uint8_t data_read;                          // Data registers read in the current transaction
+    uint64_t now_ns;
+    uint64_t next_sample_ns;
+    int32_t acceleration[3];                    // Constant acceleration in mg, used without source
+    SimADXL343Source source;
+    void* source_context;
+    uint32_t samples_generated;
+    uint32_t samples_lost;
+} SimADXL343;
+
+// Resets the model to the power-on register values and attaches it to the bus at the given address
+void sim_adxl343_attach(SimADXL343* sim, uint8_t address);
+// Same, on the chip select line of the simulated SPI bus
+void sim_adxl343_attach_spi(SimADXL343* sim);
+// Acceleration of the next samples, constant or from a source function
+void sim_adxl343_set_acceleration(SimADXL343* sim, int32_t x_mg, int32_t y_mg, int32_t z_mg);
+void sim_adxl343_set_source(SimADXL343* sim, SimADXL343Source source, void* context);
+// Generates the samples due up to the given simulated time (also done at every transaction start)
+void sim_adxl343_advance_to(SimADXL343* sim, uint64_t time_ns);
+// Flags event sources (tap, activity, inactivity, free-fall), an event on the trigger pin triggers the FIFO
+void sim_adxl343_raise_event(SimADXL343* sim, uint8_t sources);
+// Current INT_SOURCE value, without the read side effects
+uint8_t sim_adxl343_int_source(const SimADXL343* sim);
+// Level of the INT1 (pin 1) or INT2 (pin 2) output
+uint8_t sim_adxl343_int_pin(const SimADXL343* sim, uint8_t pin);
+// Output data rate period of the current BW_RATE setting
+uint64_t sim_adxl343_period_ns(const SimADXL343* sim);
+
+#endif /* TEST_SIM_ADXL343_H_ */
@@ -0,0 +1,33 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_i2c_backend.c
+/// \brief in-process i2c_driver backend running on the simulated bus
+// --------------------------------------------------------------------------------------------------------------------
+
+// The bus binds the mock names before i2c_driver.h is seen, so the backend forwards to the simulated bus
+#include "sim_i2c_bus.h"
+#include "sim_i2c_backend.h"
+
+
+// Statics
+static FunctionStatus _sim_i2c_backend_write(void* context, const char* dataToWrite, size_t length, uint32_t timeout){
+    ((SimI2CBackendCalls*) context)->writes++;
+    return mock_i2c_write(dataToWrite, length, timeout);
+}
+
+static FunctionStatus _sim_i2c_backend_read(void* context, char* dataToRead, size_t length, uint32_t timeout){
+    ((SimI2CBackendCalls*) context)->reads++;
+    return mock_i2c_read(dataToRead, length, timeout);
+}
+
+static FunctionStatus _sim_i2c_backend_write_read(void* context, const char* dataToWrite, size_t writeLength,
+                                                  char* dataToRead, size_t readLength, uint32_t timeout){
+    ((SimI2CBackendCalls*) context)->write_reads++;
+    return mock_i2c_write_read(dataToWrite, writeLength, dataToRead, readLength, timeout);
+}
+
+
+// Functions
+I2CBackend sim_i2c_backend(SimI2CBackendCalls* calls){
+    I2CBackend backend = {_sim_i2c_backend_write, _sim_i2c_backend_read, _sim_i2c_backend_write_read, calls};
+    return backend;
+}
@@ -0,0 +1,23 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_i2c_backend.h
+/// \brief in-process i2c_driver backend running on the simulated bus
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifndef TEST_SIM_I2C_BACKEND_H_
+#define TEST_SIM_I2C_BACKEND_H_
+
+#include <stdint.h>
+
+#include "i2c_driver.h"
+
+// Calls that reached the backend, passed as its context
+typedef struct {
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t write_reads;
+} SimI2CBackendCalls;
+
+// Backend forwarding to the simulated bus (and the device models attached to it), counting the calls
+I2CBackend sim_i2c_backend(SimI2CBackendCalls* calls);
+
+#endif /* TEST_SIM_I2C_BACKEND_H_ */
@@ -0,0 +1,220 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_i2c_bus.c
+/// \brief simulated i2c bus backing the i2c_driver mocks in the unittests
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "sim_i2c_bus.h"
+
+#include <string.h>
+
+
+// Statics
+static uint8_t sim_registers[SIM_I2C_BUS_ADDRESSES][SIM_I2C_BUS_REGISTERS];
+static uint8_t sim_register_pointer[SIM_I2C_BUS_ADDRESSES];
+static const SimI2CDevice* sim_devices[SIM_I2C_BUS_ADDRESSES];
+static void* sim_device_states[SIM_I2C_BUS_ADDRESSES];
+static uint8_t sim_last_address;
+static uint32_t sim_transactions;
+static uint32_t sim_bytes;
+static uint32_t sim_fail_count;
+static FunctionStatus sim_fail_status;
+static uint32_t sim_clock_hz = SIM_I2C_BUS_DEFAULT_CLOCK;
+static uint64_t sim_now_ns;
+static uint64_t sim_busy_ns;
+static SimI2CLogEntry sim_log[SIM_I2C_BUS_LOG_SIZE];
+static uint32_t sim_log_total;
+
+static SimI2CLogEntry* _sim_begin_transaction(uint8_t type, char address_byte, size_t write_length,
+                                              size_t read_length){
+    // Every byte is 8 bits plus the acknowledge, on top of the start and stop (and repeated start) conditions
+    size_t num_bytes = 1 + write_length + read_length + ((type == SIM_I2C_BUS_WRITE_READ) ? 1 : 0);
+    uint64_t bits = 9 * (uint64_t) num_bytes + 2 + ((type == SIM_I2C_BUS_WRITE_READ) ? 1 : 0);
+    SimI2CLogEntry* entry = &sim_log[sim_log_total % SIM_I2C_BUS_LOG_SIZE];
+    sim_log_total++;
+    sim_transactions++;
+    sim_bytes += num_bytes;
+    sim_last_address = ((uint8_t) address_byte >> 1) % SIM_I2C_BUS_ADDRESSES;
+
+    entry->type = type;
+    entry->address = sim_last_address;
+    entry->register_address = sim_register_pointer[sim_last_address];
+    entry->write_length = (uint16_t) write_length;
+    entry->read_length = (uint16_t) read_length;
+    entry->status = FUNCTION_STATUS_OK;
+    entry->start_ns = sim_now_ns;
+    entry->duration_ns = (bits * 1000000000ull) / sim_clock_hz;
+    sim_now_ns += entry->duration_ns;
+    sim_busy_ns += entry->duration_ns;
+
+    if (sim_fail_count > 0){
+        sim_fail_count--;
+        entry->status = sim_fail_status;
+    } else if (sim_devices[sim_last_address] != NULL && sim_devices[sim_last_address]->begin != NULL){
+        sim_devices[sim_last_address]->begin(sim_device_states[sim_last_address], entry->start_ns);
+    }
+    return entry;
+}
+
+static void _sim_end_transaction(){
+    if (sim_devices[sim_last_address] != NULL && sim_devices[sim_last_address]->end != NULL){
+        sim_devices[sim_last_address]->end(sim_device_states[sim_last_address]);
+    }
+}
+
+static void _sim_set_pointer(SimI2CLogEntry* entry, uint8_t register_address){
+    sim_register_pointer[sim_last_address] = register_address;
+    entry->register_address = register_address;
+}
+
+static void _sim_read_registers(uint8_t address, char* data, size_t length){
+    // Register pointer auto increments on multi-byte reads
+    for (size_t i = 0; i < length; i++){
+        uint8_t register_address = sim_register_pointer[address] % SIM_I2C_BUS_REGISTERS;
+        if (sim_devices[address] != NULL){
+            data[i] = (char) sim_devices[address]->read(sim_device_states[address], register_address);
+        } else {
+            data[i] = (char) sim_registers[address][register_address];
+        }
+        sim_register_pointer[address]++;
+    }
+}
+
+static void _sim_write_registers(uint8_t address, const char* data, size_t length){
+    // Register pointer auto increments on multi-byte writes
+    for (size_t i = 0; i < length; i++){
+        uint8_t register_address = sim_register_pointer[address] % SIM_I2C_BUS_REGISTERS;
+        if (sim_devices[address] != NULL){
+            sim_devices[address]->write(sim_device_states[address], register_address, (uint8_t) data[i]);
+        } else {
+            sim_registers[address][register_address] = (uint8_t) data[i];
+        }
+        sim_register_pointer[address]++;
+    }
+}
+
+
+// Functions
+void sim_i2c_bus_reset(){
+    memset(sim_registers, 0, sizeof(sim_registers));
+    memset(sim_register_pointer, 0, sizeof(sim_register_pointer));
+    memset(sim_devices, 0, sizeof(sim_devices));
+    memset(sim_device_states, 0, sizeof(sim_device_states));
+    sim_last_address = 0;
+    sim_transactions = 0;
+    sim_bytes = 0;
+    sim_fail_count = 0;
+    sim_fail_status = FUNCTION_STATUS_OK;
+    sim_clock_hz = SIM_I2C_BUS_DEFAULT_CLOCK;
+    sim_now_ns = 0;
+    sim_busy_ns = 0;
+    sim_log_total = 0;
+}
+
+void sim_i2c_bus_set_register(uint8_t register_address, uint8_t value){
+    sim_i2c_bus_set_device_register(SIM_I2C_BUS_DEFAULT_ADDRESS, register_address, value);
+}
+
+uint8_t sim_i2c_bus_get_register(uint8_t register_address){
+    return sim_i2c_bus_get_device_register(SIM_I2C_BUS_DEFAULT_ADDRESS, register_address);
+}
+
+void sim_i2c_bus_set_device_register(uint8_t address, uint8_t register_address, uint8_t value){
+    sim_registers[address % SIM_I2C_BUS_ADDRESSES][register_address % SIM_I2C_BUS_REGISTERS] = value;
+}
+
+uint8_t sim_i2c_bus_get_device_register(uint8_t address, uint8_t register_address){
+    return sim_registers[address % SIM_I2C_BUS_ADDRESSES][register_address % SIM_I2C_BUS_REGISTERS];
+}
+
+void sim_i2c_bus_attach(uint8_t address, const SimI2CDevice* device, void* state){
+    sim_devices[address % SIM_I2C_BUS_ADDRESSES] = device;
+    sim_device_states[address % SIM_I2C_BUS_ADDRESSES] = state;
+}
+
+void sim_i2c_bus_fail_next(uint32_t n, FunctionStatus status){
+    sim_fail_count = n;
+    sim_fail_status = status;
+}
+
+void sim_i2c_bus_set_clock(uint32_t hz){
+    if (hz == 0){return;}
+    sim_clock_hz = hz;
+}
+
+uint64_t sim_i2c_bus_now_ns(){
+    return sim_now_ns;
+}
+
+void sim_i2c_bus_advance_ns(uint64_t ns){
+    sim_now_ns += ns;
+}
+
+uint32_t sim_i2c_bus_transactions(){
+    return sim_transactions;
+}
+
+uint32_t sim_i2c_bus_bytes(){
+    return sim_bytes;
+}
+
+uint64_t sim_i2c_bus_time_ns(){
+    return sim_busy_ns;
+}
+
+uint8_t sim_i2c_bus_last_address(){
+    return sim_last_address;
+}
+
+uint32_t sim_i2c_bus_log_count(){
+    return (sim_log_total < SIM_I2C_BUS_LOG_SIZE) ? sim_log_total : SIM_I2C_BUS_LOG_SIZE;
+}
+
+const SimI2CLogEntry* sim_i2c_bus_log(uint32_t index){
+    if (index >= sim_i2c_bus_log_count()){return NULL;}
+    uint32_t oldest = sim_log_total - sim_i2c_bus_log_count();
+    return &sim_log[(oldest + index) % SIM_I2C_BUS_LOG_SIZE];
+}
+
+FunctionStatus mock_i2c_write(const char* dataToWrite, size_t length, uint32_t timeout){
+    (void) timeout;
+    if (dataToWrite == NULL || length == 0){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    SimI2CLogEntry* entry = _sim_begin_transaction(SIM_I2C_BUS_WRITE, dataToWrite[0], length - 1, 0);
+    if (entry->status != FUNCTION_STATUS_OK){return entry->status;}
+    // [device address, register address, data...]
+    if (length > 1){
+        _sim_set_pointer(entry, (uint8_t) dataToWrite[1]);
+    }
+    if (length > 2){
+        _sim_write_registers(sim_last_address, &dataToWrite[2], length - 2);
+    }
+    _sim_end_transaction();
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus mock_i2c_read(char* dataToRead, size_t length, uint32_t timeout){
+    (void) timeout;
+    if (dataToRead == NULL){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Read address byte followed by the data, from the device addressed last
+    SimI2CLogEntry* entry = _sim_begin_transaction(SIM_I2C_BUS_READ, (char) ((sim_last_address << 1) | 0x01), 0,
+                                                   length);
+    if (entry->status != FUNCTION_STATUS_OK){return entry->status;}
+    _sim_read_registers(sim_last_address, dataToRead, length);
+    _sim_end_transaction();
+    return FUNCTION_STATUS_OK;
+}
+
+FunctionStatus mock_i2c_write_read(const char* dataToWrite, size_t writeLength, char* dataToRead, size_t readLength,
+                                   uint32_t timeout){
+    (void) timeout;
+    if (dataToWrite == NULL || dataToRead == NULL || writeLength == 0){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // Write phase, repeated start with the read address, then the data
+    SimI2CLogEntry* entry = _sim_begin_transaction(SIM_I2C_BUS_WRITE_READ, dataToWrite[0], writeLength - 1,
+                                                   readLength);
+    if (entry->status != FUNCTION_STATUS_OK){return entry->status;}
+    if (writeLength > 1){
+        _sim_set_pointer(entry, (uint8_t) dataToWrite[1]);
+    }
+    _sim_read_registers(sim_last_address, dataToRead, readLength);
+    _sim_end_transaction();
+    return FUNCTION_STATUS_OK;
+}
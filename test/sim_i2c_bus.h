@@ -0,0 +1,79 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_i2c_bus.h
+/// \brief simulated i2c bus backing the i2c_driver mocks in the unittests
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifndef TEST_SIM_I2C_BUS_H_
+#define TEST_SIM_I2C_BUS_H_
+
+#ifdef UNITTEST
+#define i2c_write mock_i2c_write
+#define i2c_read mock_i2c_read
+#define i2c_write_read mock_i2c_write_read
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "i2c_driver.h"
+
+#define SIM_I2C_BUS_REGISTERS 0x40              // Registers modelled per device (0x00 - 0x3F)
+#define SIM_I2C_BUS_ADDRESSES 0x80              // Every 7 bit address has a register map
+#define SIM_I2C_BUS_DEFAULT_ADDRESS 0x53        // Device used by the address-less accessors
+#define SIM_I2C_BUS_DEFAULT_CLOCK 400000        // Fast mode, in Hz
+#define SIM_I2C_BUS_LOG_SIZE 1024               // Most recent transactions kept in the log
+
+// Transaction types in the log
+#define SIM_I2C_BUS_WRITE 0x00
+#define SIM_I2C_BUS_READ 0x01
+#define SIM_I2C_BUS_WRITE_READ 0x02
+
+// Device model answering the bus at an address, instead of the plain register map
+typedef struct {
+    // Start condition addressing the device, time is the simulated bus time in ns
+    void (*begin)(void* state, uint64_t time_ns);
+    uint8_t (*read)(void* state, uint8_t register_address);
+    void (*write)(void* state, uint8_t register_address, uint8_t value);
+    // Stop condition
+    void (*end)(void* state);
+} SimI2CDevice;
+
+// Logged transaction
+typedef struct {
+    uint8_t type;                               // SIM_I2C_BUS_WRITE, _READ or _WRITE_READ
+    uint8_t address;                            // 7 bit address
+    uint8_t register_address;                   // Register pointer at the start of the data phase
+    uint16_t write_length;                      // Data bytes written, excluding the address byte
+    uint16_t read_length;                       // Data bytes read, excluding the address byte
+    FunctionStatus status;
+    uint64_t start_ns;                          // Simulated time of the start condition
+    uint64_t duration_ns;                       // Time the bus was busy
+} SimI2CLogEntry;
+
+// Resets the register maps, register pointers, devices, clock, log and all counters
+void sim_i2c_bus_reset();
+// Direct register access that does not count as bus traffic (plain register maps only)
+void sim_i2c_bus_set_register(uint8_t register_address, uint8_t value);
+uint8_t sim_i2c_bus_get_register(uint8_t register_address);
+void sim_i2c_bus_set_device_register(uint8_t address, uint8_t register_address, uint8_t value);
+uint8_t sim_i2c_bus_get_device_register(uint8_t address, uint8_t register_address);
+// Lets a device model answer the bus at an address, NULL restores the plain register map
+void sim_i2c_bus_attach(uint8_t address, const SimI2CDevice* device, void* state);
+// Forces the next n transactions to fail with the given status
+void sim_i2c_bus_fail_next(uint32_t n, FunctionStatus status);
+// Bus clock in Hz (100000 or 400000), used for the bus time of every following transaction
+void sim_i2c_bus_set_clock(uint32_t hz);
+// Simulated time, advanced by bus transactions and by the application being idle
+uint64_t sim_i2c_bus_now_ns();
+void sim_i2c_bus_advance_ns(uint64_t ns);
+// Bus traffic counters, a transaction is everything between a start and a stop condition
+uint32_t sim_i2c_bus_transactions();
+uint32_t sim_i2c_bus_bytes();
+uint64_t sim_i2c_bus_time_ns();
+// 7 bit address of the most recent transaction
+uint8_t sim_i2c_bus_last_address();
+// Transaction log, index 0 is the oldest entry still kept
+uint32_t sim_i2c_bus_log_count();
+const SimI2CLogEntry* sim_i2c_bus_log(uint32_t index);
+
+#endif /* TEST_SIM_I2C_BUS_H_ */
@@ -0,0 +1,47 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_i2c_worker.c
+/// \brief host worker thread executing the i2c transaction queue against the simulated bus
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "sim_i2c_worker.h"
+#include "sim_i2c_bus.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+
+// Statics
+static pthread_t worker_thread;
+static atomic_bool worker_running;
+static _Atomic uint32_t worker_processed;
+
+static void* _sim_i2c_worker_main(void* argument){
+    (void) argument;
+    while (atomic_load(&worker_running)){
+        size_t processed = i2c_process();
+        if (processed == 0){
+            sched_yield();
+        }
+        atomic_fetch_add(&worker_processed, (uint32_t) processed);
+    }
+    atomic_fetch_add(&worker_processed, (uint32_t) i2c_process());
+    return NULL;
+}
+
+
+// Functions
+int sim_i2c_worker_start(){
+    atomic_store(&worker_processed, 0);
+    atomic_store(&worker_running, 1);
+    return pthread_create(&worker_thread, NULL, _sim_i2c_worker_main, NULL);
+}
+
+void sim_i2c_worker_stop(){
+    atomic_store(&worker_running, 0);
+    pthread_join(worker_thread, NULL);
+}
+
+uint32_t sim_i2c_worker_processed(){
+    return atomic_load(&worker_processed);
+}
@@ -0,0 +1,18 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_i2c_worker.h
+/// \brief host worker thread executing the i2c transaction queue against the simulated bus
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifndef TEST_SIM_I2C_WORKER_H_
+#define TEST_SIM_I2C_WORKER_H_
+
+#include <stdint.h>
+
+// Starts a thread that runs i2c_process until stopped, the simulated bus must not be touched meanwhile
+int sim_i2c_worker_start();
+// Stops the thread after it has executed everything queued so far
+void sim_i2c_worker_stop();
+// Transactions executed by the worker since it was started
+uint32_t sim_i2c_worker_processed();
+
+#endif /* TEST_SIM_I2C_WORKER_H_ */
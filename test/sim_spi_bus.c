@@ -0,0 +1,102 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_spi_bus.c
+/// \brief simulated 4-wire SPI bus backing the spi_driver mock in the unittests
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "sim_spi_bus.h"
+
+
+// Statics
+static const SimI2CDevice* sim_spi_device;
+static void* sim_spi_device_state;
+static uint32_t sim_spi_transactions;
+static uint32_t sim_spi_bytes;
+static uint32_t sim_spi_fail_count;
+static FunctionStatus sim_spi_fail_status;
+static uint32_t sim_spi_clock_hz = SIM_SPI_BUS_DEFAULT_CLOCK;
+static uint64_t sim_spi_busy_ns;
+
+
+// Functions
+void sim_spi_bus_reset(){
+    sim_spi_device = NULL;
+    sim_spi_device_state = NULL;
+    sim_spi_transactions = 0;
+    sim_spi_bytes = 0;
+    sim_spi_fail_count = 0;
+    sim_spi_fail_status = FUNCTION_STATUS_OK;
+    sim_spi_clock_hz = SIM_SPI_BUS_DEFAULT_CLOCK;
+    sim_spi_busy_ns = 0;
+}
+
+void sim_spi_bus_attach(const SimI2CDevice* device, void* state){
+    sim_spi_device = device;
+    sim_spi_device_state = state;
+}
+
+void sim_spi_bus_fail_next(uint32_t n, FunctionStatus status){
+    sim_spi_fail_count = n;
+    sim_spi_fail_status = status;
+}
+
+void sim_spi_bus_set_clock(uint32_t hz){
+    if (hz == 0){return;}
+    sim_spi_clock_hz = hz;
+}
+
+uint32_t sim_spi_bus_transactions(){
+    return sim_spi_transactions;
+}
+
+uint32_t sim_spi_bus_bytes(){
+    return sim_spi_bytes;
+}
+
+uint64_t sim_spi_bus_time_ns(){
+    return sim_spi_busy_ns;
+}
+
+FunctionStatus mock_spi_transfer(const char* dataToWrite, char* dataToRead, size_t length, uint32_t timeout){
+    (void) timeout;
+    if (dataToWrite == NULL || length == 0){return FUNCTION_STATUS_ARGUMENT_ERROR;}
+    // 8 clocks per byte, chip select setup and hold are not modelled
+    uint64_t start_ns = sim_i2c_bus_now_ns();
+    uint64_t duration_ns = (8 * (uint64_t) length * 1000000000ull) / sim_spi_clock_hz;
+    sim_i2c_bus_advance_ns(duration_ns);
+    sim_spi_busy_ns += duration_ns;
+    sim_spi_transactions++;
+    sim_spi_bytes += length;
+    if (sim_spi_fail_count > 0){
+        sim_spi_fail_count--;
+        return sim_spi_fail_status;
+    }
+    if (sim_spi_device == NULL){return FUNCTION_STATUS_OK;}
+
+    // [R/W | MB | register address] then one data byte per register, the address only increments with MB set
+    uint8_t command = (uint8_t) dataToWrite[0];
+    uint8_t register_address = command & 0x3F;
+    if (sim_spi_device->begin != NULL){
+        sim_spi_device->begin(sim_spi_device_state, start_ns);
+    }
+    if (dataToRead != NULL){
+        dataToRead[0] = (char) 0xFF;
+    }
+    for (size_t i = 1; i < length; i++){
+        if (command & SIM_SPI_BUS_READ){
+            uint8_t value = sim_spi_device->read(sim_spi_device_state, register_address);
+            if (dataToRead != NULL){
+                dataToRead[i] = (char) value;
+            }
+        } else {
+            sim_spi_device->write(sim_spi_device_state, register_address, (uint8_t) dataToWrite[i]);
+        }
+        if (command & SIM_SPI_BUS_MULTI_BYTE){
+            register_address = (register_address + 1) % SIM_I2C_BUS_REGISTERS;
+        }
+    }
+    if (sim_spi_device->end != NULL){
+        sim_spi_device->end(sim_spi_device_state);
+    }
+
+    return FUNCTION_STATUS_OK;
+}
@@ -0,0 +1,36 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  sim_spi_bus.h
+/// \brief simulated 4-wire SPI bus backing the spi_driver mock in the unittests
+// --------------------------------------------------------------------------------------------------------------------
+
+#ifndef TEST_SIM_SPI_BUS_H_
+#define TEST_SIM_SPI_BUS_H_
+
+#ifdef UNITTEST
+#define spi_transfer mock_spi_transfer
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "spi_driver.h"
+#include "sim_i2c_bus.h"
+
+#define SIM_SPI_BUS_DEFAULT_CLOCK 5000000       // ADXL343 maximum SCLK, in Hz
+#define SIM_SPI_BUS_READ 0x80                   // R/W bit of the command byte
+#define SIM_SPI_BUS_MULTI_BYTE 0x40             // MB bit of the command byte
+
+// Resets the attached device, clock and counters
+void sim_spi_bus_reset();
+// Lets a device model (same interface as on the i2c bus) answer the transfers on the chip select line
+void sim_spi_bus_attach(const SimI2CDevice* device, void* state);
+// Forces the next n transfers to fail with the given status
+void sim_spi_bus_fail_next(uint32_t n, FunctionStatus status);
+// SCLK in Hz, transfers advance the simulated time shared with the i2c bus (sim_i2c_bus_now_ns)
+void sim_spi_bus_set_clock(uint32_t hz);
+// Bus traffic counters, a transaction is one chip select cycle, bytes include the command byte
+uint32_t sim_spi_bus_transactions();
+uint32_t sim_spi_bus_bytes();
+uint64_t sim_spi_bus_time_ns();
+
+#endif /* TEST_SIM_SPI_BUS_H_ */
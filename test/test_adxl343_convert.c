@@ -0,0 +1,75 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  test_adxl343_convert.c
+/// \brief unittester for adxl343_convert
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_convert.h"
+#include "unity.h"
+
+
+void setUp(void){}
+
+// Test cases
+void test_adxl343_convert_mg_noerror(){
+    // 1g at 10 bit +-2g, -1g at 10 bit +-16g and full resolution, odd count to cover the remainder path
+    ADXL343Settings settings = {0};
+    ADXL343Sample samples [5] = {{256, -256, 0}, {1, -1, 511}, {0, 0, 0}, {0, 0, 0}, {-512, 100, 7}};
+    int32_t mg [15];
+    adxl343_convert_mg(&settings, samples, mg, 5);
+    TEST_ASSERT_EQUAL_INT32(1000, mg[0]);
+    TEST_ASSERT_EQUAL_INT32(-1000, mg[1]);
+    TEST_ASSERT_EQUAL_INT32(4, mg[3]);
+    TEST_ASSERT_EQUAL_INT32(-4, mg[4]);
+    TEST_ASSERT_EQUAL_INT32(-2000, mg[12]);
+    TEST_ASSERT_EQUAL_INT32(27, mg[14]);
+
+    settings.range = 0x03;
+    adxl343_convert_mg(&settings, samples, mg, 5);
+    TEST_ASSERT_EQUAL_INT32(8000, mg[0]);
+    settings.resolution = 0x01;
+    adxl343_convert_mg(&settings, samples, mg, 5);
+    TEST_ASSERT_EQUAL_INT32(1000, mg[0]);
+}
+
+void test_adxl343_convert_mg_negative(){
+    // 3.906 mg per LSB: +-1 is +-3.9, +-16 is exactly +-62.5, a negative value is the negative of the positive one
+    // in the SIMD head (first 8 values) and in the remainder
+    ADXL343Settings settings = {0};
+    ADXL343Sample samples [4] = {{-1, 1, -16}, {16, -3, 3}, {-1, 1, -16}, {16, -3, 3}};
+    int32_t mg [12];
+    adxl343_convert_mg(&settings, samples, mg, 4);
+    for (size_t i = 0; i < 12; i += 6){
+        TEST_ASSERT_EQUAL_INT32(-4, mg[i]);
+        TEST_ASSERT_EQUAL_INT32(4, mg[i + 1]);
+        TEST_ASSERT_EQUAL_INT32(-63, mg[i + 2]);
+        TEST_ASSERT_EQUAL_INT32(63, mg[i + 3]);
+        TEST_ASSERT_EQUAL_INT32(-12, mg[i + 4]);
+        TEST_ASSERT_EQUAL_INT32(12, mg[i + 5]);
+    }
+}
+
+void test_adxl343_convert_ms2_noerror(){
+    ADXL343Settings settings = {0};
+    ADXL343Sample samples [3] = {{256, -256, 128}, {0, 0, 0}, {0, 0, -256}};
+    float ms2 [9];
+    settings.range = 0x01;
+    adxl343_convert_ms2(&settings, samples, ms2, 3);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.0f * ADXL343_STANDARD_GRAVITY, ms2[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -2.0f * ADXL343_STANDARD_GRAVITY, ms2[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, ADXL343_STANDARD_GRAVITY, ms2[2]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -2.0f * ADXL343_STANDARD_GRAVITY, ms2[8]);
+}
+
+void tearDown(void){
+
+}
+
+int main(void){
+    UNITY_BEGIN();
+
+    RUN_TEST(test_adxl343_convert_mg_noerror);
+    RUN_TEST(test_adxl343_convert_mg_negative);
+    RUN_TEST(test_adxl343_convert_ms2_noerror);
+
+    return UNITY_END();
+}
@@ -4,34 +4,33 @@
 // --------------------------------------------------------------------------------------------------------------------
 
 
-#ifdef UNITTEST
-#define i2c_write mock_i2c_write
-#define i2c_read mock_i2c_read
-#endif
-
 #include <stdio.h>
 
+#include "sim_i2c_bus.h"
+#include "sim_adxl343.h"
 #include "adxl343_driver.h"
+#include "adxl343_ring.h"
 #include "FunctionStatus.h"
 #include "unity.h"
 
-// Mocks
-FunctionStatus mock_i2c_write(const char* dataToWrite, size_t length, uint32_t timeout){
-    return FUNCTION_STATUS_OK;
-}
-FunctionStatus mock_i2c_read(char* dataToRead, size_t length, uint32_t timeout) {
-    dataToRead[0] = (uint8_t) 0xEA;
-    dataToRead[1] = (uint8_t) 0x1D;
-    return FUNCTION_STATUS_OK;
-}
 
+// Statics
+static ADXL343Device device;
 
-void setUp(void){}
+void setUp(void){
+    // Simulated bus, every axis reads back 0x1DEA
+    sim_i2c_bus_reset();
+    for (uint8_t reg = ADXL343_DATA_X_0; reg <= ADXL343_DATA_Z_1; reg += 2){
+        sim_i2c_bus_set_register(reg, 0xEA);
+        sim_i2c_bus_set_register(reg + 1, 0x1D);
+    }
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+}
 
 // Test cases
 void test_adxl343_init_noerror(){
-    FunctionStatus result = adxl343_init();
-    ADXL343Settings settings = adxl343_get_settings();
+    FunctionStatus result = adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    ADXL343Settings settings = adxl343_get_settings(&device);
     
     TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
     TEST_ASSERT_EQUAL(settings.measurement_mode, 0x00);
@@ -41,22 +40,835 @@ void test_adxl343_init_noerror(){
     TEST_ASSERT_EQUAL(settings.bit_order, ADXL343_DEFAULT_BITORDER);
 }
 
-void test_adxl343_init_error(){
-}
-
 void test_adxl343_get_X_axis_noerror(){
     char x_axis_buffer [2] = {0, 0};
-    FunctionStatus result = adxl343_get_X_axis(x_axis_buffer);
+    FunctionStatus result = adxl343_get_X_axis(&device, x_axis_buffer);
     TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
     TEST_ASSERT_EQUAL((uint8_t) x_axis_buffer[0], 0b11101010);
     TEST_ASSERT_EQUAL((uint8_t) x_axis_buffer[1], 0b01);
-    result = adxl343_set_bit_order(0x01);
+    result = adxl343_set_bit_order(&device, 0x01);
     TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
-    result = adxl343_get_X_axis(x_axis_buffer);
+    result = adxl343_get_X_axis(&device, x_axis_buffer);
     TEST_ASSERT_EQUAL((uint8_t) x_axis_buffer[0], 0b01110111);
     TEST_ASSERT_EQUAL((uint8_t) x_axis_buffer[1], 0b00000000);
 }
 
+void test_adxl343_set_fifo_mode_noerror(){
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    FunctionStatus result = adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_STREAM, 16, ADXL343_FIFO_TRIGGER_INT1);
+    ADXL343Settings settings = adxl343_get_settings(&device);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(settings.fifo_mode, ADXL343_FIFO_MODE_STREAM);
+    TEST_ASSERT_EQUAL(settings.fifo_samples, 16);
+}
+
+void test_adxl343_set_fifo_mode_error(){
+    TEST_ASSERT_EQUAL(adxl343_set_fifo_mode(&device, 0x04, 0, 0), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_FIFO, 32, 0), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_FIFO, 0, 2), FUNCTION_STATUS_BOUNDARY_ERROR);
+}
+
+void test_adxl343_read_fifo_noerror(){
+    ADXL343Sample samples [4];
+    size_t count = 0;
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    // More entries are waiting than fit in the buffer
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 10);
+    FunctionStatus result = adxl343_read_fifo(&device, samples, 4, &count);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, 4);
+    TEST_ASSERT_EQUAL(samples[0].x, 0x1EA);
+    TEST_ASSERT_EQUAL(samples[3].z, 0x1EA);
+    // Left justified 10 bit data is shifted down and sign extended
+    adxl343_set_bit_order(&device, 0x01);
+    result = adxl343_read_fifo(&device, samples, 1, &count);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, 1);
+    TEST_ASSERT_EQUAL(samples[0].y, 0x77);
+}
+
+void test_adxl343_read_fifo_error(){
+    size_t count;
+    ADXL343Sample sample;
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, NULL, 1, &count), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, &sample, 1, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_drain_fifo_to_ring_noerror(){
+    ADXL343Sample storage [4];
+    ADXL343Ring ring;
+    const ADXL343Sample* span;
+    size_t length;
+    size_t count;
+    uint32_t dropped;
+    adxl343_ring_init(&ring, storage, 4);
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 3);
+    FunctionStatus result = adxl343_drain_fifo_to_ring(&device, &ring, &count);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, 3);
+    adxl343_ring_peek(&ring, &span, &length);
+    TEST_ASSERT_EQUAL(length, 3);
+    TEST_ASSERT_EQUAL(span[2].z, 0x1EA);
+    adxl343_ring_consume(&ring, 2);
+    // Three more wrap around the ring, the fourth does not fit but is still popped from the device
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 4);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    result = adxl343_drain_fifo_to_ring(&device, &ring, &count);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(count, 3);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions + 5);
+    TEST_ASSERT_EQUAL(adxl343_ring_size(&ring), 4);
+    adxl343_ring_get_counters(&ring, &dropped, NULL);
+    TEST_ASSERT_EQUAL(dropped, 1);
+}
+
+void test_adxl343_drain_fifo_to_ring_error(){
+    ADXL343Sample storage [4];
+    ADXL343Ring ring;
+    size_t count;
+    adxl343_ring_init(&ring, storage, 4);
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 3);
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    FunctionStatus result = adxl343_drain_fifo_to_ring(&device, &ring, &count);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(count, 0);
+    TEST_ASSERT_EQUAL(adxl343_ring_size(&ring), 0);
+    result = adxl343_drain_fifo_to_ring(&device, NULL, &count);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+static uint32_t async_calls;
+static FunctionStatus async_status;
+static size_t async_count;
+
+static void record_async(ADXL343Device* dev, FunctionStatus status, size_t count, void* context){
+    TEST_ASSERT_EQUAL_PTR(dev, &device);
+    TEST_ASSERT_EQUAL_PTR(context, &async_calls);
+    async_calls++;
+    async_status = status;
+    async_count = count;
+}
+
+void test_adxl343_drain_fifo_async_noerror(){
+    static ADXL343AsyncOp op;
+    ADXL343Sample samples [8];
+    async_calls = 0;
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 5);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    FunctionStatus result = adxl343_drain_fifo_async(&device, &op, samples, 4, record_async, &async_calls);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(op.status, FUNCTION_STATUS_PENDING);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions);
+    // Status read first, its completion queues one read per entry (capped by the buffer)
+    TEST_ASSERT_EQUAL(i2c_process(), 1);
+    TEST_ASSERT_EQUAL(i2c_poll(), 1);
+    TEST_ASSERT_EQUAL(async_calls, 0);
+    TEST_ASSERT_EQUAL(i2c_process(), 4);
+    TEST_ASSERT_EQUAL(i2c_poll(), 4);
+    TEST_ASSERT_EQUAL(async_calls, 1);
+    TEST_ASSERT_EQUAL(async_status, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(async_count, 4);
+    TEST_ASSERT_EQUAL(op.status, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions + 5);
+    TEST_ASSERT_EQUAL(samples[3].y, 0x1EA);
+    // The entry left behind is reported
+    TEST_ASSERT_EQUAL(op.available, 5);
+    TEST_ASSERT_EQUAL(op.scheduled, 4);
+    // More entries than one operation can queue, the rest is left for the next drain
+    static ADXL343Sample many [64];
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 0x3F);
+    TEST_ASSERT_EQUAL(adxl343_drain_fifo_async(&device, &op, many, 64, record_async, &async_calls), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(i2c_process(), 1);
+    TEST_ASSERT_EQUAL(i2c_poll(), 1);
+    TEST_ASSERT_EQUAL(op.available, 0x3F);
+    TEST_ASSERT_EQUAL(op.scheduled, ADXL343_ASYNC_TRANSACTIONS - 1);
+    TEST_ASSERT_EQUAL(i2c_process(), ADXL343_ASYNC_TRANSACTIONS - 1);
+    TEST_ASSERT_EQUAL(i2c_poll(), ADXL343_ASYNC_TRANSACTIONS - 1);
+    TEST_ASSERT_EQUAL(async_count, ADXL343_ASYNC_TRANSACTIONS - 1);
+}
+
+void test_adxl343_drain_fifo_async_error(){
+    static ADXL343AsyncOp op;
+    ADXL343Sample samples [8];
+    ADXL343Bus blocking_only = adxl343_i2c_bus;
+    async_calls = 0;
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 3);
+    FunctionStatus result = adxl343_drain_fifo_async(&device, &op, samples, 8, record_async, &async_calls);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    i2c_process();
+    i2c_poll();
+    // First entry fails, the entries after it are out of order and not handed out
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    i2c_process();
+    i2c_poll();
+    TEST_ASSERT_EQUAL(async_calls, 1);
+    TEST_ASSERT_EQUAL(async_status, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(async_count, 0);
+    // A failing status read ends the drain
+    async_calls = 0;
+    adxl343_drain_fifo_async(&device, &op, samples, 8, record_async, &async_calls);
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(i2c_process(), 1);
+    i2c_poll();
+    TEST_ASSERT_EQUAL(i2c_process(), 0);
+    TEST_ASSERT_EQUAL(async_calls, 1);
+    TEST_ASSERT_EQUAL(async_status, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(async_count, 0);
+    // Buses without a transaction queue can not run asynchronous operations
+    blocking_only.submit = NULL;
+    device.bus = &blocking_only;
+    result = adxl343_drain_fifo_async(&device, &op, samples, 8, record_async, &async_calls);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_ERROR);
+    result = adxl343_drain_fifo_async(&device, NULL, samples, 8, record_async, &async_calls);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_apply_config_async_noerror(){
+    static ADXL343AsyncOp op;
+    ADXL343Config config;
+    async_calls = 0;
+    adxl343_snapshot_config(&device, &config);
+    config.thresh_tap = 0x30;
+    config.ofsy = 0x10;
+    config.data_format = 0x0B;
+    uint32_t transactions = sim_i2c_bus_transactions();
+    FunctionStatus result = adxl343_apply_config_async(&device, &op, &config, record_async, &async_calls);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions);
+    // Same bursts as the blocking version, the shadow follows on completion
+    TEST_ASSERT_EQUAL(i2c_process(), 2);
+    TEST_ASSERT_EQUAL(device.settings.range, 0x00);
+    i2c_poll();
+    TEST_ASSERT_EQUAL(async_calls, 1);
+    TEST_ASSERT_EQUAL(async_status, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(async_count, 2);
+    TEST_ASSERT_EQUAL_HEX8(sim_i2c_bus_get_register(ADXL343_REG_OFSY), 0x10);
+    TEST_ASSERT_EQUAL_HEX8(sim_i2c_bus_get_register(ADXL343_REG_DATA_FORMAT), 0x0B);
+    TEST_ASSERT_EQUAL_HEX8(device.shadow[ADXL343_REG_THRESH_TAP], 0x30);
+    TEST_ASSERT_EQUAL(device.settings.range, 0x03);
+    TEST_ASSERT_EQUAL(device.settings.resolution, 0x01);
+    // Nothing left to write completes straight away
+    async_calls = 0;
+    result = adxl343_apply_config_async(&device, &op, &config, record_async, &async_calls);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(async_calls, 1);
+    TEST_ASSERT_EQUAL(async_count, 0);
+    TEST_ASSERT_EQUAL(i2c_process(), 0);
+    // A failed burst leaves the shadow stale
+    config.ofsx = 0x05;
+    adxl343_apply_config_async(&device, &op, &config, record_async, &async_calls);
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    i2c_process();
+    i2c_poll();
+    TEST_ASSERT_EQUAL(async_status, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(device.shadow_valid, 0x00);
+}
+
+static uint8_t interrupt_order [ADXL343_INT_COUNT];
+static uint8_t interrupt_calls;
+
+static void record_interrupt(ADXL343Device* dev, uint8_t source, void* context){
+    TEST_ASSERT_EQUAL_PTR(dev, &device);
+    TEST_ASSERT_EQUAL_PTR(context, &interrupt_calls);
+    interrupt_order[interrupt_calls++] = source;
+}
+
+static size_t bus_tick(){
+    // One bus turn between steps: execute what is queued and hand the completions back
+    size_t processed = i2c_process();
+    i2c_poll();
+    return processed;
+}
+
+void test_adxl343_step_drain_fifo_noerror(){
+    static ADXL343Machine machine;
+    ADXL343Sample samples [8];
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 3);
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_NOT_INITIALIZED);
+    TEST_ASSERT_EQUAL(adxl343_begin_drain_fifo(&device, &machine, samples, 8), FUNCTION_STATUS_OK);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    // Status read, then one entry per step, never more than one transaction in flight
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_PENDING);
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_PENDING);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions);
+    for (size_t i = 0; i < 3; i++){
+        TEST_ASSERT_EQUAL(bus_tick(), 1);
+        TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_PENDING);
+        TEST_ASSERT_EQUAL(machine.count, i);
+    }
+    TEST_ASSERT_EQUAL(machine.entries, 3);
+    TEST_ASSERT_EQUAL(bus_tick(), 1);
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(bus_tick(), 0);
+    TEST_ASSERT_EQUAL(machine.count, 3);
+    TEST_ASSERT_EQUAL(samples[2].y, 0x1EA);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions + 4);
+    // Capped by the buffer, an empty FIFO finishes after the status read
+    adxl343_begin_drain_fifo(&device, &machine, samples, 1);
+    while (adxl343_step(&machine) == FUNCTION_STATUS_PENDING){
+        bus_tick();
+    }
+    TEST_ASSERT_EQUAL(machine.count, 1);
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 0);
+    adxl343_begin_drain_fifo(&device, &machine, samples, 8);
+    adxl343_step(&machine);
+    bus_tick();
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(machine.count, 0);
+}
+
+void test_adxl343_step_apply_config_noerror(){
+    static ADXL343Machine machine;
+    ADXL343Config config;
+    adxl343_snapshot_config(&device, &config);
+    config.thresh_tap = 0x30;
+    config.ofsy = 0x10;
+    config.data_format = 0x0B;
+    TEST_ASSERT_EQUAL(adxl343_begin_apply_config(&device, &machine, &config), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(machine.num_bursts, 2);
+    // One burst per step, the shadow follows each one
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_PENDING);
+    TEST_ASSERT_EQUAL(bus_tick(), 1);
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_PENDING);
+    TEST_ASSERT_EQUAL_HEX8(device.shadow[ADXL343_REG_OFSY], 0x10);
+    TEST_ASSERT_EQUAL(device.settings.range, 0x00);
+    TEST_ASSERT_EQUAL(bus_tick(), 1);
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(sim_i2c_bus_get_register(ADXL343_REG_DATA_FORMAT), 0x0B);
+    TEST_ASSERT_EQUAL(device.settings.range, 0x03);
+    TEST_ASSERT_EQUAL(device.shadow_valid, 0x01);
+    // Nothing left to write is finished before the first step
+    adxl343_begin_apply_config(&device, &machine, &config);
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(bus_tick(), 0);
+}
+
+void test_adxl343_step_error(){
+    static ADXL343Machine machine;
+    ADXL343Sample samples [8];
+    ADXL343Config config;
+    ADXL343Bus blocking_only = adxl343_i2c_bus;
+    // A failed entry ends the drain with its status, the samples before it are kept
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 3);
+    adxl343_begin_drain_fifo(&device, &machine, samples, 8);
+    adxl343_step(&machine);
+    bus_tick();
+    adxl343_step(&machine);
+    bus_tick();
+    adxl343_step(&machine);
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    bus_tick();
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(machine.count, 1);
+    // A failed burst leaves the shadow stale
+    adxl343_snapshot_config(&device, &config);
+    config.ofsx = 0x05;
+    adxl343_begin_apply_config(&device, &machine, &config);
+    adxl343_step(&machine);
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_ERROR);
+    bus_tick();
+    TEST_ASSERT_EQUAL(adxl343_step(&machine), FUNCTION_STATUS_ERROR);
+    TEST_ASSERT_EQUAL(device.shadow_valid, 0x00);
+    // Needs the transaction queue
+    blocking_only.submit = NULL;
+    device.bus = &blocking_only;
+    TEST_ASSERT_EQUAL(adxl343_begin_drain_fifo(&device, &machine, samples, 8), FUNCTION_STATUS_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_begin_apply_config(&device, &machine, &config), FUNCTION_STATUS_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_begin_drain_fifo(NULL, &machine, samples, 8), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_step(NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_set_interrupts_noerror(){
+    uint32_t transactions = sim_i2c_bus_transactions();
+    FunctionStatus result = adxl343_set_interrupts(&device, ADXL343_INT_DATA_READY | ADXL343_INT_WATERMARK,
+                                                   ADXL343_INT_WATERMARK);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions + 1);
+    TEST_ASSERT_EQUAL_HEX8(sim_i2c_bus_get_register(ADXL343_REG_INT_ENABLE), 0x82);
+    TEST_ASSERT_EQUAL_HEX8(sim_i2c_bus_get_register(ADXL343_REG_INT_MAP), 0x02);
+    // Unchanged configuration does not touch the bus
+    result = adxl343_set_interrupts(&device, ADXL343_INT_DATA_READY | ADXL343_INT_WATERMARK, ADXL343_INT_WATERMARK);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions + 1);
+    result = adxl343_set_interrupts(NULL, 0, 0);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_on_interrupt_noerror(){
+    static SimADXL343 sim;
+    sim_adxl343_attach(&sim, ADXL343_ADDRESS_I2C);
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    interrupt_calls = 0;
+    adxl343_set_interrupts(&device, ADXL343_INT_DATA_READY | ADXL343_INT_WATERMARK | ADXL343_INT_OVERRUN,
+                           ADXL343_INT_WATERMARK);
+    adxl343_set_interrupt_callback(&device, ADXL343_INT_DATA_READY | ADXL343_INT_WATERMARK | ADXL343_INT_OVERRUN,
+                                   record_interrupt, &interrupt_calls);
+    adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_STREAM, 16, ADXL343_FIFO_TRIGGER_INT1);
+    adxl343_start(&device);
+    // Watermark is routed to INT2, data ready stays on INT1
+    TEST_ASSERT_EQUAL(sim_adxl343_int_pin(&sim, 1), 0);
+    sim_i2c_bus_advance_ns(16 * sim_adxl343_period_ns(&sim));
+    sim_adxl343_advance_to(&sim, sim_i2c_bus_now_ns());
+    TEST_ASSERT_EQUAL(sim_adxl343_int_pin(&sim, 1), 1);
+    TEST_ASSERT_EQUAL(sim_adxl343_int_pin(&sim, 2), 1);
+    // Samples lost to the full FIFO flag an overrun, events that are not enabled are not dispatched
+    sim_i2c_bus_advance_ns(32 * sim_adxl343_period_ns(&sim));
+    sim_adxl343_raise_event(&sim, ADXL343_INT_SINGLE_TAP);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    FunctionStatus result = adxl343_on_interrupt(&device);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions + 1);
+    TEST_ASSERT_EQUAL(interrupt_calls, 3);
+    TEST_ASSERT_EQUAL_HEX8(interrupt_order[0], ADXL343_INT_OVERRUN);
+    TEST_ASSERT_EQUAL_HEX8(interrupt_order[1], ADXL343_INT_WATERMARK);
+    TEST_ASSERT_EQUAL_HEX8(interrupt_order[2], ADXL343_INT_DATA_READY);
+    // Reading INT_SOURCE clears the latched event
+    TEST_ASSERT_EQUAL_HEX8(sim_adxl343_int_source(&sim) & ADXL343_INT_SINGLE_TAP, 0);
+    // Removed callbacks are not called anymore
+    adxl343_set_interrupt_callback(&device, ADXL343_INT_DATA_READY | ADXL343_INT_WATERMARK | ADXL343_INT_OVERRUN,
+                                   NULL, NULL);
+    interrupt_calls = 0;
+    result = adxl343_on_interrupt(&device);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(interrupt_calls, 0);
+}
+
+void test_adxl343_on_interrupt_error(){
+    interrupt_calls = 0;
+    adxl343_set_interrupts(&device, ADXL343_INT_DATA_READY, ADXL343_INT_MAP_INT1);
+    adxl343_set_interrupt_callback(&device, ADXL343_INT_DATA_READY, record_interrupt, &interrupt_calls);
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    FunctionStatus result = adxl343_on_interrupt(&device);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(interrupt_calls, 0);
+    result = adxl343_on_interrupt(NULL);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_ARGUMENT_ERROR);
+    result = adxl343_set_interrupt_callback(NULL, ADXL343_INT_DATA_READY, record_interrupt, NULL);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_event_config_noerror(){
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    const ADXL343TapConfig tap = {3000, 10000, 20000, 250000, ADXL343_AXIS_Z, 1};
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_set_tap_config(&device, &tap), FUNCTION_STATUS_OK);
+    // THRESH_TAP, DUR to WINDOW and TAP_AXES, the offsets and activity registers in between are left alone
+    TEST_ASSERT_EQUAL(3, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL_HEX8(0x30, sim_i2c_bus_get_register(ADXL343_REG_THRESH_TAP));
+    TEST_ASSERT_EQUAL_HEX8(0x10, sim_i2c_bus_get_register(ADXL343_REG_DUR));
+    TEST_ASSERT_EQUAL_HEX8(0x10, sim_i2c_bus_get_register(ADXL343_REG_LATENT));
+    TEST_ASSERT_EQUAL_HEX8(0xC8, sim_i2c_bus_get_register(ADXL343_REG_WINDOW));
+    TEST_ASSERT_EQUAL_HEX8(0x09, sim_i2c_bus_get_register(ADXL343_REG_TAP_AXES));
+    // Activity and inactivity share ACT_INACT_CTL, each keeps the other half
+    const ADXL343ActivityConfig activity = {250, ADXL343_AXIS_ALL, 1};
+    const ADXL343InactivityConfig inactivity = {187, 5, ADXL343_AXIS_X | ADXL343_AXIS_Y, 0};
+    TEST_ASSERT_EQUAL(adxl343_set_activity_config(&device, &activity), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_set_inactivity_config(&device, &inactivity), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x04, sim_i2c_bus_get_register(ADXL343_REG_THRESH_ACT));
+    TEST_ASSERT_EQUAL_HEX8(0x03, sim_i2c_bus_get_register(ADXL343_REG_THRESH_INACT));
+    TEST_ASSERT_EQUAL_HEX8(0x05, sim_i2c_bus_get_register(ADXL343_REG_TIME_INACT));
+    TEST_ASSERT_EQUAL_HEX8(0xF6, sim_i2c_bus_get_register(ADXL343_REG_ACT_INACT_CTL));
+    // Out of range values saturate
+    const ADXL343FreeFallConfig free_fall = {437, 200};
+    const ADXL343FreeFallConfig saturated = {20000, 5000};
+    TEST_ASSERT_EQUAL(adxl343_set_free_fall_config(&device, &free_fall), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x07, sim_i2c_bus_get_register(ADXL343_REG_THRESH_FF));
+    TEST_ASSERT_EQUAL_HEX8(0x28, sim_i2c_bus_get_register(ADXL343_REG_TIME_FF));
+    TEST_ASSERT_EQUAL(adxl343_set_free_fall_config(&device, &saturated), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, sim_i2c_bus_get_register(ADXL343_REG_THRESH_FF));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, sim_i2c_bus_get_register(ADXL343_REG_TIME_FF));
+    // Unchanged settings cost nothing
+    transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_set_tap_config(&device, &tap), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(0, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL(adxl343_set_tap_config(&device, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_set_free_fall_config(NULL, &free_fall), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_on_interrupt_event_status(){
+    static SimADXL343 sim;
+    ADXL343EventStatus status;
+    sim_adxl343_attach(&sim, ADXL343_ADDRESS_I2C);
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    interrupt_calls = 0;
+    adxl343_set_interrupts(&device, ADXL343_INT_SINGLE_TAP | ADXL343_INT_ACTIVITY, ADXL343_INT_MAP_INT1);
+    adxl343_set_interrupt_callback(&device, ADXL343_INT_SINGLE_TAP | ADXL343_INT_ACTIVITY, record_interrupt,
+                                   &interrupt_calls);
+    // Activity first seen on X, tap on Y, asleep
+    sim.registers[ADXL343_REG_ACT_TAP_STATUS] = 0x4A;
+    sim_adxl343_raise_event(&sim, ADXL343_INT_SINGLE_TAP | ADXL343_INT_ACTIVITY);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    uint32_t bytes = sim_i2c_bus_bytes();
+    TEST_ASSERT_EQUAL(adxl343_on_interrupt(&device), FUNCTION_STATUS_OK);
+    // ACT_TAP_STATUS to INT_SOURCE in the one transaction
+    TEST_ASSERT_EQUAL(1, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL(9, sim_i2c_bus_bytes() - bytes);
+    TEST_ASSERT_EQUAL(interrupt_calls, 2);
+    TEST_ASSERT_EQUAL_HEX8(interrupt_order[0], ADXL343_INT_ACTIVITY);
+    TEST_ASSERT_EQUAL_HEX8(interrupt_order[1], ADXL343_INT_SINGLE_TAP);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_AXIS_X, device.event_status.activity_axes);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_AXIS_Y, device.event_status.tap_axes);
+    TEST_ASSERT_EQUAL(1, device.event_status.asleep);
+    // Without event callbacks only INT_SOURCE is read
+    adxl343_set_interrupt_callback(&device, ADXL343_INT_SINGLE_TAP | ADXL343_INT_ACTIVITY, NULL, NULL);
+    bytes = sim_i2c_bus_bytes();
+    TEST_ASSERT_EQUAL(adxl343_on_interrupt(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(4, sim_i2c_bus_bytes() - bytes);
+    sim.registers[ADXL343_REG_ACT_TAP_STATUS] = 0x11;
+    TEST_ASSERT_EQUAL(adxl343_get_event_status(&device, &status), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_AXIS_Z, status.activity_axes);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_AXIS_Z, status.tap_axes);
+    TEST_ASSERT_EQUAL(0, status.asleep);
+    TEST_ASSERT_EQUAL(adxl343_get_event_status(&device, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+static uint8_t wake_rate_seen;
+
+static void record_wake_rate(ADXL343Device* dev, uint8_t source, void* context){
+    (void) source;
+    (void) context;
+    wake_rate_seen = adxl343_get_settings(dev).rate;
+}
+
+void test_adxl343_power_modes_noerror(){
+    static SimADXL343 sim;
+    ADXL343WakeProfile profile;
+    sim_adxl343_attach(&sim, ADXL343_ADDRESS_I2C);
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    // LOW_POWER is kept by set_rate
+    TEST_ASSERT_EQUAL(adxl343_set_low_power(&device, 0x01), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_set_rate(&device, 0x09), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x19, sim.registers[ADXL343_REG_BW_RATE]);
+    TEST_ASSERT_EQUAL(adxl343_get_settings(&device).low_power, 0x01);
+    // BW_RATE and POWER_CTL in one burst, the measurement bit is kept
+    const ADXL343PowerConfig power = {0, 1, 1, ADXL343_WAKEUP_2HZ};
+    adxl343_start(&device);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_set_power_config(&device, &power), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(1, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL_HEX8(0x09, sim.registers[ADXL343_REG_BW_RATE]);
+    TEST_ASSERT_EQUAL_HEX8(0x3A, sim.registers[ADXL343_REG_POWER_CTL]);
+    TEST_ASSERT_EQUAL(adxl343_get_settings(&device).auto_sleep, 0x01);
+    TEST_ASSERT_EQUAL(adxl343_get_settings(&device).wakeup, ADXL343_WAKEUP_2HZ);
+    const ADXL343PowerConfig unlinked = {0, 0, 1, ADXL343_WAKEUP_8HZ};
+    const ADXL343PowerConfig too_slow = {0, 1, 1, 4};
+    TEST_ASSERT_EQUAL(adxl343_set_power_config(&device, &unlinked), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_set_power_config(&device, &too_slow), FUNCTION_STATUS_BOUNDARY_ERROR);
+
+    // Wake profile starts idle, 12.5 Hz low power with a watermark of 4 and 8 Hz while asleep
+    adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_STREAM, 16, ADXL343_FIFO_TRIGGER_INT1);
+    adxl343_get_default_wake_profile(&profile);
+    TEST_ASSERT_EQUAL(adxl343_set_wake_profile(&device, &profile), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x17, sim.registers[ADXL343_REG_BW_RATE]);
+    TEST_ASSERT_EQUAL_HEX8(0x38, sim.registers[ADXL343_REG_POWER_CTL]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, sim.registers[ADXL343_REG_ACT_INACT_CTL]);
+    TEST_ASSERT_EQUAL_HEX8((ADXL343_FIFO_MODE_STREAM << 6) | 4, sim.registers[ADXL343_REG_FIFO_CTL]);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY, sim.registers[ADXL343_REG_INT_ENABLE]);
+    // Activity bursts to 800 Hz before the callback runs, inactivity drops back
+    adxl343_set_interrupt_callback(&device, ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY, record_wake_rate, NULL);
+    sim_adxl343_raise_event(&sim, ADXL343_INT_ACTIVITY);
+    TEST_ASSERT_EQUAL(adxl343_on_interrupt(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_RATE_800HZ, wake_rate_seen);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_RATE_800HZ, sim.registers[ADXL343_REG_BW_RATE]);
+    TEST_ASSERT_EQUAL_HEX8((ADXL343_FIFO_MODE_STREAM << 6) | 16, sim.registers[ADXL343_REG_FIFO_CTL]);
+    sim_adxl343_raise_event(&sim, ADXL343_INT_INACTIVITY);
+    TEST_ASSERT_EQUAL(adxl343_on_interrupt(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x17, sim.registers[ADXL343_REG_BW_RATE]);
+    // Both flagged, the device is awake so activity came last
+    sim_adxl343_raise_event(&sim, ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY);
+    TEST_ASSERT_EQUAL(adxl343_on_interrupt(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_RATE_800HZ, sim.registers[ADXL343_REG_BW_RATE]);
+    sim.registers[ADXL343_REG_ACT_TAP_STATUS] = 0x08;
+    sim_adxl343_raise_event(&sim, ADXL343_INT_ACTIVITY | ADXL343_INT_INACTIVITY);
+    TEST_ASSERT_EQUAL(adxl343_on_interrupt(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x17, sim.registers[ADXL343_REG_BW_RATE]);
+    // Switching stops without a profile
+    TEST_ASSERT_EQUAL(adxl343_set_wake_profile(&device, NULL), FUNCTION_STATUS_OK);
+    sim_adxl343_raise_event(&sim, ADXL343_INT_ACTIVITY);
+    TEST_ASSERT_EQUAL(adxl343_on_interrupt(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x17, sim.registers[ADXL343_REG_BW_RATE]);
+    profile.active_watermark = 32;
+    TEST_ASSERT_EQUAL(adxl343_set_wake_profile(&device, &profile), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_set_low_power(NULL, 0x01), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_get_all_axes_single_transaction(){
+    char axes_buffer [6];
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    uint32_t bytes = sim_i2c_bus_bytes();
+    FunctionStatus result = adxl343_get_all_axes(&device, axes_buffer);
+    TEST_ASSERT_EQUAL(result, FUNCTION_STATUS_OK);
+    // Write address, register, repeated start read address and 6 data bytes
+    TEST_ASSERT_EQUAL(1, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL(9, sim_i2c_bus_bytes() - bytes);
+}
+
+void test_adxl343_get_X_axis_error(){
+    char x_axis_buffer [2];
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_get_X_axis(&device, x_axis_buffer), FUNCTION_STATUS_TIMEOUT);
+}
+
+void test_adxl343_setters_single_write(){
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_set_range(&device, 0x02), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_set_resolution_full(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_set_bit_order(&device, 0x01), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_start(&device), FUNCTION_STATUS_OK);
+    // One write per change, no read-modify-write reads
+    TEST_ASSERT_EQUAL(4, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL_HEX8(0x0E, sim_i2c_bus_get_register(ADXL343_REG_DATA_FORMAT));
+    TEST_ASSERT_EQUAL_HEX8(0x08, sim_i2c_bus_get_register(ADXL343_REG_POWER_CTL));
+    TEST_ASSERT_EQUAL(adxl343_stop(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x00, sim_i2c_bus_get_register(ADXL343_REG_POWER_CTL));
+}
+
+void test_adxl343_setters_resync_after_error(){
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    // Failed write leaves the shadow untrusted
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_set_range(&device, 0x01), FUNCTION_STATUS_TIMEOUT);
+    // Device was changed behind the drivers back, next setter re-syncs before writing
+    sim_i2c_bus_set_register(ADXL343_REG_DATA_FORMAT, 0x08);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_set_range(&device, 0x03), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(4, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL_HEX8(0x0B, sim_i2c_bus_get_register(ADXL343_REG_DATA_FORMAT));
+    ADXL343Settings settings = adxl343_get_settings(&device);
+    TEST_ASSERT_EQUAL(settings.resolution, 0x01);
+    TEST_ASSERT_EQUAL(settings.range, 0x03);
+}
+
+void test_adxl343_resync_shadow_noerror(){
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    sim_i2c_bus_set_register(ADXL343_REG_POWER_CTL, 0x08);
+    sim_i2c_bus_set_register(ADXL343_REG_BW_RATE, 0x0D);
+    sim_i2c_bus_set_register(ADXL343_REG_DATA_FORMAT, 0x0D);
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_CTL, 0x90);
+    adxl343_invalidate_shadow(&device);
+    TEST_ASSERT_EQUAL(adxl343_resync_shadow(&device), FUNCTION_STATUS_OK);
+    ADXL343Settings settings = adxl343_get_settings(&device);
+    TEST_ASSERT_EQUAL(settings.measurement_mode, 0x01);
+    TEST_ASSERT_EQUAL(settings.rate, 0x0D);
+    TEST_ASSERT_EQUAL(settings.range, 0x01);
+    TEST_ASSERT_EQUAL(settings.resolution, 0x01);
+    TEST_ASSERT_EQUAL(settings.bit_order, 0x01);
+    TEST_ASSERT_EQUAL(settings.fifo_mode, ADXL343_FIFO_MODE_STREAM);
+    TEST_ASSERT_EQUAL(settings.fifo_samples, 0x10);
+}
+
+void test_adxl343_update_settings_error(){
+    ADXL343Settings settings = {0};
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    sim_i2c_bus_set_register(ADXL343_REG_BW_RATE, 0x0D);
+    TEST_ASSERT_EQUAL(adxl343_update_settings(NULL, &settings), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_update_settings(&device, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+    // A failed refresh reports the bus error and leaves the settings untouched
+    settings.rate = 0x0A;
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_update_settings(&device, &settings), FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(settings.rate, 0x0A);
+    TEST_ASSERT_EQUAL(adxl343_update_settings(&device, &settings), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(settings.rate, 0x0D);
+}
+
+void test_adxl343_init_writes_config_block(){
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C), FUNCTION_STATUS_OK);
+    // 0x1D - 0x2A, 0x2C - 0x2F, 0x31 and 0x38
+    TEST_ASSERT_EQUAL(4, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_DEFAULT_RATE, sim_i2c_bus_get_register(ADXL343_REG_BW_RATE));
+}
+
+void test_adxl343_apply_config_only_changes(){
+    ADXL343Config config;
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    adxl343_get_default_config(&config);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_apply_config(&device, &config), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(0, sim_i2c_bus_transactions() - transactions);
+    // BW_RATE and INT_MAP are joined through POWER_CTL/INT_ENABLE, DATA_FORMAT is its own burst
+    config.bw_rate = 0x0D;
+    config.int_map = 0x02;
+    config.data_format = 0x0B;
+    TEST_ASSERT_EQUAL(adxl343_apply_config(&device, &config), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(2, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL_HEX8(0x0D, sim_i2c_bus_get_register(ADXL343_REG_BW_RATE));
+    TEST_ASSERT_EQUAL_HEX8(0x02, sim_i2c_bus_get_register(ADXL343_REG_INT_MAP));
+    ADXL343Settings settings = adxl343_get_settings(&device);
+    TEST_ASSERT_EQUAL(settings.rate, 0x0D);
+    TEST_ASSERT_EQUAL(settings.range, 0x03);
+    TEST_ASSERT_EQUAL(settings.resolution, 0x01);
+    TEST_ASSERT_EQUAL(adxl343_apply_config(&device, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_snapshot_config_noerror(){
+    ADXL343Config config;
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    sim_i2c_bus_set_register(ADXL343_REG_THRESH_TAP, 0x30);
+    sim_i2c_bus_set_register(ADXL343_REG_OFSZ, 0xFE);
+    sim_i2c_bus_set_register(ADXL343_REG_DATA_FORMAT, 0x01);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_snapshot_config(&device, &config), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(3, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL_HEX8(0x30, config.thresh_tap);
+    TEST_ASSERT_EQUAL_HEX8(0xFE, config.ofsz);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_DEFAULT_RATE, config.bw_rate);
+    TEST_ASSERT_EQUAL(adxl343_get_settings(&device).range, 0x01);
+}
+
+void test_adxl343_decode_noerror(){
+    ADXL343Sample sample;
+    // -2 right justified 10 bit, +-2g
+    uint8_t right_raw [6] = {0xFE, 0xFF, 0x01, 0x00, 0xFF, 0x01};
+    ADXL343Decoder decoder = adxl343_make_decoder(0x00, 0x00, 0x00);
+    TEST_ASSERT_EQUAL(decoder.width, 10);
+    TEST_ASSERT_EQUAL(decoder.scale_mg_q8, 1000);
+    adxl343_decode(&decoder, right_raw, &sample, 1);
+    TEST_ASSERT_EQUAL_INT16(-2, sample.x);
+    TEST_ASSERT_EQUAL_INT16(1, sample.y);
+    TEST_ASSERT_EQUAL_INT16(511, sample.z);
+    // -2 and 4095 left justified 13 bit, full resolution +-16g
+    uint8_t left_raw [6] = {0xF0, 0xFF, 0x08, 0x00, 0xF8, 0x7F};
+    decoder = adxl343_make_decoder(0x03, 0x01, 0x01);
+    TEST_ASSERT_EQUAL(decoder.width, 13);
+    adxl343_decode(&decoder, left_raw, &sample, 1);
+    TEST_ASSERT_EQUAL_INT16(-2, sample.x);
+    TEST_ASSERT_EQUAL_INT16(1, sample.y);
+    TEST_ASSERT_EQUAL_INT16(4095, sample.z);
+    // Fixed resolution +-8g scales 4 times
+    TEST_ASSERT_EQUAL(adxl343_make_decoder(0x02, 0x00, 0x00).scale_mg_q8, 4000);
+    // Strided, two samples into the even slots of per-axis arrays
+    uint8_t two_raw [12] = {0xF0, 0xFF, 0x08, 0x00, 0xF8, 0x7F, 0x10, 0x00, 0xE8, 0xFF, 0x00, 0x00};
+    int16_t x [4] = {0x55, 0x55, 0x55, 0x55};
+    int16_t y [4] = {0x55, 0x55, 0x55, 0x55};
+    int16_t z [4] = {0x55, 0x55, 0x55, 0x55};
+    adxl343_decode_strided(&decoder, two_raw, 2, x, y, z, 2);
+    TEST_ASSERT_EQUAL_INT16(-2, x[0]);
+    TEST_ASSERT_EQUAL_INT16(4095, z[0]);
+    TEST_ASSERT_EQUAL_INT16(2, x[2]);
+    TEST_ASSERT_EQUAL_INT16(-3, y[2]);
+    TEST_ASSERT_EQUAL_INT16(0, z[2]);
+    TEST_ASSERT_EQUAL_INT16(0x55, x[1]);
+    TEST_ASSERT_EQUAL_INT16(0x55, z[3]);
+}
+
+void test_adxl343_read_sample_noerror(){
+    ADXL343Sample sample;
+    int16_t x [8] = {0};
+    int16_t y [8] = {0};
+    int16_t z [8] = {0};
+    size_t count = 0;
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    uint32_t bytes = sim_i2c_bus_bytes();
+    TEST_ASSERT_EQUAL(adxl343_read_sample(&device, &sample), FUNCTION_STATUS_OK);
+    // One burst, same cost as get_all_axes
+    TEST_ASSERT_EQUAL(1, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL(9, sim_i2c_bus_bytes() - bytes);
+    TEST_ASSERT_EQUAL_INT16(0x1EA, sample.x);
+    TEST_ASSERT_EQUAL_INT16(0x1EA, sample.y);
+    TEST_ASSERT_EQUAL_INT16(0x1EA, sample.z);
+    // 13 bit full resolution, 0x1DEA is negative
+    adxl343_set_range(&device, 0x03);
+    adxl343_set_resolution_full(&device);
+    TEST_ASSERT_EQUAL(adxl343_read_sample(&device, &sample), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_INT16(-534, sample.y);
+    // FIFO into every other slot of per-axis arrays
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 10);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo_strided(&device, x, y, z, 2, 4, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, 4);
+    TEST_ASSERT_EQUAL_INT16(-534, x[0]);
+    TEST_ASSERT_EQUAL_INT16(-534, z[6]);
+    TEST_ASSERT_EQUAL_INT16(0, x[1]);
+    TEST_ASSERT_EQUAL_INT16(0, y[7]);
+    TEST_ASSERT_EQUAL(adxl343_read_sample(&device, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo_strided(&device, x, y, z, 0, 4, &count), FUNCTION_STATUS_BOUNDARY_ERROR);
+}
+
+void test_adxl343_init_error(){
+    TEST_ASSERT_EQUAL(adxl343_init(NULL, NULL, ADXL343_ADDRESS_I2C), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_init(&device, NULL, 0x80), FUNCTION_STATUS_BOUNDARY_ERROR);
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C), FUNCTION_STATUS_TIMEOUT);
+}
+
+static uint64_t fake_ticks;
+
+static uint64_t fake_timestamp(){
+    // Every transaction takes 5 ticks, latency bucket 3 ([4, 8) ticks)
+    fake_ticks += 5;
+    return fake_ticks;
+}
+
+void test_adxl343_stats_noerror(){
+    static ADXL343AsyncOp op;
+    ADXL343Stats stats;
+    ADXL343Sample samples [4];
+    char axes [6];
+    adxl343_set_timestamp_source(fake_timestamp);
+    TEST_ASSERT_EQUAL(adxl343_reset_stats(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_get_all_axes(&device, axes), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_set_rate(&device, 0x0D), FUNCTION_STATUS_OK);
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_get_all_axes(&device, axes), FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_get_stats(&device, &stats), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(stats.read.transactions, 2);
+    TEST_ASSERT_EQUAL(stats.read.bytes, 12);
+    TEST_ASSERT_EQUAL(stats.read.status[FUNCTION_STATUS_OK], 1);
+    TEST_ASSERT_EQUAL(stats.read.status[FUNCTION_STATUS_TIMEOUT], 1);
+    TEST_ASSERT_EQUAL(stats.read.latency[3], 2);
+    TEST_ASSERT_EQUAL(stats.read.latency_max, 5);
+    TEST_ASSERT_EQUAL(stats.write.transactions, 1);
+    TEST_ASSERT_EQUAL(stats.write.bytes, 1);
+    TEST_ASSERT_EQUAL(stats.write.status[FUNCTION_STATUS_OK], 1);
+    // Queued transactions are counted on completion, from their submit
+    sim_i2c_bus_set_register(ADXL343_REG_FIFO_STATUS, 2);
+    adxl343_reset_stats(&device);
+    TEST_ASSERT_EQUAL(adxl343_drain_fifo_async(&device, &op, samples, 4, NULL, NULL), FUNCTION_STATUS_OK);
+    while (i2c_process() > 0){
+        i2c_poll();
+    }
+    adxl343_get_stats(&device, &stats);
+    TEST_ASSERT_EQUAL(stats.read.transactions, 3);
+    TEST_ASSERT_EQUAL(stats.read.bytes, 13);
+    TEST_ASSERT_EQUAL(stats.read.status[FUNCTION_STATUS_OK], 3);
+    TEST_ASSERT_EQUAL(stats.write.transactions, 0);
+    // Without a timestamp source every transaction is in bucket 0
+    adxl343_set_timestamp_source(NULL);
+    adxl343_reset_stats(&device);
+    adxl343_get_all_axes(&device, axes);
+    adxl343_get_stats(&device, &stats);
+    TEST_ASSERT_EQUAL(stats.read.latency[0], 1);
+    TEST_ASSERT_EQUAL(adxl343_get_stats(NULL, &stats), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_reset_stats(NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_read_multi_noerror(){
+    ADXL343Device alt_device;
+    ADXL343Device* devices [2] = {&device, &alt_device};
+    ADXL343Sample samples [2];
+    TEST_ASSERT_EQUAL(adxl343_init(&alt_device, NULL, ADXL343_ADDRESS_I2C_ALT), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_last_address(), ADXL343_ADDRESS_I2C_ALT);
+    // Each device keeps its own settings, the alternate device reads -2 in full resolution
+    TEST_ASSERT_EQUAL(adxl343_set_resolution_full(&alt_device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x08, sim_i2c_bus_get_device_register(ADXL343_ADDRESS_I2C_ALT, ADXL343_REG_DATA_FORMAT));
+    TEST_ASSERT_EQUAL_HEX8(0x00, sim_i2c_bus_get_register(ADXL343_REG_DATA_FORMAT));
+    sim_i2c_bus_set_device_register(ADXL343_ADDRESS_I2C_ALT, ADXL343_DATA_X_0, 0xFE);
+    sim_i2c_bus_set_device_register(ADXL343_ADDRESS_I2C_ALT, ADXL343_DATA_X_1, 0xFF);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_read_multi(devices, 2, samples), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(2, sim_i2c_bus_transactions() - transactions);
+    TEST_ASSERT_EQUAL_INT16(0x1EA, samples[0].x);
+    TEST_ASSERT_EQUAL_INT16(-2, samples[1].x);
+    devices[1] = NULL;
+    TEST_ASSERT_EQUAL(adxl343_read_multi(devices, 2, samples), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
 /** 
  * ... and many more tests all following a similar layout. Ideally there would be multiple 
  * 'noerror' (good weather) tests and multiple (bad weather) 'error' tests per function if 
@@ -79,6 +891,37 @@ int main(void){
     RUN_TEST(test_adxl343_init_noerror);
     RUN_TEST(test_adxl343_init_error);
     RUN_TEST(test_adxl343_get_X_axis_noerror);
+    RUN_TEST(test_adxl343_get_X_axis_error);
+    RUN_TEST(test_adxl343_get_all_axes_single_transaction);
+    RUN_TEST(test_adxl343_setters_single_write);
+    RUN_TEST(test_adxl343_setters_resync_after_error);
+    RUN_TEST(test_adxl343_resync_shadow_noerror);
+    RUN_TEST(test_adxl343_update_settings_error);
+    RUN_TEST(test_adxl343_init_writes_config_block);
+    RUN_TEST(test_adxl343_apply_config_only_changes);
+    RUN_TEST(test_adxl343_snapshot_config_noerror);
+    RUN_TEST(test_adxl343_decode_noerror);
+    RUN_TEST(test_adxl343_read_sample_noerror);
+    RUN_TEST(test_adxl343_read_multi_noerror);
+    RUN_TEST(test_adxl343_set_fifo_mode_noerror);
+    RUN_TEST(test_adxl343_set_fifo_mode_error);
+    RUN_TEST(test_adxl343_read_fifo_noerror);
+    RUN_TEST(test_adxl343_read_fifo_error);
+    RUN_TEST(test_adxl343_drain_fifo_to_ring_noerror);
+    RUN_TEST(test_adxl343_drain_fifo_to_ring_error);
+    RUN_TEST(test_adxl343_drain_fifo_async_noerror);
+    RUN_TEST(test_adxl343_drain_fifo_async_error);
+    RUN_TEST(test_adxl343_apply_config_async_noerror);
+    RUN_TEST(test_adxl343_step_drain_fifo_noerror);
+    RUN_TEST(test_adxl343_step_apply_config_noerror);
+    RUN_TEST(test_adxl343_step_error);
+    RUN_TEST(test_adxl343_set_interrupts_noerror);
+    RUN_TEST(test_adxl343_on_interrupt_noerror);
+    RUN_TEST(test_adxl343_on_interrupt_error);
+    RUN_TEST(test_adxl343_event_config_noerror);
+    RUN_TEST(test_adxl343_on_interrupt_event_status);
+    RUN_TEST(test_adxl343_power_modes_noerror);
+    RUN_TEST(test_adxl343_stats_noerror);
 
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  test_adxl343_filter.c
+/// \brief unittester for adxl343_filter
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_filter.h"
+#include "unity.h"
+
+
+// Butterworth low-pass, 100 Hz at 3200 Hz, in Q28
+static const ADXL343BiquadCoeffs lowpass_100hz = {2266318, 4532636, 2266318, -462722643, 203352459};
+// 32 tap Hamming windowed sinc, cut-off at 0.1 of the rate (in front of a decimation by 4), in Q15
+static const int16_t lowpass_taps [32] = {
+    -17, 20, 73, 135, 164, 91, -129, -466, -783, -850, -435, 588, 2141, 3927, 5501, 6424,
+    6424, 5501, 3927, 2141, 588, -435, -850, -783, -466, -129, 91, 164, 135, 73, 20, -17
+};
+
+static ADXL343FilterStage stages [4];
+static ADXL343FilterPipeline pipeline;
+static ADXL343Sample samples [512];
+
+
+void setUp(void){}
+
+// Helpers
+static void fill_constant(size_t count, int16_t x, int16_t y, int16_t z){
+    for (size_t i = 0; i < count; i++){
+        samples[i].x = x;
+        samples[i].y = y;
+        samples[i].z = z;
+    }
+}
+
+// Full scale alternating samples, the highest frequency the rate can carry
+static void fill_nyquist(size_t count, int16_t amplitude){
+    for (size_t i = 0; i < count; i++){
+        int16_t value = (i & 1) ? -amplitude : amplitude;
+        samples[i].x = value;
+        samples[i].y = value;
+        samples[i].z = value;
+    }
+}
+
+static void fill_random(ADXL343Sample* buffer, size_t count){
+    uint32_t state = 0x1234567;
+    for (size_t i = 0; i < count; i++){
+        state = state * 1103515245u + 12345u;
+        buffer[i].x = (int16_t) ((state >> 16) % 2048) - 1024;
+        buffer[i].y = (int16_t) ((state >> 4) % 512) + 200;
+        buffer[i].z = (int16_t) ((state >> 8) % 4096) - 2048;
+    }
+}
+
+// Test cases
+void test_adxl343_filter_init_error(){
+    TEST_ASSERT_EQUAL(adxl343_filter_biquad(NULL, &lowpass_100hz), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_biquad(&stages[0], NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_fir_decimator(&stages[0], NULL, 32, 4), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_fir_decimator(&stages[0], lowpass_taps, 0, 4), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_fir_decimator(&stages[0], lowpass_taps, ADXL343_FILTER_MAX_TAPS + 1, 4),
+                      FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_fir_decimator(&stages[0], lowpass_taps, 32, 0), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_dc_block(&stages[0], 0), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_dc_block(&stages[0], 16), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_moving_rms(&stages[0], 24), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_moving_rms(&stages[0], ADXL343_FILTER_MAX_RMS_WINDOW * 2),
+                      FUNCTION_STATUS_BOUNDARY_ERROR);
+    // Stages that were never initialized
+    ADXL343FilterStage blank [2] = {0};
+    size_t output;
+    TEST_ASSERT_EQUAL(adxl343_filter_init(&pipeline, blank, 2), FUNCTION_STATUS_NOT_INITIALIZED);
+    TEST_ASSERT_EQUAL(adxl343_filter_init(NULL, blank, 0), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_init(&pipeline, blank, 0), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_filter_process(&pipeline, NULL, 1, &output), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_filter_process(&pipeline, samples, 1, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_filter_biquad_noerror(){
+    size_t output;
+    adxl343_filter_biquad(&stages[0], &lowpass_100hz);
+    TEST_ASSERT_EQUAL(adxl343_filter_init(&pipeline, stages, 1), FUNCTION_STATUS_OK);
+    // Unity gain at DC
+    fill_constant(400, 1000, -500, 256);
+    TEST_ASSERT_EQUAL(adxl343_filter_process(&pipeline, samples, 400, &output), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(output, 400);
+    TEST_ASSERT_INT_WITHIN(1, 1000, samples[399].x);
+    TEST_ASSERT_INT_WITHIN(1, -500, samples[399].y);
+    TEST_ASSERT_INT_WITHIN(1, 256, samples[399].z);
+    // Nyquist is stopped
+    adxl343_filter_reset(&pipeline);
+    fill_nyquist(400, 1000);
+    adxl343_filter_process(&pipeline, samples, 400, &output);
+    TEST_ASSERT_INT_WITHIN(2, 0, samples[399].x);
+    TEST_ASSERT_INT_WITHIN(2, 0, samples[398].z);
+}
+
+void test_adxl343_filter_fir_decimator_noerror(){
+    size_t output;
+    adxl343_filter_fir_decimator(&stages[0], lowpass_taps, 32, 4);
+    adxl343_filter_init(&pipeline, stages, 1);
+    fill_constant(256, 1000, -1000, 0);
+    TEST_ASSERT_EQUAL(adxl343_filter_process(&pipeline, samples, 256, &output), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(output, 64);
+    TEST_ASSERT_INT_WITHIN(1, 1000, samples[63].x);
+    TEST_ASSERT_INT_WITHIN(1, -1000, samples[63].y);
+    // Odd block sizes keep the decimation phase, 10 + 3 + 3 inputs give 4 outputs
+    TEST_ASSERT_EQUAL(adxl343_filter_process(&pipeline, samples, 10, &output), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(output, 2);
+    adxl343_filter_process(&pipeline, samples, 3, &output);
+    TEST_ASSERT_EQUAL(output, 1);
+    adxl343_filter_process(&pipeline, samples, 3, &output);
+    TEST_ASSERT_EQUAL(output, 1);
+    adxl343_filter_reset(&pipeline);
+    fill_nyquist(256, 1000);
+    adxl343_filter_process(&pipeline, samples, 256, &output);
+    TEST_ASSERT_INT_WITHIN(2, 0, samples[63].x);
+}
+
+void test_adxl343_filter_dc_block_and_rms_noerror(){
+    size_t output;
+    // Gravity on Z is removed, the step decays with the pole
+    adxl343_filter_dc_block(&stages[0], 4);
+    adxl343_filter_init(&pipeline, stages, 1);
+    fill_constant(512, 0, 0, 256);
+    adxl343_filter_process(&pipeline, samples, 512, &output);
+    TEST_ASSERT_EQUAL_INT16(256, samples[0].z);
+    TEST_ASSERT_EQUAL_INT16(0, samples[511].z);
+    // RMS of a +-300 square wave, ramping up while the window fills
+    adxl343_filter_moving_rms(&stages[0], 16);
+    adxl343_filter_init(&pipeline, stages, 1);
+    fill_nyquist(100, 300);
+    adxl343_filter_process(&pipeline, samples, 100, &output);
+    TEST_ASSERT_EQUAL(output, 100);
+    TEST_ASSERT_EQUAL_INT16(75, samples[0].x);
+    TEST_ASSERT_EQUAL_INT16(300, samples[15].x);
+    TEST_ASSERT_EQUAL_INT16(300, samples[99].y);
+}
+
+void test_adxl343_filter_pipeline_block_sizes(){
+    // The same stream fed at once and in small blocks comes out the same
+    static ADXL343Sample reference [500];
+    static ADXL343Sample streamed [500];
+    size_t output;
+    size_t total = 0;
+    adxl343_filter_dc_block(&stages[0], 7);
+    adxl343_filter_biquad(&stages[1], &lowpass_100hz);
+    adxl343_filter_fir_decimator(&stages[2], lowpass_taps, 32, 4);
+    adxl343_filter_moving_rms(&stages[3], 8);
+    adxl343_filter_init(&pipeline, stages, 4);
+    fill_random(reference, 500);
+    TEST_ASSERT_EQUAL(adxl343_filter_process(&pipeline, reference, 500, &output), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(output, 125);
+    adxl343_filter_reset(&pipeline);
+    fill_random(streamed, 500);
+    for (size_t start = 0; start < 500; start += 7){
+        size_t n = (500 - start < 7) ? 500 - start : 7;
+        adxl343_filter_process(&pipeline, &streamed[start], n, &output);
+        for (size_t i = 0; i < output; i++){
+            streamed[total + i] = streamed[start + i];
+        }
+        total += output;
+    }
+    TEST_ASSERT_EQUAL(total, 125);
+    for (size_t i = 0; i < total; i++){
+        TEST_ASSERT_EQUAL_INT16(reference[i].x, streamed[i].x);
+        TEST_ASSERT_EQUAL_INT16(reference[i].y, streamed[i].y);
+        TEST_ASSERT_EQUAL_INT16(reference[i].z, streamed[i].z);
+    }
+}
+
+void tearDown(void){
+
+}
+
+int main(void){
+    UNITY_BEGIN();
+
+    RUN_TEST(test_adxl343_filter_init_error);
+    RUN_TEST(test_adxl343_filter_biquad_noerror);
+    RUN_TEST(test_adxl343_filter_fir_decimator_noerror);
+    RUN_TEST(test_adxl343_filter_dc_block_and_rms_noerror);
+    RUN_TEST(test_adxl343_filter_pipeline_block_sizes);
+
+    return UNITY_END();
+}
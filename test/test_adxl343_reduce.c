@@ -0,0 +1,209 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  test_adxl343_reduce.c
+/// \brief unittester for adxl343_reduce
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include "adxl343_reduce.h"
+#include "unity.h"
+
+#define PERIOD_NS 1250000ull                    // 800 Hz
+
+
+static ADXL343ReduceConfig config;
+static ADXL343Reducer reducer;
+static ADXL343Sample samples [1000];
+static uint64_t timestamps [1000];
+static ADXL343ReducedPoint points [2100];
+
+
+void setUp(void){
+    memset(&config, 0, sizeof(config));
+    for (size_t i = 0; i < 1000; i++){
+        timestamps[i] = 5000000000ull + i * PERIOD_NS;
+    }
+}
+
+// Helpers
+// Still stretches with noise, a step and a slow ramp, a burst of vibration
+static void fill_signal(size_t count){
+    uint32_t state = 0x1234567;
+    for (size_t i = 0; i < count; i++){
+        state = state * 1103515245u + 12345u;
+        int16_t noise = (int16_t) ((state >> 16) % 5) - 2;
+        samples[i].x = (int16_t) (noise + ((i >= 300) ? 120 : 0));
+        samples[i].y = (int16_t) (noise + ((i >= 500 && i < 700) ? (int16_t) (i - 500) : 0));
+        samples[i].z = (int16_t) (256 + noise + ((i >= 800 && i < 850) ? (((i >> 1) & 1) ? 200 : -200) : 0));
+    }
+}
+
+static size_t reduce_all(size_t count){
+    size_t consumed;
+    size_t emitted;
+    size_t flushed;
+    TEST_ASSERT_EQUAL(adxl343_reduce_init(&reducer, &config), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_reduce_push(&reducer, samples, timestamps, count, points, 2100, &consumed, &emitted),
+                      FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(consumed, count);
+    TEST_ASSERT_EQUAL(adxl343_reduce_flush(&reducer, &points[emitted], 1, &flushed), FUNCTION_STATUS_OK);
+    return emitted + flushed;
+}
+
+// Every sample is within the threshold of the points, held (deadband) or joined by lines (swinging door)
+static void check_reconstruction(size_t count, size_t total, int interpolate){
+    size_t segment = 0;
+    for (size_t i = 0; i < count; i++){
+        while (segment + 1 < total && points[segment + 1].timestamp <= timestamps[i]){
+            segment++;
+        }
+        const ADXL343ReducedPoint* start = &points[segment];
+        const ADXL343ReducedPoint* end = (segment + 1 < total) ? &points[segment + 1] : start;
+        double position = (end == start) ? 0.0 : (double) (timestamps[i] - start->timestamp)
+                                                / (double) (end->timestamp - start->timestamp);
+        if (!interpolate){
+            position = 0.0;
+        }
+        for (int axis = 0; axis < 3; axis++){
+            double from = (&start->sample.x)[axis];
+            double to = (&end->sample.x)[axis];
+            double value = from + (to - from) * position;
+            double error = value - (&samples[i].x)[axis];
+            TEST_ASSERT_TRUE(error <= config.threshold[axis] + 1e-6 && -error <= config.threshold[axis] + 1e-6);
+        }
+    }
+}
+
+// Test cases
+void test_adxl343_reduce_init_error(){
+    size_t consumed;
+    size_t emitted;
+    ADXL343Reducer blank = {0};
+    TEST_ASSERT_EQUAL(adxl343_reduce_init(NULL, &config), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_reduce_init(&reducer, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_reduce_init(&reducer, &config), FUNCTION_STATUS_BOUNDARY_ERROR);
+    config.mode = ADXL343_REDUCE_DEADBAND;
+    config.threshold[2] = ADXL343_REDUCE_MAX_THRESHOLD + 1;
+    TEST_ASSERT_EQUAL(adxl343_reduce_init(&reducer, &config), FUNCTION_STATUS_BOUNDARY_ERROR);
+    config.threshold[2] = 4;
+    TEST_ASSERT_EQUAL(adxl343_reduce_init(&reducer, &config), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_reduce_push(&reducer, NULL, timestamps, 1, points, 1, &consumed, &emitted),
+                      FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_reduce_push(&reducer, samples, NULL, 1, points, 1, &consumed, &emitted),
+                      FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_reduce_push(&reducer, samples, timestamps, 1, points, 1, &consumed, NULL),
+                      FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_reduce_push(&blank, samples, timestamps, 1, points, 1, &consumed, &emitted),
+                      FUNCTION_STATUS_NOT_INITIALIZED);
+    TEST_ASSERT_EQUAL(adxl343_reduce_flush(&blank, points, 1, &emitted), FUNCTION_STATUS_NOT_INITIALIZED);
+    TEST_ASSERT_EQUAL(adxl343_reduce_flush(&reducer, points, 1, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_reduce_deadband_noerror(){
+    config.mode = ADXL343_REDUCE_DEADBAND;
+    config.threshold[0] = 4;
+    config.threshold[1] = 4;
+    config.threshold[2] = 4;
+    fill_signal(1000);
+    size_t total = reduce_all(1000);
+    // The noise stays in the band, the step is one point, the ramp and the burst pass through
+    TEST_ASSERT_EQUAL(points[0].timestamp, timestamps[0]);
+    TEST_ASSERT_LESS_THAN(200, total);
+    TEST_ASSERT_GREATER_THAN(50, total);
+    TEST_ASSERT_EQUAL(reducer.inputs, 1000);
+    TEST_ASSERT_EQUAL(reducer.outputs, total);
+    check_reconstruction(1000, total, 0);
+}
+
+void test_adxl343_reduce_swinging_door_noerror(){
+    config.mode = ADXL343_REDUCE_SWINGING_DOOR;
+    config.threshold[0] = 4;
+    config.threshold[1] = 4;
+    config.threshold[2] = 4;
+    fill_signal(1000);
+    size_t total = reduce_all(1000);
+    TEST_ASSERT_LESS_THAN(150, total);
+    check_reconstruction(1000, total, 1);
+    // A clean ramp is a single segment, it only ends on the flush
+    for (size_t i = 0; i < 1000; i++){
+        samples[i].x = (int16_t) (i * 3);
+        samples[i].y = (int16_t) -i;
+        samples[i].z = 0;
+    }
+    config.threshold[0] = 0;
+    config.threshold[1] = 0;
+    config.threshold[2] = 0;
+    TEST_ASSERT_EQUAL(reduce_all(1000), 2);
+    TEST_ASSERT_EQUAL(points[1].timestamp, timestamps[999]);
+    TEST_ASSERT_EQUAL_INT16(2997, points[1].sample.x);
+}
+
+void test_adxl343_reduce_heartbeat_noerror(){
+    // A still sensor sends a point every 100 ms, 800 samples take 1 s
+    for (size_t i = 0; i < 1000; i++){
+        samples[i].x = 10;
+        samples[i].y = -10;
+        samples[i].z = 256;
+    }
+    config.heartbeat_ns = 100000000ull;
+    config.mode = ADXL343_REDUCE_DEADBAND;
+    TEST_ASSERT_EQUAL(reduce_all(800), 10);
+    TEST_ASSERT_EQUAL(points[1].timestamp - points[0].timestamp, 100000000ull);
+    config.mode = ADXL343_REDUCE_SWINGING_DOOR;
+    TEST_ASSERT_EQUAL(reduce_all(800), 11);
+    TEST_ASSERT_EQUAL(points[9].timestamp - points[8].timestamp, 100000000ull);
+    // A step back in time starts over
+    size_t consumed;
+    size_t emitted;
+    adxl343_reduce_init(&reducer, &config);
+    adxl343_reduce_push(&reducer, samples, timestamps, 10, points, 20, &consumed, &emitted);
+    TEST_ASSERT_EQUAL(emitted, 1);
+    adxl343_reduce_push(&reducer, samples, timestamps, 1, points, 20, &consumed, &emitted);
+    TEST_ASSERT_EQUAL(emitted, 2);
+    TEST_ASSERT_EQUAL(points[0].timestamp, timestamps[9]);
+    TEST_ASSERT_EQUAL(points[1].timestamp, timestamps[0]);
+}
+
+void test_adxl343_reduce_small_buffer(){
+    // A point buffer too small for a drain takes what fits and gives the same points in the end
+    static ADXL343ReducedPoint streamed [2100];
+    size_t consumed;
+    size_t emitted;
+    size_t total = 0;
+    config.mode = ADXL343_REDUCE_SWINGING_DOOR;
+    config.threshold[0] = 2;
+    config.threshold[1] = 2;
+    config.threshold[2] = 2;
+    fill_signal(1000);
+    size_t reference = reduce_all(1000);
+    adxl343_reduce_reset(&reducer);
+    size_t start = 0;
+    while (start < 1000){
+        size_t n = (1000 - start < 32) ? 1000 - start : 32;
+        FunctionStatus status = adxl343_reduce_push(&reducer, &samples[start], &timestamps[start], n,
+                                                    &streamed[total], 3, &consumed, &emitted);
+        TEST_ASSERT_TRUE(status == FUNCTION_STATUS_OK || status == FUNCTION_STATUS_BUSY);
+        start += consumed;
+        total += emitted;
+    }
+    adxl343_reduce_flush(&reducer, &streamed[total], 1, &emitted);
+    total += emitted;
+    TEST_ASSERT_EQUAL(reference, total);
+    TEST_ASSERT_EQUAL(0, memcmp(points, streamed, total * sizeof(ADXL343ReducedPoint)));
+}
+
+void tearDown(void){
+
+}
+
+int main(void){
+    UNITY_BEGIN();
+
+    RUN_TEST(test_adxl343_reduce_init_error);
+    RUN_TEST(test_adxl343_reduce_deadband_noerror);
+    RUN_TEST(test_adxl343_reduce_swinging_door_noerror);
+    RUN_TEST(test_adxl343_reduce_heartbeat_noerror);
+    RUN_TEST(test_adxl343_reduce_small_buffer);
+
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  test_adxl343_ring.c
+/// \brief unittester for adxl343_ring
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_ring.h"
+#include "unity.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+
+#define STRESS_SAMPLES 1000000                  // Samples passed between the stress threads
+#define STRESS_CAPACITY 64                      // Small ring so both sides wrap and hit full/empty often
+
+static ADXL343Ring ring;
+static ADXL343Sample storage [8];
+
+
+void setUp(void){
+    adxl343_ring_init(&ring, storage, 8);
+}
+
+// Helpers
+static ADXL343Sample sequence_sample(uint32_t i){
+    ADXL343Sample sample = {(int16_t) (i & 0x7FFF), (int16_t) (i >> 15), (int16_t) ~i};
+    return sample;
+}
+
+static void* stress_producer(void* argument){
+    ADXL343Ring* shared = argument;
+    uint32_t i = 0;
+    while (i < STRESS_SAMPLES){
+        ADXL343Sample* span;
+        size_t length;
+        adxl343_ring_reserve(shared, &span, &length);
+        if (length == 0){
+            sched_yield();
+            continue;
+        }
+        size_t n = 0;
+        for (; n < length && i < STRESS_SAMPLES; n++, i++){
+            span[n] = sequence_sample(i);
+        }
+        adxl343_ring_commit(shared, n);
+    }
+    return NULL;
+}
+
+// Test cases
+void test_adxl343_ring_init_error(){
+    TEST_ASSERT_EQUAL(adxl343_ring_init(NULL, storage, 8), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_ring_init(&ring, NULL, 8), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_ring_init(&ring, storage, 0), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_ring_init(&ring, storage, 6), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_ring_spans_wrap(){
+    ADXL343Sample in [6];
+    const ADXL343Sample* span;
+    size_t length;
+    for (uint32_t i = 0; i < 6; i++){
+        in[i] = sequence_sample(i);
+    }
+    TEST_ASSERT_EQUAL(adxl343_ring_push(&ring, in, 6), FUNCTION_STATUS_OK);
+    adxl343_ring_peek(&ring, &span, &length);
+    TEST_ASSERT_EQUAL(length, 6);
+    TEST_ASSERT_EQUAL_PTR(span, &storage[0]);
+    adxl343_ring_consume(&ring, 5);
+    // Six more wrap around the end of the storage, the consumer gets them as two spans without copies
+    TEST_ASSERT_EQUAL(adxl343_ring_push(&ring, in, 6), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_ring_size(&ring), 7);
+    adxl343_ring_peek(&ring, &span, &length);
+    TEST_ASSERT_EQUAL(length, 3);
+    TEST_ASSERT_EQUAL_PTR(span, &storage[5]);
+    TEST_ASSERT_EQUAL_INT16(span[0].x, 5);
+    TEST_ASSERT_EQUAL_INT16(span[1].x, 0);
+    adxl343_ring_consume(&ring, length);
+    adxl343_ring_peek(&ring, &span, &length);
+    TEST_ASSERT_EQUAL(length, 4);
+    TEST_ASSERT_EQUAL_PTR(span, &storage[0]);
+    TEST_ASSERT_EQUAL_INT16(span[3].x, 5);
+    adxl343_ring_consume(&ring, length);
+    adxl343_ring_peek(&ring, &span, &length);
+    TEST_ASSERT_EQUAL(length, 0);
+}
+
+void test_adxl343_ring_push_drops_when_full(){
+    ADXL343Sample in [6] = {{0}};
+    uint32_t dropped;
+    uint32_t overruns;
+    TEST_ASSERT_EQUAL(adxl343_ring_push(&ring, in, 6), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(adxl343_ring_push(&ring, in, 6), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_ring_size(&ring), 8);
+    adxl343_ring_get_counters(&ring, &dropped, &overruns);
+    TEST_ASSERT_EQUAL(dropped, 4);
+    TEST_ASSERT_EQUAL(overruns, 1);
+    TEST_ASSERT_EQUAL(adxl343_ring_push(&ring, in, 1), FUNCTION_STATUS_BOUNDARY_ERROR);
+    adxl343_ring_get_counters(&ring, &dropped, &overruns);
+    TEST_ASSERT_EQUAL(dropped, 5);
+    TEST_ASSERT_EQUAL(overruns, 2);
+}
+
+void test_adxl343_ring_stress_two_threads(){
+    static ADXL343Sample stress_storage [STRESS_CAPACITY];
+    static ADXL343Ring stress_ring;
+    pthread_t producer;
+    uint32_t expected = 0;
+    uint32_t mismatches = 0;
+    TEST_ASSERT_EQUAL(adxl343_ring_init(&stress_ring, stress_storage, STRESS_CAPACITY), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(pthread_create(&producer, NULL, stress_producer, &stress_ring), 0);
+    // Consumer on this thread, every sample must arrive exactly once and in order
+    while (expected < STRESS_SAMPLES){
+        const ADXL343Sample* span;
+        size_t length;
+        adxl343_ring_peek(&stress_ring, &span, &length);
+        if (length == 0){
+            sched_yield();
+            continue;
+        }
+        for (size_t n = 0; n < length; n++, expected++){
+            ADXL343Sample sample = sequence_sample(expected);
+            if (span[n].x != sample.x || span[n].y != sample.y || span[n].z != sample.z){
+                mismatches++;
+            }
+        }
+        adxl343_ring_consume(&stress_ring, length);
+    }
+    pthread_join(producer, NULL);
+    TEST_ASSERT_EQUAL(mismatches, 0);
+    TEST_ASSERT_EQUAL(expected, STRESS_SAMPLES);
+    TEST_ASSERT_EQUAL(adxl343_ring_size(&stress_ring), 0);
+}
+
+void tearDown(void){
+
+}
+
+int main(void){
+    UNITY_BEGIN();
+
+    RUN_TEST(test_adxl343_ring_init_error);
+    RUN_TEST(test_adxl343_ring_spans_wrap);
+    RUN_TEST(test_adxl343_ring_push_drops_when_full);
+    RUN_TEST(test_adxl343_ring_stress_two_threads);
+
+    return UNITY_END();
+}
@@ -0,0 +1,405 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  test_adxl343_sim.c
+/// \brief unittester running adxl343_driver against the simulated ADXL343
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "sim_i2c_bus.h"
+#include "sim_spi_bus.h"
+#include "sim_adxl343.h"
+#include "adxl343_driver.h"
+#include "adxl343_timeline.h"
+#include "unity.h"
+
+
+static SimADXL343 sim;
+static ADXL343Device device;
+
+
+void setUp(void){
+    sim_i2c_bus_reset();
+    sim_spi_bus_reset();
+    sim_adxl343_attach(&sim, ADXL343_ADDRESS_I2C);
+    sim_adxl343_set_acceleration(&sim, 0, -500, 1000);
+    adxl343_init(&device, NULL, ADXL343_ADDRESS_I2C);
+}
+
+// Helpers
+static void wait_samples(uint32_t samples){
+    sim_i2c_bus_advance_ns(samples * sim_adxl343_period_ns(&sim));
+    sim_adxl343_advance_to(&sim, sim_i2c_bus_now_ns());
+}
+
+static void ramp_source(void* context, uint64_t time_ns, int32_t mg[3]){
+    uint32_t* counter = context;
+    (void) time_ns;
+    // One LSB (3.9 mg) per sample
+    mg[0] = ((int32_t) (*counter)++ * 1000 + 128) / 256;
+    mg[1] = 0;
+    mg[2] = 0;
+}
+
+// Sample counter modulo 256 that also records when every sample was taken
+static uint64_t taken_ns [4096];
+static void clock_source(void* context, uint64_t time_ns, int32_t mg[3]){
+    uint32_t* counter = context;
+    taken_ns[*counter % 4096] = time_ns;
+    mg[0] = ((int32_t) ((*counter)++ % 256) * 1000 + 128) / 256;
+    mg[1] = 0;
+    mg[2] = 0;
+}
+
+static uint64_t bus_timestamp(void){
+    return sim_i2c_bus_now_ns();
+}
+
+// Test cases
+void test_adxl343_sim_registers(){
+    char value;
+    const char devid_frame [2] = {(char) (ADXL343_ADDRESS_I2C << 1), 0x00};
+    TEST_ASSERT_EQUAL(mock_i2c_write_read(devid_frame, 2, &value, 1, 10), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(SIM_ADXL343_DEVID, (uint8_t) value);
+    // Configuration written by init reached the model, read-only registers ignore writes
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_DEFAULT_RATE, sim.registers[ADXL343_REG_BW_RATE]);
+    const char write_frame [3] = {(char) (ADXL343_ADDRESS_I2C << 1), 0x00, 0x12};
+    TEST_ASSERT_EQUAL(mock_i2c_write(write_frame, 3, 10), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(mock_i2c_write_read(devid_frame, 2, &value, 1, 10), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(SIM_ADXL343_DEVID, (uint8_t) value);
+    // No samples until measurement mode
+    wait_samples(10);
+    TEST_ASSERT_EQUAL(sim.samples_generated, 0);
+}
+
+void test_adxl343_sim_odr_and_decode(){
+    ADXL343Sample samples [4];
+    size_t count = 0;
+    adxl343_start(&device);
+    // 100 Hz
+    TEST_ASSERT_EQUAL(sim_adxl343_period_ns(&sim), 10000000);
+    wait_samples(3);
+    TEST_ASSERT_EQUAL(sim.samples_generated, 3);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, samples, 4, &count), FUNCTION_STATUS_OK);
+    // Bypass mode only keeps the newest sample, 256 LSB/g at +-2g
+    TEST_ASSERT_EQUAL(count, 1);
+    TEST_ASSERT_EQUAL_INT16(0, samples[0].x);
+    TEST_ASSERT_EQUAL_INT16(-128, samples[0].y);
+    TEST_ASSERT_EQUAL_INT16(256, samples[0].z);
+    TEST_ASSERT_EQUAL(sim.samples_lost, 2);
+    // Left-justified full resolution +-16g decodes to the same 3.9 mg/LSB values
+    adxl343_set_range(&device, 0x03);
+    adxl343_set_resolution_full(&device);
+    adxl343_set_bit_order(&device, 0x01);
+    wait_samples(1);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, samples, 4, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, 1);
+    TEST_ASSERT_EQUAL_INT16(-128, samples[0].y);
+    TEST_ASSERT_EQUAL_INT16(256, samples[0].z);
+    // Fixed 10 bit resolution at +-16g is 32 LSB/g
+    adxl343_set_resolution_fixed(&device);
+    wait_samples(1);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, samples, 4, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_INT16(32, samples[0].z);
+}
+
+void test_adxl343_sim_fifo_modes(){
+    ADXL343Sample samples [SIM_ADXL343_FIFO_ENTRIES];
+    size_t count = 0;
+    uint8_t entries = 0;
+    uint32_t counter = 0;
+    sim_adxl343_set_source(&sim, ramp_source, &counter);
+    // FIFO mode stops collecting when full, the oldest samples are kept
+    adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_FIFO, 16, ADXL343_FIFO_TRIGGER_INT1);
+    adxl343_start(&device);
+    wait_samples(40);
+    TEST_ASSERT_EQUAL(adxl343_get_fifo_entries(&device, &entries), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(entries, SIM_ADXL343_FIFO_ENTRIES);
+    TEST_ASSERT_EQUAL_HEX8(sim_adxl343_int_source(&sim) & 0x83, 0x83);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, samples, SIM_ADXL343_FIFO_ENTRIES, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, SIM_ADXL343_FIFO_ENTRIES);
+    TEST_ASSERT_EQUAL_INT16(0, samples[0].x);
+    TEST_ASSERT_EQUAL_INT16(32, samples[32].x);
+    // Stream mode keeps the newest samples
+    adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_STREAM, 16, ADXL343_FIFO_TRIGGER_INT1);
+    counter = 0;
+    wait_samples(40);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, samples, SIM_ADXL343_FIFO_ENTRIES, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, SIM_ADXL343_FIFO_ENTRIES);
+    TEST_ASSERT_EQUAL_INT16(samples[32].x - 32, samples[0].x);
+    TEST_ASSERT_GREATER_OR_EQUAL(7, samples[0].x);
+    TEST_ASSERT_EQUAL_HEX8(sim_adxl343_int_source(&sim) & ADXL343_INT_OVERRUN, 0);
+}
+
+void test_adxl343_sim_trigger_mode(){
+    ADXL343Sample samples [SIM_ADXL343_FIFO_ENTRIES];
+    size_t count = 0;
+    uint32_t counter = 0;
+    sim_adxl343_set_source(&sim, ramp_source, &counter);
+    adxl343_set_interrupts(&device, ADXL343_INT_SINGLE_TAP, ADXL343_INT_SINGLE_TAP);
+    adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_TRIGGER, 8, ADXL343_FIFO_TRIGGER_INT2);
+    adxl343_start(&device);
+    wait_samples(50);
+    TEST_ASSERT_EQUAL(sim.triggered, 0);
+    // Event on the trigger pin keeps 8 samples of history and collects until full
+    sim_adxl343_raise_event(&sim, ADXL343_INT_SINGLE_TAP);
+    uint32_t trigger_sample = counter;
+    TEST_ASSERT_EQUAL(sim.entries, 8);
+    wait_samples(50);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, samples, SIM_ADXL343_FIFO_ENTRIES, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, SIM_ADXL343_FIFO_ENTRIES);
+    TEST_ASSERT_EQUAL_INT16(trigger_sample - 8, samples[0].x);
+    TEST_ASSERT_EQUAL_INT16(trigger_sample, samples[8].x);
+    // The event stays latched until INT_SOURCE is read
+    TEST_ASSERT_EQUAL_HEX8(sim_adxl343_int_source(&sim) & ADXL343_INT_SINGLE_TAP, ADXL343_INT_SINGLE_TAP);
+}
+
+void test_adxl343_sim_bus_time_and_log(){
+    char axes [6];
+    // Address, register, repeated start, read address and 6 data bytes: 9 bytes of 9 bits plus 3 conditions
+    uint64_t busy = sim_i2c_bus_time_ns();
+    TEST_ASSERT_EQUAL(adxl343_get_all_axes(&device, axes), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_time_ns() - busy, 84ull * 1000000000ull / 400000);
+    sim_i2c_bus_set_clock(100000);
+    busy = sim_i2c_bus_time_ns();
+    TEST_ASSERT_EQUAL(adxl343_get_all_axes(&device, axes), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_time_ns() - busy, 84ull * 1000000000ull / 100000);
+    const SimI2CLogEntry* entry = sim_i2c_bus_log(sim_i2c_bus_log_count() - 1);
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL(entry->type, SIM_I2C_BUS_WRITE_READ);
+    TEST_ASSERT_EQUAL_HEX8(entry->address, ADXL343_ADDRESS_I2C);
+    TEST_ASSERT_EQUAL_HEX8(entry->register_address, ADXL343_DATA_X_0);
+    TEST_ASSERT_EQUAL(entry->write_length, 1);
+    TEST_ASSERT_EQUAL(entry->read_length, 6);
+    TEST_ASSERT_EQUAL(entry->duration_ns, 840000);
+    // Init was logged as its 4 configuration bursts
+    entry = sim_i2c_bus_log(0);
+    TEST_ASSERT_EQUAL(entry->type, SIM_I2C_BUS_WRITE);
+    TEST_ASSERT_EQUAL_HEX8(entry->register_address, ADXL343_REG_CONFIG_START);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_log_count(), 6);
+    TEST_ASSERT_NULL(sim_i2c_bus_log(6));
+}
+
+void test_adxl343_sim_spi(){
+    static ADXL343AsyncOp op;
+    SimADXL343 spi_sim;
+    ADXL343Device spi_device;
+    ADXL343Sample samples [SIM_ADXL343_FIFO_ENTRIES];
+    size_t count = 0;
+    uint32_t counter = 0;
+    sim_adxl343_attach_spi(&spi_sim);
+    sim_adxl343_set_source(&spi_sim, ramp_source, &counter);
+    uint32_t i2c_transactions = sim_i2c_bus_transactions();
+    // Init writes the same 4 configuration bursts as on I2C, none of them reach the I2C bus
+    TEST_ASSERT_EQUAL(adxl343_init_spi(&spi_device, NULL), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_spi_bus_transactions(), 4);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), i2c_transactions);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_DEFAULT_RATE, spi_sim.registers[ADXL343_REG_BW_RATE]);
+    // Full FIFO in one chip select cycle per entry, command byte plus 6 data bytes
+    adxl343_set_rate(&spi_device, 0x0F);
+    adxl343_set_fifo_mode(&spi_device, ADXL343_FIFO_MODE_FIFO, 16, ADXL343_FIFO_TRIGGER_INT1);
+    adxl343_start(&spi_device);
+    sim_i2c_bus_advance_ns(40 * sim_adxl343_period_ns(&spi_sim));
+    uint32_t transactions = sim_spi_bus_transactions();
+    uint32_t bytes = sim_spi_bus_bytes();
+    uint64_t busy = sim_spi_bus_time_ns();
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&spi_device, samples, SIM_ADXL343_FIFO_ENTRIES, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, SIM_ADXL343_FIFO_ENTRIES);
+    TEST_ASSERT_EQUAL_INT16(0, samples[0].x);
+    TEST_ASSERT_EQUAL_INT16(32, samples[32].x);
+    TEST_ASSERT_EQUAL(sim_spi_bus_transactions() - transactions, 1 + SIM_ADXL343_FIFO_ENTRIES);
+    TEST_ASSERT_EQUAL(sim_spi_bus_bytes() - bytes, 2 + 7 * SIM_ADXL343_FIFO_ENTRIES);
+    // 11.2 us per entry at 5 MHz (210 us on I2C at 400 kHz), below the 312.5 us ODR period at 3200 Hz
+    TEST_ASSERT_EQUAL(sim_spi_bus_time_ns() - busy, (2 + 7 * SIM_ADXL343_FIFO_ENTRIES) * 1600);
+    // Single byte accesses go out without the MB bit
+    uint8_t entries = 0xFF;
+    TEST_ASSERT_EQUAL(adxl343_get_fifo_entries(&spi_device, &entries), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_spi_bus_bytes() - bytes, 4 + 7 * SIM_ADXL343_FIFO_ENTRIES);
+    // Errors are passed on, asynchronous operations need the I2C transaction queue
+    sim_spi_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&spi_device, samples, 4, &count), FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(adxl343_drain_fifo_async(&spi_device, &op, samples, 4, NULL, NULL), FUNCTION_STATUS_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_init_spi(NULL, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_sim_calibrate_offsets(){
+    ADXL343Sample samples [4];
+    size_t count = 0;
+    int8_t offsets [3] = {0, 0, 0};
+    const int32_t expected [3] = {0, -500, 1000};
+    // Biased at rest by 47, -30 and 60 mg, the model adds OFSX/Y/Z in 15.6 mg steps
+    sim_adxl343_set_acceleration(&sim, 47, -530, 1060);
+    TEST_ASSERT_EQUAL(adxl343_calibrate_offsets(&device, expected, 64), FUNCTION_STATUS_OK);
+    TEST_ASSERT_GREATER_OR_EQUAL(64, sim.samples_generated);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t) -3, sim.registers[ADXL343_REG_OFSX]);
+    TEST_ASSERT_EQUAL_HEX8(2, sim.registers[ADXL343_REG_OFSY]);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t) -4, sim.registers[ADXL343_REG_OFSZ]);
+    TEST_ASSERT_EQUAL(adxl343_get_offsets(&device, offsets), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(offsets[0], -3);
+    TEST_ASSERT_EQUAL(offsets[1], 2);
+    TEST_ASSERT_EQUAL(offsets[2], -4);
+    // The previous configuration is back, standby and bypass
+    TEST_ASSERT_EQUAL_HEX8(0x00, sim.registers[ADXL343_REG_POWER_CTL] & 0x08);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_FIFO_MODE_BYPASS, sim.registers[ADXL343_REG_FIFO_CTL] >> 6);
+    // Samples taken afterwards are corrected on the device, within one LSB
+    adxl343_start(&device);
+    wait_samples(2);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, samples, 4, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(count, 1);
+    TEST_ASSERT_INT_WITHIN(1, 0, samples[0].x);
+    TEST_ASSERT_INT_WITHIN(1, -128, samples[0].y);
+    TEST_ASSERT_INT_WITHIN(1, 256, samples[0].z);
+    // Saved offsets restore in one 3 byte burst, or not at all if the device already holds them
+    const int8_t saved [3] = {5, -6, 7};
+    uint32_t transactions = sim_i2c_bus_transactions();
+    uint32_t bytes = sim_i2c_bus_bytes();
+    TEST_ASSERT_EQUAL(adxl343_set_offsets(&device, saved), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions() - transactions, 1);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_bytes() - bytes, 5);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t) -6, sim.registers[ADXL343_REG_OFSY]);
+    TEST_ASSERT_EQUAL(device.settings.offset[2], 7);
+    TEST_ASSERT_EQUAL(adxl343_set_offsets(&device, saved), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions() - transactions, 1);
+    TEST_ASSERT_EQUAL(adxl343_calibrate_offsets(&device, expected, 0), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_calibrate_offsets(&device, NULL, 64), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_set_offsets(NULL, saved), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_get_offsets(&device, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void test_adxl343_sim_calibrate_low_rate(){
+    const int32_t expected [3] = {0, -500, 1000};
+    // At 6.25 Hz the 16 samples take 2.5 s, far longer than a fixed number of status reads
+    sim_adxl343_set_acceleration(&sim, 47, -530, 1060);
+    TEST_ASSERT_EQUAL(adxl343_set_rate(&device, 0x06), FUNCTION_STATUS_OK);
+    uint64_t start = sim_i2c_bus_now_ns();
+    adxl343_set_timestamp_source(bus_timestamp);
+    TEST_ASSERT_EQUAL(adxl343_calibrate_offsets(&device, expected, 16), FUNCTION_STATUS_OK);
+    TEST_ASSERT_GREATER_OR_EQUAL(16 * sim_adxl343_period_ns(&sim), sim_i2c_bus_now_ns() - start);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t) -3, sim.registers[ADXL343_REG_OFSX]);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t) -4, sim.registers[ADXL343_REG_OFSZ]);
+    // Without a clock the status reads are counted
+    adxl343_set_timestamp_source(NULL);
+    TEST_ASSERT_EQUAL(adxl343_calibrate_offsets(&device, expected, 16), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t) -3, sim.registers[ADXL343_REG_OFSX]);
+    // A FIFO that never fills gives up once the samples are overdue, 16 + 2 + 4 periods of 160 ms
+    sim_i2c_bus_attach(ADXL343_ADDRESS_I2C, NULL, NULL);
+    sim_i2c_bus_set_device_register(ADXL343_ADDRESS_I2C, ADXL343_REG_BW_RATE, 0x06);
+    adxl343_invalidate_shadow(&device);
+    adxl343_set_timestamp_source(bus_timestamp);
+    start = sim_i2c_bus_now_ns();
+    TEST_ASSERT_EQUAL(adxl343_calibrate_offsets(&device, expected, 16), FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_GREATER_THAN(22 * 160000000ull, sim_i2c_bus_now_ns() - start);
+    TEST_ASSERT_LESS_THAN(23 * 160000000ull, sim_i2c_bus_now_ns() - start);
+    adxl343_set_timestamp_source(NULL);
+}
+
+void test_adxl343_sim_capture(){
+    static ADXL343Capture capture;
+    uint32_t counter = 0;
+    const ADXL343CaptureConfig config = {8, ADXL343_INT_ACTIVITY, ADXL343_FIFO_TRIGGER_INT1};
+    sim_adxl343_set_source(&sim, ramp_source, &counter);
+    adxl343_set_timestamp_source(bus_timestamp);
+    TEST_ASSERT_EQUAL(adxl343_poll_capture(&device, &capture), FUNCTION_STATUS_NOT_INITIALIZED);
+    TEST_ASSERT_EQUAL(adxl343_arm_capture(&device, &capture, &config), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8((ADXL343_FIFO_MODE_TRIGGER << 6) | 8, sim.registers[ADXL343_REG_FIFO_CTL]);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_INT_ACTIVITY, sim.registers[ADXL343_REG_INT_ENABLE]);
+    adxl343_start(&device);
+    // No bus traffic while armed
+    wait_samples(50);
+    uint32_t transactions = sim_i2c_bus_transactions();
+    TEST_ASSERT_EQUAL(adxl343_poll_capture(&device, &capture), FUNCTION_STATUS_PENDING);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), transactions);
+    // The trigger is stamped by the interrupt handler, the window completes 25 samples later
+    sim_adxl343_raise_event(&sim, ADXL343_INT_ACTIVITY);
+    uint32_t trigger_sample = counter;
+    uint64_t trigger_ns = sim_i2c_bus_now_ns();
+    TEST_ASSERT_EQUAL(adxl343_on_interrupt(&device), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(capture.state, ADXL343_CAPTURE_TRIGGERED);
+    TEST_ASSERT_EQUAL_HEX8(ADXL343_INT_ACTIVITY, capture.source);
+    TEST_ASSERT_GREATER_OR_EQUAL(trigger_ns, capture.trigger_time);
+    TEST_ASSERT_EQUAL(adxl343_poll_capture(&device, &capture), FUNCTION_STATUS_PENDING);
+    wait_samples(ADXL343_CAPTURE_WINDOW - 8);
+    TEST_ASSERT_EQUAL(adxl343_poll_capture(&device, &capture), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(capture.count, ADXL343_CAPTURE_WINDOW);
+    TEST_ASSERT_EQUAL(capture.pre_trigger, 8);
+    TEST_ASSERT_EQUAL(capture.period_ns, 10000000);
+    // One contiguous window around the trigger
+    TEST_ASSERT_EQUAL_INT16(trigger_sample - 8, capture.samples[0].x);
+    TEST_ASSERT_EQUAL_INT16(trigger_sample, capture.samples[8].x);
+    TEST_ASSERT_EQUAL_INT16(trigger_sample + 24, capture.samples[32].x);
+    TEST_ASSERT_EQUAL(adxl343_poll_capture(&device, &capture), FUNCTION_STATUS_OK);
+    TEST_ASSERT_NULL(device.capture);
+    // Re-arming empties the FIFO
+    TEST_ASSERT_EQUAL(adxl343_arm_capture(&device, &capture, &config), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(sim.entries, 0);
+    TEST_ASSERT_EQUAL(capture.state, ADXL343_CAPTURE_ARMED);
+    TEST_ASSERT_EQUAL(adxl343_arm_capture(&device, NULL, NULL), FUNCTION_STATUS_OK);
+    TEST_ASSERT_NULL(device.capture);
+    const ADXL343CaptureConfig no_history = {0, ADXL343_INT_ACTIVITY, ADXL343_FIFO_TRIGGER_INT1};
+    const ADXL343CaptureConfig not_an_event = {8, ADXL343_INT_WATERMARK, ADXL343_FIFO_TRIGGER_INT1};
+    TEST_ASSERT_EQUAL(adxl343_arm_capture(&device, &capture, &no_history), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_arm_capture(&device, &capture, &not_an_event), FUNCTION_STATUS_BOUNDARY_ERROR);
+    adxl343_set_timestamp_source(NULL);
+}
+
+void test_adxl343_sim_read_fifo_timestamped(){
+    static ADXL343Timeline timeline;
+    ADXL343Sample samples [ADXL343_FIFO_SIZE];
+    uint64_t timestamps [ADXL343_FIFO_SIZE];
+    uint32_t counter = 0;
+    size_t count;
+    sim_adxl343_set_source(&sim, clock_source, &counter);
+    adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_STREAM, 0, ADXL343_FIFO_TRIGGER_INT1);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo_timestamped(&device, &timeline, samples, timestamps, ADXL343_FIFO_SIZE, &count),
+                      FUNCTION_STATUS_NOT_INITIALIZED);
+    adxl343_set_timestamp_source(bus_timestamp);
+    adxl343_start(&device);
+    // Drains about every 20 samples at a varying phase to the sample clock
+    uint64_t worst = 0;
+    uint32_t expected = 0;
+    for (int drain = 0; drain < 150; drain++){
+        wait_samples(20);
+        sim_i2c_bus_advance_ns((uint64_t) (drain * 7 % 10) * sim_adxl343_period_ns(&sim) / 10);
+        size_t max = (drain % 3 == 0) ? 16 : ADXL343_FIFO_SIZE;
+        TEST_ASSERT_EQUAL(adxl343_read_fifo_timestamped(&device, &timeline, samples, timestamps, max, &count),
+                          FUNCTION_STATUS_OK);
+        TEST_ASSERT_EQUAL(timeline.rate, ADXL343_RATE_100HZ);
+        for (size_t i = 0; i < count; i++, expected++){
+            // Entries beyond max stay in the FIFO and continue the timeline in the next drain
+            TEST_ASSERT_EQUAL_INT16(expected % 256, samples[i].x);
+            uint64_t error = (timestamps[i] > taken_ns[expected % 4096]) ? timestamps[i] - taken_ns[expected % 4096]
+                                                                         : taken_ns[expected % 4096] - timestamps[i];
+            if (drain >= 50 && error > worst){
+                worst = error;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(timeline.resyncs, 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(worst, 3000000);
+    // A rate change restarts the timeline at the new period
+    adxl343_set_rate(&device, ADXL343_RATE_800HZ);
+    wait_samples(8);
+    TEST_ASSERT_EQUAL(adxl343_read_fifo_timestamped(&device, &timeline, samples, timestamps, ADXL343_FIFO_SIZE, &count),
+                      FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(timeline.rate, ADXL343_RATE_800HZ);
+    TEST_ASSERT_EQUAL(timestamps[count - 1] - timestamps[count - 2], 1250000);
+    adxl343_set_timestamp_source(NULL);
+}
+
+void tearDown(void){
+
+}
+
+int main(void){
+    UNITY_BEGIN();
+
+    RUN_TEST(test_adxl343_sim_registers);
+    RUN_TEST(test_adxl343_sim_odr_and_decode);
+    RUN_TEST(test_adxl343_sim_fifo_modes);
+    RUN_TEST(test_adxl343_sim_trigger_mode);
+    RUN_TEST(test_adxl343_sim_bus_time_and_log);
+    RUN_TEST(test_adxl343_sim_spi);
+    RUN_TEST(test_adxl343_sim_calibrate_offsets);
+    RUN_TEST(test_adxl343_sim_calibrate_low_rate);
+    RUN_TEST(test_adxl343_sim_capture);
+    RUN_TEST(test_adxl343_sim_read_fifo_timestamped);
+
+    return UNITY_END();
+}
@@ -0,0 +1,149 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  test_adxl343_timeline.c
+/// \brief unittester for adxl343_timeline
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "adxl343_timeline.h"
+#include "unity.h"
+
+
+#define SENSOR_RATE 0x0A                        // 100 Hz, 10 ms nominal period
+#define SENSOR_PERIOD_NS 9950000ULL             // Sensor oscillator 0.5 % fast
+#define SENSOR_START_NS 1000000000000ULL        // First sample at 1000 s host uptime
+#define DRAIN_INTERVAL_NS 250000000ULL          // Host drains about every 250 ms
+#define DRAIN_JITTER_NS 40000000ULL             // +- 20 ms scheduling jitter on the drain
+#define LATENCY_JITTER_NS 200000ULL             // Up to 200 us between the entry count and the clock reading
+#define FIFO_SIZE 32                            // Stream mode keeps the newest 32 samples
+
+static ADXL343Timeline timeline;
+static uint64_t timestamps [FIFO_SIZE];
+static uint32_t random_state;
+static uint64_t taken;                          // Samples taken by the simulated sensor, drained or lost
+static uint64_t drained;                        // Index of the next sample in the FIFO
+
+
+void setUp(void){
+    adxl343_timeline_init(&timeline, SENSOR_RATE);
+    random_state = 12345;
+    taken = 0;
+    drained = 0;
+}
+
+// Helpers
+static uint32_t next_random(uint32_t range){
+    random_state = random_state * 1103515245 + 12345;
+    return (random_state >> 8) % range;
+}
+
+static uint64_t true_time(uint64_t index){
+    return SENSOR_START_NS + index * SENSOR_PERIOD_NS;
+}
+
+// Drains the simulated FIFO at host time now, max entries at a time, and returns the worst stamp error in ns
+static uint64_t drain_at(uint64_t now, size_t max){
+    while (true_time(taken) <= now){
+        taken++;
+    }
+    if (taken - drained > FIFO_SIZE){
+        drained = taken - FIFO_SIZE;
+    }
+    size_t entries = (size_t) (taken - drained);
+    size_t count = (entries > max) ? max : entries;
+    uint64_t host_ns = now + next_random(LATENCY_JITTER_NS);
+    TEST_ASSERT_EQUAL(adxl343_timeline_stamp(&timeline, host_ns, entries, timestamps, count), FUNCTION_STATUS_OK);
+    uint64_t worst = 0;
+    for (size_t i = 0; i < count; i++){
+        uint64_t expected = true_time(drained + i);
+        uint64_t error = (timestamps[i] > expected) ? timestamps[i] - expected : expected - timestamps[i];
+        if (error > worst){
+            worst = error;
+        }
+    }
+    drained += count;
+    return worst;
+}
+
+// Test cases
+void test_adxl343_timeline_init_error(){
+    uint64_t stamp;
+    TEST_ASSERT_EQUAL(adxl343_timeline_init(NULL, SENSOR_RATE), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_timeline_init(&timeline, 0x10), FUNCTION_STATUS_BOUNDARY_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_timeline_stamp(NULL, 0, 1, &stamp, 1), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_timeline_stamp(&timeline, 0, 1, NULL, 1), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(adxl343_timeline_stamp(&timeline, 0, 1, &stamp, 2), FUNCTION_STATUS_ARGUMENT_ERROR);
+    ADXL343Timeline blank = {0};
+    TEST_ASSERT_EQUAL(adxl343_timeline_stamp(&blank, 0, 1, &stamp, 1), FUNCTION_STATUS_NOT_INITIALIZED);
+    TEST_ASSERT_EQUAL(adxl343_timeline_drift_ppm(&blank), 0);
+}
+
+void test_adxl343_timeline_first_batch_backdated(){
+    // 20 entries at the reading: the newest is stamped half a period before it, the others 10 ms apart
+    uint64_t now = 5000000000ULL;
+    TEST_ASSERT_EQUAL(adxl343_timeline_stamp(&timeline, now, 20, timestamps, 20), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(timestamps[19], now - 5000000);
+    TEST_ASSERT_EQUAL(timestamps[0], now - 5000000 - 19 * 10000000ULL);
+    for (size_t i = 1; i < 20; i++){
+        TEST_ASSERT_EQUAL(timestamps[i] - timestamps[i - 1], 10000000);
+    }
+    TEST_ASSERT_EQUAL(adxl343_timeline_drift_ppm(&timeline), 0);
+}
+
+void test_adxl343_timeline_tracks_drift(){
+    // About 500 s of drains with scheduling and latency jitter, sometimes leaving entries for the next drain
+    uint64_t now = SENSOR_START_NS;
+    uint64_t worst = 0;
+    for (int drain = 0; drain < 2000; drain++){
+        now += DRAIN_INTERVAL_NS - DRAIN_JITTER_NS / 2 + next_random(DRAIN_JITTER_NS);
+        uint64_t error = drain_at(now, (drain % 7 == 0) ? 24 : FIFO_SIZE);
+        if (drain >= 200 && error > worst){
+            worst = error;
+        }
+    }
+    // Sensor runs 5000 ppm fast, its period is 5000 ppm short
+    TEST_ASSERT_INT_WITHIN(100, -5000, adxl343_timeline_drift_ppm(&timeline));
+    TEST_ASSERT_EQUAL(timeline.resyncs, 0);
+    // Once settled every stamp is well within a period of when the sample was taken
+    TEST_ASSERT_GREATER_OR_EQUAL(worst, 3000000);
+    // Stamps within a batch are evenly spaced at the estimated period
+    uint64_t period = timeline.period_q16 >> 16;
+    TEST_ASSERT_INT_WITHIN(1, period, timestamps[1] - timestamps[0]);
+}
+
+void test_adxl343_timeline_resync_after_gap(){
+    uint64_t now = SENSOR_START_NS;
+    for (int drain = 0; drain < 400; drain++){
+        now += DRAIN_INTERVAL_NS - DRAIN_JITTER_NS / 2 + next_random(DRAIN_JITTER_NS);
+        drain_at(now, FIFO_SIZE);
+    }
+    int32_t drift = adxl343_timeline_drift_ppm(&timeline);
+    // The host stalls for 2 s, the FIFO overflows and the oldest samples are lost
+    now += 2000000000ULL;
+    drain_at(now, FIFO_SIZE);
+    TEST_ASSERT_EQUAL(timeline.resyncs, 1);
+    // The drift estimate survives the gap and the stamps line up again within a few drains
+    TEST_ASSERT_EQUAL(adxl343_timeline_drift_ppm(&timeline), drift);
+    uint64_t worst = 0;
+    for (int drain = 0; drain < 100; drain++){
+        now += DRAIN_INTERVAL_NS - DRAIN_JITTER_NS / 2 + next_random(DRAIN_JITTER_NS);
+        uint64_t error = drain_at(now, FIFO_SIZE);
+        if (drain >= 30 && error > worst){
+            worst = error;
+        }
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(worst, 3000000);
+}
+
+void tearDown(void){
+
+}
+
+int main(void){
+    UNITY_BEGIN();
+
+    RUN_TEST(test_adxl343_timeline_init_error);
+    RUN_TEST(test_adxl343_timeline_first_batch_backdated);
+    RUN_TEST(test_adxl343_timeline_tracks_drift);
+    RUN_TEST(test_adxl343_timeline_resync_after_gap);
+
+    return UNITY_END();
+}
@@ -0,0 +1,106 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  test_i2c_backend.c
+/// \brief unittester for the i2c_driver backend selection and the Linux i2c-dev backend
+// --------------------------------------------------------------------------------------------------------------------
+
+// The real i2c_driver entry points are under test here, not the mocks the simulator header maps them to, so they are
+// declared before it is included and its mapping is undone afterwards
+#include "i2c_driver.h"
+#include "sim_i2c_bus.h"
+#include "sim_i2c_backend.h"
+#include "sim_adxl343.h"
+#include "adxl343_driver.h"
+#include "i2c_linux.h"
+#include "unity.h"
+
+#undef i2c_write
+#undef i2c_read
+#undef i2c_write_read
+
+
+static SimI2CBackendCalls calls;
+static I2CBackend backend;
+
+
+void setUp(void){
+    sim_i2c_bus_reset();
+    calls = (SimI2CBackendCalls) {0};
+    backend = sim_i2c_backend(&calls);
+    i2c_set_backend(&backend);
+}
+
+// Test cases
+void test_i2c_backend_forwarding(){
+    char value = 0;
+    const char select [2] = {(char) (0x53 << 1), 0x2C};
+    const char write [3] = {(char) (0x53 << 1), 0x2C, 0x0D};
+    TEST_ASSERT_EQUAL(i2c_write(write, sizeof(write), 10), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(i2c_write(select, sizeof(select), 10), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(i2c_read(&value, 1, 10), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x0D, (uint8_t) value);
+    value = 0;
+    TEST_ASSERT_EQUAL(i2c_write_read(select, sizeof(select), &value, 1, 10), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL_HEX8(0x0D, (uint8_t) value);
+    TEST_ASSERT_EQUAL(calls.writes, 2);
+    TEST_ASSERT_EQUAL(calls.reads, 1);
+    TEST_ASSERT_EQUAL(calls.write_reads, 1);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), 4);
+    // Errors come back unchanged, argument checks stay in front of the backend
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(i2c_write_read(select, sizeof(select), &value, 1, 10), FUNCTION_STATUS_TIMEOUT);
+    TEST_ASSERT_EQUAL(i2c_write(NULL, 2, 10), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(calls.writes, 2);
+    // Built-in implementation again without a backend
+    i2c_set_backend(NULL);
+    TEST_ASSERT_EQUAL(i2c_write(write, sizeof(write), 10), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(calls.writes, 2);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), 5);
+}
+
+void test_i2c_backend_driver(){
+    static SimADXL343 sim;
+    ADXL343Device device;
+    ADXL343Sample samples [SIM_ADXL343_FIFO_ENTRIES];
+    size_t count = 0;
+    // The default binding runs on the i2c_driver entry points, and from there on the selected backend
+    sim_adxl343_attach(&sim, ADXL343_ADDRESS_I2C);
+    sim_adxl343_set_acceleration(&sim, 0, -500, 1000);
+    const ADXL343Bus bus = {i2c_write, i2c_read, i2c_write_read, NULL};
+    TEST_ASSERT_EQUAL(adxl343_init(&device, &bus, ADXL343_ADDRESS_I2C), FUNCTION_STATUS_OK);
+    TEST_ASSERT_EQUAL(calls.writes, 4);
+    adxl343_set_fifo_mode(&device, ADXL343_FIFO_MODE_STREAM, 16, ADXL343_FIFO_TRIGGER_INT1);
+    adxl343_start(&device);
+    sim_i2c_bus_advance_ns(10 * sim_adxl343_period_ns(&sim));
+    TEST_ASSERT_EQUAL(adxl343_read_fifo(&device, samples, SIM_ADXL343_FIFO_ENTRIES, &count), FUNCTION_STATUS_OK);
+    TEST_ASSERT_GREATER_OR_EQUAL(9, count);
+    TEST_ASSERT_EQUAL_INT16(-128, samples[0].y);
+    TEST_ASSERT_EQUAL_INT16(256, samples[0].z);
+    // One combined write-read per FIFO entry plus the status read
+    TEST_ASSERT_EQUAL(calls.write_reads, count + 1);
+    TEST_ASSERT_EQUAL(calls.reads, 0);
+}
+
+void test_i2c_linux_open_error(){
+    I2CLinuxAdapter adapter;
+    // No adapter in the test environment, opening fails cleanly and leaves the adapter closed
+    TEST_ASSERT_EQUAL(i2c_linux_open(&adapter, "/dev/i2c-does-not-exist"), FUNCTION_STATUS_ERROR);
+    TEST_ASSERT_EQUAL(adapter.fd, -1);
+    TEST_ASSERT_EQUAL_PTR(adapter.backend.context, &adapter);
+    i2c_linux_close(&adapter);
+    TEST_ASSERT_EQUAL(i2c_linux_open(NULL, "/dev/i2c-1"), FUNCTION_STATUS_ARGUMENT_ERROR);
+    TEST_ASSERT_EQUAL(i2c_linux_open(&adapter, NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+}
+
+void tearDown(void){
+    i2c_set_backend(NULL);
+}
+
+int main(void){
+    UNITY_BEGIN();
+
+    RUN_TEST(test_i2c_backend_forwarding);
+    RUN_TEST(test_i2c_backend_driver);
+    RUN_TEST(test_i2c_linux_open_error);
+
+    return UNITY_END();
+}
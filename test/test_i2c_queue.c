@@ -0,0 +1,142 @@
+// --------------------------------------------------------------------------------------------------------------------
+/// \file  test_i2c_queue.c
+/// \brief unittester for the i2c transaction queue
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "sim_i2c_bus.h"
+#include "sim_i2c_worker.h"
+#include "i2c_driver.h"
+#include "unity.h"
+
+#include <sched.h>
+
+
+#define WORKER_TRANSACTIONS 10000               // Transactions pushed through the worker thread
+
+static I2CTransaction* completion_order [I2C_QUEUE_DEPTH];
+static uint32_t completions;
+
+
+void setUp(void){
+    sim_i2c_bus_reset();
+    i2c_process();
+    i2c_poll();
+    completions = 0;
+}
+
+// Helpers
+static void record_completion(I2CTransaction* transaction, void* context){
+    TEST_ASSERT_EQUAL_PTR(context, &completions);
+    if (completions < I2C_QUEUE_DEPTH){
+        completion_order[completions] = transaction;
+    }
+    completions++;
+}
+
+static void make_transaction(I2CTransaction* transaction, uint8_t type, const char* write, size_t write_length,
+                             char* read, size_t read_length){
+    transaction->type = type;
+    transaction->dataToWrite = write;
+    transaction->writeLength = write_length;
+    transaction->dataToRead = read;
+    transaction->readLength = read_length;
+    transaction->timeout = 10;
+    transaction->callback = record_completion;
+    transaction->context = &completions;
+}
+
+// Test cases
+void test_i2c_queue_submit_process_poll(){
+    const char write [3] = {(char) (0x53 << 1), 0x1E, 0x42};
+    const char select [2] = {(char) (0x53 << 1), 0x1E};
+    char read_back [1] = {0};
+    char read_again [1] = {0};
+    I2CTransaction transactions [3];
+    make_transaction(&transactions[0], I2C_TRANSACTION_WRITE, write, 3, NULL, 0);
+    make_transaction(&transactions[1], I2C_TRANSACTION_WRITE_READ, select, 2, read_back, 1);
+    make_transaction(&transactions[2], I2C_TRANSACTION_READ, NULL, 0, read_again, 1);
+    for (int i = 0; i < 3; i++){
+        TEST_ASSERT_EQUAL(i2c_submit(&transactions[i]), FUNCTION_STATUS_OK);
+        TEST_ASSERT_EQUAL(transactions[i].status, FUNCTION_STATUS_PENDING);
+    }
+    // Nothing touches the bus or completes until the queue is processed and polled
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), 0);
+    TEST_ASSERT_EQUAL(i2c_poll(), 0);
+    TEST_ASSERT_EQUAL(i2c_process(), 3);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), 3);
+    TEST_ASSERT_EQUAL(completions, 0);
+    TEST_ASSERT_EQUAL(i2c_poll(), 3);
+    TEST_ASSERT_EQUAL(completions, 3);
+    for (int i = 0; i < 3; i++){
+        TEST_ASSERT_EQUAL_PTR(completion_order[i], &transactions[i]);
+        TEST_ASSERT_EQUAL(transactions[i].status, FUNCTION_STATUS_OK);
+    }
+    TEST_ASSERT_EQUAL_HEX8(sim_i2c_bus_get_register(0x1E), 0x42);
+    TEST_ASSERT_EQUAL_HEX8(read_back[0], 0x42);
+    TEST_ASSERT_EQUAL_HEX8(read_again[0], 0x00);
+}
+
+void test_i2c_queue_submit_error(){
+    static I2CTransaction transactions [I2C_QUEUE_DEPTH + 1];
+    const char select [2] = {(char) (0x53 << 1), 0x00};
+    char read [1];
+    TEST_ASSERT_EQUAL(i2c_submit(NULL), FUNCTION_STATUS_ARGUMENT_ERROR);
+    make_transaction(&transactions[0], 0x07, select, 2, read, 1);
+    TEST_ASSERT_EQUAL(i2c_submit(&transactions[0]), FUNCTION_STATUS_ARGUMENT_ERROR);
+    // Processed but not yet polled transactions still take up room
+    for (int i = 0; i < I2C_QUEUE_DEPTH; i++){
+        make_transaction(&transactions[i], I2C_TRANSACTION_WRITE_READ, select, 2, read, 1);
+        TEST_ASSERT_EQUAL(i2c_submit(&transactions[i]), FUNCTION_STATUS_OK);
+    }
+    i2c_process();
+    make_transaction(&transactions[I2C_QUEUE_DEPTH], I2C_TRANSACTION_WRITE_READ, select, 2, read, 1);
+    TEST_ASSERT_EQUAL(i2c_submit(&transactions[I2C_QUEUE_DEPTH]), FUNCTION_STATUS_BUSY);
+    TEST_ASSERT_EQUAL(i2c_poll(), I2C_QUEUE_DEPTH);
+    TEST_ASSERT_EQUAL(i2c_submit(&transactions[I2C_QUEUE_DEPTH]), FUNCTION_STATUS_OK);
+    // Bus errors are reported through the status of the transaction
+    sim_i2c_bus_fail_next(1, FUNCTION_STATUS_TIMEOUT);
+    i2c_process();
+    TEST_ASSERT_EQUAL(i2c_poll(), 1);
+    TEST_ASSERT_EQUAL(transactions[I2C_QUEUE_DEPTH].status, FUNCTION_STATUS_TIMEOUT);
+}
+
+void test_i2c_queue_worker_thread(){
+    static I2CTransaction transactions [I2C_QUEUE_DEPTH];
+    const char select [2] = {(char) (0x53 << 1), 0x00};
+    char read [I2C_QUEUE_DEPTH];
+    uint32_t submitted = 0;
+    uint32_t failures = 0;
+    TEST_ASSERT_EQUAL(sim_i2c_worker_start(), 0);
+    // Keep the queue full, a completed slot is reused as soon as its callback has run
+    while (completions < WORKER_TRANSACTIONS){
+        while (submitted < WORKER_TRANSACTIONS && submitted - completions < I2C_QUEUE_DEPTH){
+            I2CTransaction* transaction = &transactions[submitted % I2C_QUEUE_DEPTH];
+            make_transaction(transaction, I2C_TRANSACTION_WRITE_READ, select, 2, &read[submitted % I2C_QUEUE_DEPTH], 1);
+            if (i2c_submit(transaction) != FUNCTION_STATUS_OK){
+                failures++;
+            }
+            submitted++;
+        }
+        if (i2c_poll() == 0){
+            sched_yield();
+        }
+    }
+    sim_i2c_worker_stop();
+    TEST_ASSERT_EQUAL(failures, 0);
+    TEST_ASSERT_EQUAL(sim_i2c_worker_processed(), WORKER_TRANSACTIONS);
+    TEST_ASSERT_EQUAL(sim_i2c_bus_transactions(), WORKER_TRANSACTIONS);
+}
+
+void tearDown(void){
+
+}
+
+int main(void){
+    UNITY_BEGIN();
+
+    RUN_TEST(test_i2c_queue_submit_process_poll);
+    RUN_TEST(test_i2c_queue_submit_error);
+    RUN_TEST(test_i2c_queue_worker_thread);
+
+    return UNITY_END();
+}